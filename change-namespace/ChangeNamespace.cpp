@@ -16,8 +16,33 @@ using namespace clang::ast_matchers;
 namespace clang {
 namespace change_namespace {
 
+bool FilePatternMatcher::matchesExpansionLoc(const SourceManager &SM,
+                                             SourceLocation Loc) {
+  SourceLocation ExpansionLoc = SM.getExpansionLoc(Loc);
+  if (ExpansionLoc.isInvalid())
+    return false;
+  FileID FID = SM.getFileID(ExpansionLoc);
+  auto Cached = FileIDMatches.find(FID);
+  if (Cached != FileIDMatches.end())
+    return Cached->second;
+  const FileEntry *Entry = SM.getFileEntryForID(FID);
+  bool Matches = Entry && PatternRE.match(Entry->getName());
+  FileIDMatches[FID] = Matches;
+  return Matches;
+}
+
 namespace {
 
+// Same as `isExpansionInFileMatching`, but matches against the precompiled
+// pattern in `Matcher` and reuses the result for nodes in the same file
+// instead of compiling a new regex for each node.
+AST_POLYMORPHIC_MATCHER_P(isExpansionInFilePattern,
+                          AST_POLYMORPHIC_SUPPORTED_TYPES(Decl, Stmt, TypeLoc),
+                          FilePatternMatcher *, Matcher) {
+  return Matcher->matchesExpansionLoc(
+      Finder->getASTContext().getSourceManager(), Node.getLocStart());
+}
+
 inline std::string
 joinNamespaces(const llvm::SmallVectorImpl<StringRef> &Namespaces) {
   if (Namespaces.empty())
@@ -321,30 +346,27 @@ void ChangeNamespaceTool::registerMatchers(ast_matchers::MatchFinder *Finder) {
     Prefix = (StringRef(FullOldNs).drop_back(DiffOldNamespace.size()) +
               DiffOldNsSplitted.front())
                  .str();
+  auto IsInFilePattern = isExpansionInFilePattern(&FilePatternRE);
   auto IsInMovedNs =
       allOf(hasAncestor(namespaceDecl(hasName(FullOldNs)).bind("ns_decl")),
-            isExpansionInFileMatching(FilePattern));
+            IsInFilePattern);
   auto IsVisibleInNewNs = anyOf(
       IsInMovedNs, unless(hasAncestor(namespaceDecl(hasName(Prefix)))));
   // Match using declarations.
   Finder->addMatcher(
-      usingDecl(isExpansionInFileMatching(FilePattern), IsVisibleInNewNs)
-          .bind("using"),
-      this);
+      usingDecl(IsInFilePattern, IsVisibleInNewNs).bind("using"), this);
   // Match using namespace declarations.
-  Finder->addMatcher(usingDirectiveDecl(isExpansionInFileMatching(FilePattern),
-                                        IsVisibleInNewNs)
+  Finder->addMatcher(usingDirectiveDecl(IsInFilePattern, IsVisibleInNewNs)
                          .bind("using_namespace"),
                      this);
   // Match namespace alias declarations.
-  Finder->addMatcher(namespaceAliasDecl(isExpansionInFileMatching(FilePattern),
-                                        IsVisibleInNewNs)
+  Finder->addMatcher(namespaceAliasDecl(IsInFilePattern, IsVisibleInNewNs)
                          .bind("namespace_alias"),
                      this);
 
   // Match old namespace blocks.
   Finder->addMatcher(
-      namespaceDecl(hasName(FullOldNs), isExpansionInFileMatching(FilePattern))
+      namespaceDecl(hasName(FullOldNs), IsInFilePattern)
           .bind("old_ns"),
       this);
 
@@ -801,11 +823,8 @@ void ChangeNamespaceTool::fixTypeLoc(
     if (!llvm::StringRef(D->getQualifiedNameAsString())
              .startswith(OldNamespace + "::"))
       return false;
-    auto ExpansionLoc = Result.SourceManager->getExpansionLoc(D->getLocStart());
-    if (ExpansionLoc.isInvalid())
-      return false;
-    llvm::StringRef Filename = Result.SourceManager->getFilename(ExpansionLoc);
-    return FilePatternRE.match(Filename);
+    return FilePatternRE.matchesExpansionLoc(*Result.SourceManager,
+                                             D->getLocStart());
   };
   // Make `FromDecl` the immediate declaration that `Type` refers to, i.e. if
   // `Type` is an alias type, we make `FromDecl` the type alias declaration.
@@ -929,8 +948,35 @@ void ChangeNamespaceTool::onEndOfTranslationUnit() {
   // Make sure we don't generate replacements for files that do not match
   // FilePattern.
   for (auto &Entry : FileToReplacements)
-    if (!FilePatternRE.match(Entry.first))
+    if (!FilePatternRE.matchesFile(Entry.first))
       Entry.second.clear();
+
+  // `FileID`s are not valid across translation units.
+  FilePatternRE.reset();
+}
+
+llvm::Error mergeTranslationUnitReplacements(
+    const std::map<std::string, tooling::Replacements> &TUFileToReplacements,
+    std::map<std::string, tooling::Replacements> *FileToReplacements) {
+  for (const auto &Entry : TUFileToReplacements) {
+    if (Entry.second.empty())
+      continue;
+    auto Inserted = FileToReplacements->insert(Entry);
+    if (Inserted.second)
+      continue;
+    tooling::Replacements &Replaces = Inserted.first->second;
+    // The common case: another translation unit has already made exactly the
+    // same edits to this file.
+    if (Replaces == Entry.second)
+      continue;
+    for (const auto &R : Entry.second) {
+      if (llvm::is_contained(Replaces, R))
+        continue;
+      if (auto Err = Replaces.add(R))
+        return Err;
+    }
+  }
+  return llvm::Error::success();
 }
 
 } // namespace change_namespace
@@ -13,12 +13,38 @@
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Format/Format.h"
 #include "clang/Tooling/Core/Replacement.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Regex.h"
 #include <string>
 
 namespace clang {
 namespace change_namespace {
 
+// Matches files against a regex pattern and memoizes the result per `FileID`,
+// so that each file in a translation unit is matched against the pattern at
+// most once. Since `FileID`s are only meaningful within one `SourceManager`,
+// `reset` must be called at the end of each translation unit.
+class FilePatternMatcher {
+public:
+  explicit FilePatternMatcher(llvm::StringRef Pattern) : PatternRE(Pattern) {}
+
+  // Returns true if `FilePath` matches the pattern.
+  bool matchesFile(llvm::StringRef FilePath) {
+    return PatternRE.match(FilePath);
+  }
+
+  // Returns true if the expansion location of `Loc` is in a file whose name
+  // matches the pattern.
+  bool matchesExpansionLoc(const SourceManager &SM, SourceLocation Loc);
+
+  // Forgets all memoized results.
+  void reset() { FileIDMatches.clear(); }
+
+private:
+  llvm::Regex PatternRE;
+  llvm::DenseMap<FileID, bool> FileIDMatches;
+};
+
 // This tool can be used to change the surrounding namespaces of class/function
 // definitions. Classes/functions in the moved namespace will have new
 // namespaces while references to symbols (e.g. types, functions) which are not
@@ -135,7 +161,9 @@ private:
   std::string DiffNewNamespace;
   // A regex pattern that matches files to be processed.
   std::string FilePattern;
-  llvm::Regex FilePatternRE;
+  // Matches files against `FilePattern`, memoized per `FileID` in the current
+  // translation unit.
+  FilePatternMatcher FilePatternRE;
   // Information about moved namespaces grouped by file.
   // Since we are modifying code in old namespaces (e.g. add namespace
   // spedifiers) as well as moving them, we store information about namespaces
@@ -166,6 +194,15 @@ private:
   llvm::SmallPtrSet<const clang::DeclRefExpr*, 16> ProcessedFuncRefs;
 };
 
+// Merges the replacements produced by running `ChangeNamespaceTool` on a
+// single translation unit, `TUFileToReplacements`, into `FileToReplacements`.
+// Headers included by several translation units receive identical edits from
+// each of them; such duplicates are added only once. Returns an error if a
+// replacement conflicts with one that is already in `FileToReplacements`.
+llvm::Error mergeTranslationUnitReplacements(
+    const std::map<std::string, tooling::Replacements> &TUFileToReplacements,
+    std::map<std::string, tooling::Replacements> *FileToReplacements);
+
 } // namespace change_namespace
 } // namespace clang
 
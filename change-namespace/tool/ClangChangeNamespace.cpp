@@ -37,8 +37,13 @@
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Refactoring.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include <thread>
 
 using namespace clang;
 using namespace llvm;
@@ -67,6 +72,55 @@ cl::opt<std::string> Style("style",
                            cl::desc("The style name used for reformatting."),
                            cl::init("LLVM"), cl::cat(ChangeNamespaceCategory));
 
+cl::opt<unsigned>
+    Jobs("j",
+         cl::desc("Number of translation units to process in parallel. "
+                  "0 uses all available hardware threads. Translation "
+                  "units are only processed in parallel if all of them "
+                  "are compiled in the current directory and all source "
+                  "paths are absolute."),
+         cl::init(1), cl::cat(ChangeNamespaceCategory));
+
+// Runs the change-namespace tool on the translation unit `File` with its own
+// tool state, and stores the produced replacements in `FileToReplacements`.
+// Returns true on success.
+bool runOnTranslationUnit(
+    const tooling::CompilationDatabase &Compilations, const std::string &File,
+    std::map<std::string, tooling::Replacements> *FileToReplacements) {
+  tooling::ClangTool Tool(Compilations, File);
+  change_namespace::ChangeNamespaceTool NamespaceTool(
+      OldNamespace, NewNamespace, FilePattern, FileToReplacements, Style);
+  ast_matchers::MatchFinder Finder;
+  NamespaceTool.registerMatchers(&Finder);
+  std::unique_ptr<tooling::FrontendActionFactory> Factory =
+      tooling::newFrontendActionFactory(&Finder);
+  return Tool.run(Factory.get()) == 0;
+}
+
+// Returns true if the translation units `Files` can be processed in parallel.
+// `ClangTool` changes the process working directory to that of each compile
+// command, and resolves relative paths against it. This is only safe from
+// several threads if no command changes the working directory, and no path
+// depends on it.
+bool canRunInParallel(const tooling::CompilationDatabase &Compilations,
+                      llvm::ArrayRef<std::string> Files) {
+  llvm::SmallString<256> CurrentDirectory;
+  if (llvm::sys::fs::current_path(CurrentDirectory))
+    return false;
+  for (const auto &File : Files) {
+    if (!llvm::sys::path::is_absolute(File))
+      return false;
+    for (const auto &Command : Compilations.getCompileCommands(File)) {
+      bool SameDirectory = false;
+      if (llvm::sys::fs::equivalent(Command.Directory, CurrentDirectory,
+                                    SameDirectory) ||
+          !SameDirectory || !llvm::sys::path::is_absolute(Command.Filename))
+        return false;
+    }
+  }
+  return true;
+}
+
 } // anonymous namespace
 
 int main(int argc, const char **argv) {
@@ -74,27 +128,52 @@ int main(int argc, const char **argv) {
   tooling::CommonOptionsParser OptionsParser(argc, argv,
                                              ChangeNamespaceCategory);
   const auto &Files = OptionsParser.getSourcePathList();
-  tooling::RefactoringTool Tool(OptionsParser.getCompilations(), Files);
-  change_namespace::ChangeNamespaceTool NamespaceTool(
-      OldNamespace, NewNamespace, FilePattern, &Tool.getReplacements(), Style);
-  ast_matchers::MatchFinder Finder;
-  NamespaceTool.registerMatchers(&Finder);
-  std::unique_ptr<tooling::FrontendActionFactory> Factory =
-      tooling::newFrontendActionFactory(&Finder);
 
-  if (int Result = Tool.run(Factory.get()))
+  // Each translation unit is processed with its own tool state and
+  // replacements, so that translation units can run in parallel.
+  std::vector<std::map<std::string, tooling::Replacements>> TUReplacements(
+      Files.size());
+  std::vector<char> TUSucceeded(Files.size(), false);
+  {
+    unsigned NumThreads = Jobs ? Jobs : std::thread::hardware_concurrency();
+    if (!canRunInParallel(OptionsParser.getCompilations(), Files))
+      NumThreads = 1;
+    llvm::ThreadPool Pool(std::max(1u, NumThreads));
+    for (size_t I = 0, E = Files.size(); I != E; ++I)
+      Pool.async([&, I] {
+        TUSucceeded[I] = runOnTranslationUnit(OptionsParser.getCompilations(),
+                                              Files[I], &TUReplacements[I]);
+      });
+  }
+
+  // Merge results in the order of the input files, so that the output does not
+  // depend on scheduling. Identical edits to shared headers are deduplicated.
+  std::map<std::string, tooling::Replacements> FileToReplacements;
+  int Result = 0;
+  for (size_t I = 0, E = Files.size(); I != E; ++I) {
+    if (!TUSucceeded[I])
+      Result = 1;
+    if (auto Err = change_namespace::mergeTranslationUnitReplacements(
+            TUReplacements[I], &FileToReplacements)) {
+      llvm::errs() << "Conflicting replacements from " << Files[I] << ": "
+                   << llvm::toString(std::move(Err)) << "\n";
+      return 1;
+    }
+  }
+  if (Result)
     return Result;
+
   LangOptions DefaultLangOptions;
   IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
   clang::TextDiagnosticPrinter DiagnosticPrinter(errs(), &*DiagOpts);
   DiagnosticsEngine Diagnostics(
       IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs()), &*DiagOpts,
       &DiagnosticPrinter, false);
-  auto &FileMgr = Tool.getFiles();
+  FileManager FileMgr((FileSystemOptions()));
   SourceManager Sources(Diagnostics, FileMgr);
   Rewriter Rewrite(Sources, DefaultLangOptions);
 
-  if (!formatAndApplyAllReplacements(Tool.getReplacements(), Rewrite, Style)) {
+  if (!formatAndApplyAllReplacements(FileToReplacements, Rewrite, Style)) {
     llvm::errs() << "Failed applying all replacements.\n";
     return 1;
   }
@@ -0,0 +1,56 @@
+//===--- CheckSummary.cpp - clang-tidy ------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CheckSummary.h"
+#include "llvm/Support/YAMLTraits.h"
+
+using clang::tidy::CheckSummary;
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(CheckSummary)
+
+namespace llvm {
+namespace yaml {
+
+template <> struct MappingTraits<CheckSummary> {
+  static void mapping(IO &IO, CheckSummary &Summary) {
+    IO.mapRequired("CheckName", Summary.CheckName);
+    IO.mapRequired("MainSourceFile", Summary.MainSourceFile);
+    IO.mapOptional("BuildDirectory", Summary.BuildDirectory);
+    IO.mapRequired("FilePath", Summary.FilePath);
+    IO.mapRequired("FileOffset", Summary.FileOffset);
+    IO.mapRequired("Key", Summary.Key);
+    IO.mapOptional("Value", Summary.Value);
+  }
+};
+
+} // namespace yaml
+} // namespace llvm
+
+namespace clang {
+namespace tidy {
+
+void exportSummaries(ArrayRef<CheckSummary> Summaries, raw_ostream &OS) {
+  std::vector<CheckSummary> NonConstSummaries = Summaries;
+  llvm::yaml::Output YAML(OS);
+  YAML << NonConstSummaries;
+}
+
+std::error_code parseSummaries(StringRef Text,
+                               std::vector<CheckSummary> &Summaries) {
+  llvm::yaml::Input Input(Text);
+  std::vector<CheckSummary> Parsed;
+  Input >> Parsed;
+  if (Input.error())
+    return Input.error();
+  Summaries.insert(Summaries.end(), Parsed.begin(), Parsed.end());
+  return std::error_code();
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,60 @@
+//===--- CheckSummary.h - clang-tidy ----------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CHECKSUMMARY_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CHECKSUMMARY_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tidy {
+
+/// \brief A fact recorded by a check in one translation unit, to be combined
+/// with the facts of all other translation units of a run.
+///
+/// Checks record summaries with ``ClangTidyCheck::summarize()`` and combine
+/// them in ``ClangTidyCheck::reduce()``. Summaries do not refer to any AST or
+/// \c SourceManager, so they can be written to disk and reduced by a later
+/// clang-tidy invocation.
+struct CheckSummary {
+  CheckSummary() : FileOffset(0) {}
+
+  /// \brief Name of the check that recorded the summary.
+  std::string CheckName;
+  /// \brief Main file of the translation unit the summary was recorded in.
+  std::string MainSourceFile;
+  /// \brief Build directory of the translation unit, used to resolve
+  /// \c FilePath if it is relative.
+  std::string BuildDirectory;
+  /// \brief Location the summary refers to.
+  std::string FilePath;
+  unsigned FileOffset;
+  /// \brief Check-defined key, e.g. the name of a declaration.
+  std::string Key;
+  /// \brief Check-defined payload.
+  std::string Value;
+};
+
+/// \brief Serializes \p Summaries into YAML and writes them to \p OS.
+void exportSummaries(ArrayRef<CheckSummary> Summaries, raw_ostream &OS);
+
+/// \brief Parses summaries written by \c exportSummaries and appends them to
+/// \p Summaries.
+std::error_code parseSummaries(StringRef Text,
+                               std::vector<CheckSummary> &Summaries);
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CHECKSUMMARY_H
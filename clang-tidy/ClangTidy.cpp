@@ -18,9 +18,11 @@
 #include "ClangTidy.h"
 #include "ClangTidyDiagnosticConsumer.h"
 #include "ClangTidyModuleRegistry.h"
+#include "SharedPreambles.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Format/Format.h"
 #include "clang/Frontend/ASTConsumers.h"
@@ -39,9 +41,14 @@
 #include "clang/Tooling/Refactoring.h"
 #include "clang/Tooling/ReplacementsYaml.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
+#include <map>
+#include <thread>
 #include <utility>
 
 using namespace clang::ast_matchers;
@@ -89,13 +96,14 @@ private:
 
 class ErrorReporter {
 public:
-  ErrorReporter(bool ApplyFixes, StringRef FormatStyle)
+  ErrorReporter(bool ApplyFixes, StringRef FormatStyle, unsigned ThreadCount)
       : Files(FileSystemOptions()), DiagOpts(new DiagnosticOptions()),
         DiagPrinter(new TextDiagnosticPrinter(llvm::outs(), &*DiagOpts)),
         Diags(IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs), &*DiagOpts,
               DiagPrinter),
         SourceMgr(Diags, Files), ApplyFixes(ApplyFixes), TotalFixes(0),
-        AppliedFixes(0), WarningsAsErrors(0), FormatStyle(FormatStyle) {
+        AppliedFixes(0), WarningsAsErrors(0), FormatStyle(FormatStyle),
+        ThreadCount(ThreadCount) {
     DiagOpts->ShowColors = llvm::sys::Process::StandardOutHasColors();
     DiagPrinter->BeginSourceFile(LangOpts);
   }
@@ -131,8 +139,8 @@ public:
             SmallString<128> FixAbsoluteFilePath = Repl.getFilePath();
             Files.makeAbsolutePath(FixAbsoluteFilePath);
             if (ApplyFixes) {
-              tooling::Replacement R(FixAbsoluteFilePath, Repl.getOffset(),
-                                     Repl.getLength(),
+              tooling::Replacement R(getFixFilePath(FixAbsoluteFilePath),
+                                     Repl.getOffset(), Repl.getLength(),
                                      Repl.getReplacementText());
               Replacements &Replacements = FileReplacements[R.getFilePath()];
               llvm::Error Err = Replacements.add(R);
@@ -185,35 +193,67 @@ public:
   void Finish() {
     // FIXME: Run clang-format on changes.
     if (ApplyFixes && TotalFixes > 0) {
-      Rewriter Rewrite(SourceMgr, LangOpts);
+      struct FileFixes {
+        StringRef File;
+        const Replacements *Replaces;
+        const format::FormatStyle *Style;
+        std::string ErrorText;
+        std::error_code WriteError;
+      };
+      std::vector<FileFixes> FixedFiles;
+      // Files in the same directory share their style, so look the
+      // .clang-format file up once per directory and language. A failed
+      // lookup keeps its error, which is reported for each of the files.
+      struct CachedStyle {
+        llvm::Optional<format::FormatStyle> Style;
+        std::string Error;
+      };
+      std::map<std::pair<StringRef, StringRef>, CachedStyle> Styles;
       for (const auto &FileAndReplacements : FileReplacements) {
         StringRef File = FileAndReplacements.first();
-        llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
-            SourceMgr.getFileManager().getBufferForFile(File);
-        if (!Buffer) {
-          llvm::errs() << "Can't get buffer for file " << File << ": "
-                       << Buffer.getError().message() << "\n";
-          // FIXME: Maybe don't apply fixes for other files as well.
-          continue;
-        }
-        StringRef Code = Buffer.get()->getBuffer();
-        auto Style = format::getStyle("file", File, FormatStyle);
-        if (!Style) {
-          llvm::errs() << llvm::toString(Style.takeError()) << "\n";
-          continue;
-        }
-        llvm::Expected<Replacements> CleanReplacements =
-            format::cleanupAroundReplacements(Code, FileAndReplacements.second,
-                                              *Style);
-        if (!CleanReplacements) {
-          llvm::errs() << llvm::toString(CleanReplacements.takeError()) << "\n";
-          continue;
-        }
-        if (!tooling::applyAllReplacements(CleanReplacements.get(), Rewrite)) {
-          llvm::errs() << "Can't apply replacements for file " << File << "\n";
+        auto Inserted = Styles.insert(std::make_pair(
+            std::make_pair(llvm::sys::path::parent_path(File),
+                           llvm::sys::path::extension(File)),
+            CachedStyle()));
+        CachedStyle &Cached = Inserted.first->second;
+        if (Inserted.second) {
+          auto Style = format::getStyle("file", File, FormatStyle);
+          if (Style)
+            Cached.Style = *Style;
+          else
+            Cached.Error = llvm::toString(Style.takeError()) + "\n";
         }
+        FixedFiles.push_back({File, &FileAndReplacements.second,
+                              Cached.Style.getPointer(), Cached.Error,
+                              std::error_code()});
+      }
+
+      // Each file is read, cleaned up and written by one task.
+      unsigned Threads = ThreadCount;
+      if (Threads == 0)
+        Threads = std::max(1u, std::thread::hardware_concurrency());
+      auto Apply = [](FileFixes &F) {
+        if (F.Style)
+          F.WriteError =
+              applyFixes(F.File, *F.Replaces, *F.Style, F.ErrorText);
+      };
+      if (Threads == 1 || FixedFiles.size() < 2) {
+        for (FileFixes &F : FixedFiles)
+          Apply(F);
+      } else {
+        llvm::ThreadPool Pool(std::min<size_t>(Threads, FixedFiles.size()));
+        for (FileFixes &F : FixedFiles)
+          Pool.async([&Apply, &F] { Apply(F); });
+        Pool.wait();
       }
-      if (Rewrite.overwriteChangedFiles()) {
+
+      bool WriteFailed = false;
+      for (const FileFixes &F : FixedFiles) {
+        llvm::errs() << F.ErrorText;
+        if (F.WriteError)
+          WriteFailed = true;
+      }
+      if (WriteFailed) {
         llvm::errs() << "clang-tidy failed to apply suggested fixes.\n";
       } else {
         llvm::errs() << "clang-tidy applied " << AppliedFixes << " of "
@@ -225,6 +265,80 @@ public:
   unsigned getWarningsAsErrorsCount() const { return WarningsAsErrors; }
 
 private:
+  /// \brief Applies \p Replaces to \p File and overwrites it. Returns the
+  /// error writing the file. Files that can't be fixed are skipped, and the
+  /// reason is appended to \p ErrorText.
+  ///
+  /// Only uses the file system, so that files can be fixed concurrently.
+  static std::error_code applyFixes(StringRef File,
+                                    const Replacements &Replaces,
+                                    const format::FormatStyle &Style,
+                                    std::string &ErrorText) {
+    llvm::raw_string_ostream Errors(ErrorText);
+    llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+        MemoryBuffer::getFile(File);
+    if (!Buffer) {
+      Errors << "Can't get buffer for file " << File << ": "
+             << Buffer.getError().message() << "\n";
+      // FIXME: Maybe don't apply fixes for other files as well.
+      return std::error_code();
+    }
+    StringRef Code = Buffer.get()->getBuffer();
+    llvm::Expected<Replacements> CleanReplacements =
+        format::cleanupAroundReplacements(Code, Replaces, Style);
+    if (!CleanReplacements) {
+      Errors << llvm::toString(CleanReplacements.takeError()) << "\n";
+      return std::error_code();
+    }
+    llvm::Expected<std::string> NewCode =
+        tooling::applyAllReplacements(Code, *CleanReplacements);
+    if (!NewCode) {
+      llvm::consumeError(NewCode.takeError());
+      Errors << "Can't apply replacements for file " << File << "\n";
+      return std::error_code();
+    }
+
+    // Write to a temporary file and move it in place, like
+    // Rewriter::overwriteChangedFiles() does. If the temporary file can't be
+    // created, write the file directly.
+    SmallString<128> TempPath;
+    int FD;
+    bool UseTempFile =
+        !llvm::sys::fs::createUniqueFile(File + "-%%%%%%%%", FD, TempPath);
+    if (!UseTempFile) {
+      std::error_code EC = llvm::sys::fs::openFileForWrite(
+          File, FD, llvm::sys::fs::F_None);
+      if (EC)
+        return EC;
+    }
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << *NewCode;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      if (UseTempFile)
+        llvm::sys::fs::remove(TempPath);
+      return std::make_error_code(std::errc::io_error);
+    }
+    if (!UseTempFile)
+      return std::error_code();
+    std::error_code EC = llvm::sys::fs::rename(TempPath, File);
+    if (EC)
+      llvm::sys::fs::remove(TempPath);
+    return EC;
+  }
+
+  /// \brief Returns the path the fixes to \p FilePath are collected under:
+  /// the first spelling of the same file, e.g. "a/../x.h" or a symbolic link
+  /// to "x.h". Each file is then fixed by a single task.
+  StringRef getFixFilePath(StringRef FilePath) {
+    llvm::sys::fs::UniqueID ID;
+    if (llvm::sys::fs::getUniqueID(FilePath, ID))
+      return FilePath;
+    return FixFilePaths.insert(std::make_pair(ID, FilePath.str()))
+        .first->second;
+  }
+
   SourceLocation getLocation(StringRef FilePath, unsigned Offset) {
     if (FilePath.empty())
       return SourceLocation();
@@ -247,26 +361,374 @@ private:
   DiagnosticsEngine Diags;
   SourceManager SourceMgr;
   llvm::StringMap<Replacements> FileReplacements;
+  std::map<llvm::sys::fs::UniqueID, std::string> FixFilePaths;
   bool ApplyFixes;
   unsigned TotalFixes;
   unsigned AppliedFixes;
   unsigned WarningsAsErrors;
   StringRef FormatStyle;
+  unsigned ThreadCount;
 };
 
 class ClangTidyASTConsumer : public MultiplexConsumer {
 public:
-  ClangTidyASTConsumer(std::vector<std::unique_ptr<ASTConsumer>> Consumers,
-                       std::unique_ptr<ast_matchers::MatchFinder> Finder,
-                       std::vector<std::unique_ptr<ClangTidyCheck>> Checks)
-      : MultiplexConsumer(std::move(Consumers)), Finder(std::move(Finder)),
+  ClangTidyASTConsumer(
+      std::vector<std::unique_ptr<ASTConsumer>> Consumers,
+      std::vector<std::unique_ptr<ast_matchers::MatchFinder>> Finders,
+      std::vector<std::unique_ptr<ClangTidyCheck>> Checks)
+      : MultiplexConsumer(std::move(Consumers)), Finders(std::move(Finders)),
         Checks(std::move(Checks)) {}
 
 private:
-  std::unique_ptr<ast_matchers::MatchFinder> Finder;
+  std::vector<std::unique_ptr<ast_matchers::MatchFinder>> Finders;
   std::vector<std::unique_ptr<ClangTidyCheck>> Checks;
 };
 
+/// \brief Tells whether a location is in a header whose warnings are not
+/// displayed and whose declarations the \c SkipHeaders option skips.
+///
+/// If \p Verdicts is given and \c SkipHeaders is "analyzed", headers analyzed
+/// by an earlier translation unit are skipped as well.
+class SkippedHeaders {
+public:
+  explicit SkippedHeaders(const ClangTidyOptions &Options,
+                          HeaderVerdictCache *Verdicts = nullptr)
+      : SkipFiltered(*Options.SkipHeaders == "filtered" ||
+                     *Options.SkipHeaders == "analyzed"),
+        SkipSystem(*Options.SkipHeaders != "none" && !*Options.SystemHeaders),
+        HeaderFilter(*Options.HeaderFilterRegex),
+        Verdicts(*Options.SkipHeaders == "analyzed" ? Verdicts : nullptr) {}
+
+  /// \brief Returns \c true if no headers are skipped.
+  bool skipsNothing() const { return !SkipFiltered && !SkipSystem; }
+
+  bool isSkipped(const SourceManager &SM, SourceLocation Loc) {
+    if (Loc.isInvalid() || skipsNothing())
+      return false;
+    FileID FID = SM.getFileID(SM.getExpansionLoc(Loc));
+    auto Cached = SkippedFiles.find(FID);
+    if (Cached != SkippedFiles.end())
+      return Cached->second;
+
+    bool Skip = false;
+    if (FID != SM.getMainFileID()) {
+      SourceLocation Start = SM.getLocForStartOfFile(FID);
+      // Same conditions as in ClangTidyDiagnosticConsumer::checkFilters().
+      if (SkipSystem && SM.isInSystemHeader(Start))
+        Skip = true;
+      else if (SkipFiltered)
+        if (const FileEntry *File = SM.getFileEntryForID(FID))
+          Skip = !HeaderFilter.match(File->getName());
+      // The diagnostics of a header analyzed before have been reported by the
+      // translation unit that analyzed it.
+      if (!Skip && Verdicts && SM.getFileEntryForID(FID))
+        Skip = Verdicts->isAnalyzedBefore(SM, FID);
+    }
+    SkippedFiles[FID] = Skip;
+    return Skip;
+  }
+
+private:
+  bool SkipFiltered;
+  bool SkipSystem;
+  llvm::Regex HeaderFilter;
+  HeaderVerdictCache *Verdicts;
+  llvm::DenseMap<FileID, bool> SkippedFiles;
+};
+
+/// \brief Runs the matchers of a \c MatchFinder on all nodes of the
+/// translation unit, except for the top-level declarations located in headers
+/// whose warnings are not displayed.
+///
+/// If no declaration is skipped, the translation unit is matched by
+/// \c MatchFinder::matchAST(). Otherwise, the nodes are visited in the same
+/// way, but matched one at a time, without the memoization \c matchAST() keeps
+/// across the nodes of the translation unit.
+class HeaderSkippingMatchConsumer
+    : public ASTConsumer,
+      public RecursiveASTVisitor<HeaderSkippingMatchConsumer> {
+public:
+  explicit HeaderSkippingMatchConsumer(ClangTidyContext &TidyContext)
+      : Profile(TidyContext.getCheckProfileData()),
+        Finder(getFinderOptions(Profile, MatchRecords)),
+        Skipped(TidyContext.getOptions(), &TidyContext.getHeaderVerdicts()),
+        Context(nullptr) {}
+
+  /// \brief Registers the matchers of \p Check.
+  void addCheck(ClangTidyCheck *Check) {
+    Check->registerMatchers(&Finder);
+    Checks.push_back(Check);
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    Context = &Ctx;
+    TranslationUnitDecl *TU = Ctx.getTranslationUnitDecl();
+    std::vector<Decl *> Decls;
+    bool SkipsAny = false;
+    for (Decl *D : TU->decls()) {
+      if (Skipped.isSkipped(Ctx.getSourceManager(), D->getLocation()))
+        SkipsAny = true;
+      else
+        Decls.push_back(D);
+    }
+    if (!SkipsAny) {
+      Finder.matchAST(Ctx);
+      addProfile();
+      return;
+    }
+
+    for (ClangTidyCheck *Check : Checks)
+      Check->onStartOfTranslationUnit();
+    match(*TU);
+    for (Decl *D : Decls)
+      TraverseDecl(D);
+    for (ClangTidyCheck *Check : Checks)
+      Check->onEndOfTranslationUnit();
+  }
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool TraverseDecl(Decl *D) {
+    if (!D)
+      return true;
+    match(*D);
+    return RecursiveASTVisitor::TraverseDecl(D);
+  }
+
+  bool TraverseStmt(Stmt *S) {
+    if (!S)
+      return true;
+    match(*S);
+    return RecursiveASTVisitor::TraverseStmt(S);
+  }
+
+  bool TraverseType(QualType T) {
+    match(T);
+    return RecursiveASTVisitor::TraverseType(T);
+  }
+
+  bool TraverseTypeLoc(TypeLoc TL) {
+    match(TL);
+    match(TL.getType());
+    return RecursiveASTVisitor::TraverseTypeLoc(TL);
+  }
+
+  bool TraverseNestedNameSpecifier(NestedNameSpecifier *NNS) {
+    if (NNS)
+      match(*NNS);
+    return RecursiveASTVisitor::TraverseNestedNameSpecifier(NNS);
+  }
+
+  bool TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc NNS) {
+    if (!NNS)
+      return true;
+    match(NNS);
+    // The specifier itself is not traversed separately from its location.
+    if (NNS.hasQualifier())
+      match(*NNS.getNestedNameSpecifier());
+    return RecursiveASTVisitor::TraverseNestedNameSpecifierLoc(NNS);
+  }
+
+  bool TraverseConstructorInitializer(CXXCtorInitializer *Init) {
+    if (Init)
+      match(*Init);
+    return RecursiveASTVisitor::TraverseConstructorInitializer(Init);
+  }
+
+private:
+  static ast_matchers::MatchFinder::MatchFinderOptions
+  getFinderOptions(ProfileData *Profile,
+                   llvm::StringMap<llvm::TimeRecord> &MatchRecords) {
+    ast_matchers::MatchFinder::MatchFinderOptions FinderOptions;
+    if (Profile)
+      FinderOptions.CheckProfiling.emplace(MatchRecords);
+    return FinderOptions;
+  }
+
+  template <typename T> void match(const T &Node) {
+    Finder.match(Node, *Context);
+    addProfile();
+  }
+
+  /// \brief Adds the times of the last match to the profile. Each match
+  /// replaces the records of the previous one.
+  void addProfile() {
+    if (!Profile)
+      return;
+    for (const auto &Record : MatchRecords)
+      Profile->Records[Record.getKey()] += Record.getValue();
+  }
+
+  ProfileData *Profile;
+  llvm::StringMap<llvm::TimeRecord> MatchRecords;
+  ast_matchers::MatchFinder Finder;
+  std::vector<ClangTidyCheck *> Checks;
+  SkippedHeaders Skipped;
+  ASTContext *Context;
+};
+
+/// \brief Counts the function definitions of the main file the static analyzer
+/// analyzes as top-level functions.
+class AnalyzedFunctionCounter
+    : public RecursiveASTVisitor<AnalyzedFunctionCounter> {
+public:
+  explicit AnalyzedFunctionCounter(const SourceManager &SM)
+      : SM(SM), Count(0) {}
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+
+  bool VisitFunctionDecl(FunctionDecl *D) {
+    if (D->doesThisDeclarationHaveABody() && !D->isDependentContext() &&
+        SM.isInMainFile(SM.getExpansionLoc(D->getLocation())))
+      ++Count;
+    return true;
+  }
+
+  bool VisitObjCMethodDecl(ObjCMethodDecl *D) {
+    if (D->hasBody() && SM.isInMainFile(SM.getExpansionLoc(D->getLocation())))
+      ++Count;
+    return true;
+  }
+
+  unsigned getCount() const { return Count; }
+
+private:
+  const SourceManager &SM;
+  unsigned Count;
+};
+
+/// \brief Passes to the static analyzer only the top-level declarations whose
+/// warnings can be displayed, and splits the node budget of the translation
+/// unit between the functions it analyzes.
+///
+/// The analyzer only considers the declarations it is given by
+/// \c HandleTopLevelDecl(), both for its syntax-based checks and as roots of
+/// its path-sensitive analysis. Functions reached from these roots are still
+/// inlined wherever they are located.
+class SelectiveAnalysisConsumer : public ASTConsumer {
+public:
+  SelectiveAnalysisConsumer(
+      std::unique_ptr<ento::AnalysisASTConsumer> Analysis,
+      AnalyzerOptionsRef AnalyzerOptions, ClangTidyContext &TidyContext)
+      : Analysis(std::move(Analysis)), AnalyzerOptions(AnalyzerOptions),
+        TidyContext(TidyContext), Skipped(TidyContext.getOptions()),
+        LineFilterOnly(*TidyContext.getOptions().AnalyzerLineFilterOnly),
+        MaxNodesPerTU(
+            TidyContext.getOptions().AnalyzerMaxNodesPerTU.getValueOr(0)),
+        RestrictToLines(false), Context(nullptr) {}
+
+  void Initialize(ASTContext &Ctx) override {
+    Context = &Ctx;
+    if (LineFilterOnly)
+      initLineRanges();
+    Analysis->Initialize(Ctx);
+  }
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    for (Decl *D : DG)
+      select(D);
+    return true;
+  }
+
+  void HandleTopLevelDeclInObjCContainer(DeclGroupRef DG) override {
+    Analysis->HandleTopLevelDeclInObjCContainer(DG);
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    if (MaxNodesPerTU > 0) {
+      AnalyzedFunctionCounter Counter(Ctx.getSourceManager());
+      for (Decl *D : Selected)
+        Counter.TraverseDecl(D);
+      if (Counter.getCount() > 0) {
+        // A function never gets more nodes than it gets without the budget.
+        unsigned FunctionMaxNodes =
+            std::min(std::max(1u, MaxNodesPerTU / Counter.getCount()),
+                     getFunctionMaxNodes());
+        // The analyzer reads this value when it analyzes its first function.
+        AnalyzerOptions->Config["max-nodes"] = std::to_string(FunctionMaxNodes);
+      }
+    }
+    Analysis->HandleTranslationUnit(Ctx);
+  }
+
+private:
+  /// \brief Returns the maximum number of nodes the analyzer explores per
+  /// function, as set by "max-nodes" or by default for its analysis mode.
+  unsigned getFunctionMaxNodes() const {
+    auto MaxNodes = AnalyzerOptions->Config.find("max-nodes");
+    unsigned Value;
+    if (MaxNodes != AnalyzerOptions->Config.end() &&
+        !StringRef(MaxNodes->getValue()).getAsInteger(10, Value))
+      return Value;
+    // Same defaults as in AnalyzerOptions::getMaxNodesPerTopLevelFunction(),
+    // which can't be called here, as it caches the value it returns.
+    return AnalyzerOptions->getUserMode() == UMK_Shallow ? 75000 : 225000;
+  }
+
+  void initLineRanges() {
+    const SourceManager &SM = Context->getSourceManager();
+    const ClangTidyGlobalOptions &GlobalOptions =
+        TidyContext.getGlobalOptions();
+    const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+    if (GlobalOptions.LineFilter.empty() || !MainFile)
+      return;
+    // Same matching as in ClangTidyDiagnosticConsumer::passesLineFilter(). No
+    // warnings of a main file without a filter are displayed.
+    RestrictToLines = true;
+    for (const FileFilter &Filter : GlobalOptions.LineFilter) {
+      if (StringRef(MainFile->getName()).endswith(Filter.Name)) {
+        RestrictToLines = !Filter.LineRanges.empty();
+        LineRanges = Filter.LineRanges;
+        return;
+      }
+    }
+  }
+
+  void select(Decl *D) {
+    const SourceManager &SM = Context->getSourceManager();
+    if (Skipped.isSkipped(SM, D->getLocation()))
+      return;
+    if (RestrictToLines &&
+        SM.isInMainFile(SM.getExpansionLoc(D->getLocation()))) {
+      // Namespaces are split, as they usually span most of the file.
+      if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D)) {
+        for (Decl *Inner : cast<DeclContext>(D)->decls())
+          select(Inner);
+        return;
+      }
+      if (!overlapsLineRanges(SM, D->getSourceRange()))
+        return;
+    }
+    Selected.push_back(D);
+    Analysis->HandleTopLevelDecl(DeclGroupRef(D));
+  }
+
+  bool overlapsLineRanges(const SourceManager &SM, SourceRange Range) const {
+    if (Range.isInvalid())
+      return false;
+    unsigned Begin = SM.getExpansionLineNumber(Range.getBegin());
+    unsigned End = SM.getExpansionLineNumber(
+        SM.getExpansionRange(Range.getEnd()).second);
+    for (const FileFilter::LineRange &Lines : LineRanges) {
+      if (Lines.first <= End && Begin <= Lines.second)
+        return true;
+    }
+    return false;
+  }
+
+  std::unique_ptr<ento::AnalysisASTConsumer> Analysis;
+  AnalyzerOptionsRef AnalyzerOptions;
+  ClangTidyContext &TidyContext;
+  SkippedHeaders Skipped;
+  bool LineFilterOnly;
+  unsigned MaxNodesPerTU;
+  bool RestrictToLines;
+  std::vector<FileFilter::LineRange> LineRanges;
+  std::vector<Decl *> Selected;
+  ASTContext *Context;
+};
+
 } // namespace
 
 ClangTidyASTConsumerFactory::ClangTidyASTConsumerFactory(
@@ -340,21 +802,47 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
   std::vector<std::unique_ptr<ClangTidyCheck>> Checks;
   CheckFactories->createChecks(&Context, Checks);
 
-  ast_matchers::MatchFinder::MatchFinderOptions FinderOptions;
-  if (auto *P = Context.getCheckProfileData())
-    FinderOptions.CheckProfiling.emplace(P->Records);
-
-  std::unique_ptr<ast_matchers::MatchFinder> Finder(
-      new ast_matchers::MatchFinder(std::move(FinderOptions)));
+  auto CreateFinder = [this]() {
+    ast_matchers::MatchFinder::MatchFinderOptions FinderOptions;
+    if (auto *P = Context.getCheckProfileData())
+      FinderOptions.CheckProfiling.emplace(P->Records);
+    return llvm::make_unique<ast_matchers::MatchFinder>(
+        std::move(FinderOptions));
+  };
 
+  // When headers are skipped, checks that need all declarations get a
+  // separate finder that traverses the whole translation unit.
+  const ClangTidyOptions &Options = Context.getOptions();
+  bool SkipHeaders =
+      *Options.SkipHeaders == "filtered" ||
+      *Options.SkipHeaders == "analyzed" ||
+      (*Options.SkipHeaders == "system" && !*Options.SystemHeaders);
+  std::unique_ptr<HeaderSkippingMatchConsumer> SkippingConsumer;
+  std::unique_ptr<ast_matchers::MatchFinder> Finder;
   for (auto &Check : Checks) {
-    Check->registerMatchers(&*Finder);
+    if (SkipHeaders && !Check->needsAllHeaders()) {
+      if (!SkippingConsumer)
+        SkippingConsumer =
+            llvm::make_unique<HeaderSkippingMatchConsumer>(Context);
+      SkippingConsumer->addCheck(Check.get());
+    } else {
+      if (!Finder)
+        Finder = CreateFinder();
+      Check->registerMatchers(&*Finder);
+    }
     Check->registerPPCallbacks(Compiler);
   }
 
+  // The finder replaces the profile with its own records, so it runs before
+  // the skipping consumer, which adds to them.
   std::vector<std::unique_ptr<ASTConsumer>> Consumers;
-  if (!Checks.empty())
+  std::vector<std::unique_ptr<ast_matchers::MatchFinder>> Finders;
+  if (Finder) {
     Consumers.push_back(Finder->newASTConsumer());
+    Finders.push_back(std::move(Finder));
+  }
+  if (SkippingConsumer)
+    Consumers.push_back(std::move(SkippingConsumer));
 
   AnalyzerOptionsRef AnalyzerOptions = Compiler.getAnalyzerOpts();
   // FIXME: Remove this option once clang's cfg-temporary-dtors option defaults
@@ -370,14 +858,18 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
     AnalyzerOptions->AnalysisDiagOpt = PD_NONE;
     AnalyzerOptions->AnalyzeNestedBlocks = true;
     AnalyzerOptions->eagerlyAssumeBinOpBifurcation = true;
+    if (Options.AnalyzerMaxNodes && *Options.AnalyzerMaxNodes > 0)
+      AnalyzerOptions->Config["max-nodes"] =
+          std::to_string(*Options.AnalyzerMaxNodes);
     std::unique_ptr<ento::AnalysisASTConsumer> AnalysisConsumer =
         ento::CreateAnalysisConsumer(Compiler);
     AnalysisConsumer->AddDiagnosticConsumer(
         new AnalyzerDiagnosticConsumer(Context));
-    Consumers.push_back(std::move(AnalysisConsumer));
+    Consumers.push_back(llvm::make_unique<SelectiveAnalysisConsumer>(
+        std::move(AnalysisConsumer), AnalyzerOptions, Context));
   }
   return llvm::make_unique<ClangTidyASTConsumer>(
-      std::move(Consumers), std::move(Finder), std::move(Checks));
+      std::move(Consumers), std::move(Finders), std::move(Checks));
 }
 
 std::vector<std::string> ClangTidyASTConsumerFactory::getCheckNames() {
@@ -404,9 +896,59 @@ ClangTidyOptions::OptionMap ClangTidyASTConsumerFactory::getCheckOptions() {
   return Options;
 }
 
+std::vector<ClangTidyError>
+ClangTidyASTConsumerFactory::reduceSummaries(ArrayRef<CheckSummary> Summaries,
+                                             unsigned ThreadCount) {
+  llvm::StringMap<std::vector<CheckSummary>> SummariesByCheck;
+  for (const CheckSummary &Summary : Summaries)
+    SummariesByCheck[Summary.CheckName].push_back(Summary);
+
+  struct Reduction {
+    std::unique_ptr<ClangTidyCheck> Check;
+    ArrayRef<CheckSummary> Summaries;
+    std::vector<ClangTidyError> Errors;
+  };
+  // Checks are created up front, as their constructors read options from the
+  // context, which must not be accessed concurrently.
+  std::vector<Reduction> Reductions;
+  GlobList &Filter = Context.getChecksFilter();
+  for (const auto &CheckFactory : *CheckFactories) {
+    auto It = SummariesByCheck.find(CheckFactory.first);
+    if (It == SummariesByCheck.end() || !Filter.contains(CheckFactory.first))
+      continue;
+    Reductions.emplace_back();
+    Reductions.back().Check.reset(
+        CheckFactory.second(CheckFactory.first, &Context));
+    Reductions.back().Summaries = It->second;
+  }
+
+  if (ThreadCount == 0)
+    ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+  if (ThreadCount == 1 || Reductions.size() < 2) {
+    for (Reduction &R : Reductions)
+      R.Check->reduce(R.Summaries, R.Errors);
+  } else {
+    llvm::ThreadPool Pool(std::min<size_t>(ThreadCount, Reductions.size()));
+    for (Reduction &R : Reductions)
+      Pool.async([&R] { R.Check->reduce(R.Summaries, R.Errors); });
+    Pool.wait();
+  }
+
+  std::vector<ClangTidyError> Errors;
+  for (Reduction &R : Reductions) {
+    for (ClangTidyError &Error : R.Errors) {
+      Context.setCurrentFile(Error.Message.FilePath);
+      Error.IsWarningAsError =
+          Context.getWarningAsErrorFilter().contains(Error.DiagnosticName);
+      Errors.push_back(std::move(Error));
+    }
+  }
+  return Errors;
+}
+
 DiagnosticBuilder ClangTidyCheck::diag(SourceLocation Loc, StringRef Message,
                                        DiagnosticIDs::Level Level) {
-  return Context->diag(CheckName, Loc, Message, Level);
+  return Context->diag(CheckID, Loc, Message, Level);
 }
 
 void ClangTidyCheck::run(const ast_matchers::MatchFinder::MatchResult &Result) {
@@ -414,29 +956,54 @@ void ClangTidyCheck::run(const ast_matchers::MatchFinder::MatchResult &Result) {
   check(Result);
 }
 
+ClangTidyError ClangTidyCheck::summaryDiag(const CheckSummary &Summary,
+                                           StringRef Message) const {
+  ClangTidyError Error(CheckName, ClangTidyError::Warning,
+                       Summary.BuildDirectory, /*IsWarningAsError=*/false);
+  Error.Message = summaryNote(Summary, Message);
+  return Error;
+}
+
+tooling::DiagnosticMessage
+ClangTidyCheck::summaryNote(const CheckSummary &Summary, StringRef Message) {
+  tooling::DiagnosticMessage Result(Message);
+  Result.FilePath = Summary.FilePath;
+  Result.FileOffset = Summary.FileOffset;
+  return Result;
+}
+
 OptionsView::OptionsView(StringRef CheckName,
-                         const ClangTidyOptions::OptionMap &CheckOptions)
+                         const CheckOptionTable &CheckOptions)
     : NamePrefix(CheckName.str() + "."), CheckOptions(CheckOptions) {}
 
 std::string OptionsView::get(StringRef LocalName, StringRef Default) const {
-  const auto &Iter = CheckOptions.find(NamePrefix + LocalName.str());
-  if (Iter != CheckOptions.end())
-    return Iter->second;
+  if (const auto *Value = CheckOptions.find(NamePrefix, LocalName))
+    return Value->getText();
   return Default;
 }
 
+const CheckOptionTable::Value *
+OptionsView::findLocalOrGlobal(StringRef LocalName) const {
+  if (const auto *Value = CheckOptions.find(NamePrefix, LocalName))
+    return Value;
+  // Fallback to global setting, if present.
+  return CheckOptions.find("", LocalName);
+}
+
 std::string OptionsView::getLocalOrGlobal(StringRef LocalName,
                                           StringRef Default) const {
-  auto Iter = CheckOptions.find(NamePrefix + LocalName.str());
-  if (Iter != CheckOptions.end())
-    return Iter->second;
-  // Fallback to global setting, if present.
-  Iter = CheckOptions.find(LocalName.str());
-  if (Iter != CheckOptions.end())
-    return Iter->second;
+  if (const auto *Value = findLocalOrGlobal(LocalName))
+    return Value->getText();
   return Default;
 }
 
+std::vector<std::string> OptionsView::getStringList(StringRef LocalName,
+                                                    StringRef Default) const {
+  if (const auto *Value = CheckOptions.find(NamePrefix, LocalName))
+    return Value->getStringList();
+  return parseCheckOptionList(Default);
+}
+
 void OptionsView::store(ClangTidyOptions::OptionMap &Options,
                         StringRef LocalName, StringRef Value) const {
   Options[NamePrefix + LocalName.str()] = Value;
@@ -467,7 +1034,8 @@ ClangTidyStats
 runClangTidy(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
              const CompilationDatabase &Compilations,
              ArrayRef<std::string> InputFiles,
-             std::vector<ClangTidyError> *Errors, ProfileData *Profile) {
+             std::vector<ClangTidyError> *Errors, ProfileData *Profile,
+             std::vector<CheckSummary> *Summaries, bool SharePreambles) {
   ClangTool Tool(Compilations, InputFiles);
   clang::tidy::ClangTidyContext Context(std::move(OptionsProvider));
 
@@ -507,6 +1075,20 @@ runClangTidy(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
 
   Tool.appendArgumentsAdjuster(PerFileExtraArgumentsInserter);
   Tool.appendArgumentsAdjuster(PluginArgumentsRemover);
+
+  // Precompile the includes shared by the input files, grouping them by their
+  // command lines as ClangTool adjusts them.
+  SharedPreambles Preambles;
+  if (SharePreambles) {
+    Preambles.build(
+        Compilations, InputFiles,
+        combineAdjusters(
+            combineAdjusters(getClangStripOutputAdjuster(),
+                             getClangSyntaxOnlyAdjuster()),
+            combineAdjusters(PerFileExtraArgumentsInserter,
+                             PluginArgumentsRemover)));
+    Tool.appendArgumentsAdjuster(Preambles.getArgumentsAdjuster());
+  }
   if (Profile)
     Context.setCheckProfileData(Profile);
 
@@ -538,12 +1120,29 @@ runClangTidy(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
   ActionFactory Factory(Context);
   Tool.run(&Factory);
   *Errors = Context.getErrors();
+  if (Summaries)
+    *Summaries = Context.getSummaries();
   return Context.getStats();
 }
 
+void reduceSummaries(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
+                     ArrayRef<CheckSummary> Summaries,
+                     std::vector<ClangTidyError> &Errors,
+                     unsigned ThreadCount) {
+  if (Summaries.empty())
+    return;
+  clang::tidy::ClangTidyContext Context(std::move(OptionsProvider));
+  ClangTidyASTConsumerFactory Factory(Context);
+  std::vector<ClangTidyError> Reduced =
+      Factory.reduceSummaries(Summaries, ThreadCount);
+  Errors.insert(Errors.end(), std::make_move_iterator(Reduced.begin()),
+                std::make_move_iterator(Reduced.end()));
+}
+
 void handleErrors(const std::vector<ClangTidyError> &Errors, bool Fix,
-                  StringRef FormatStyle, unsigned &WarningsAsErrorsCount) {
-  ErrorReporter Reporter(Fix, FormatStyle);
+                  StringRef FormatStyle, unsigned &WarningsAsErrorsCount,
+                  unsigned ThreadCount) {
+  ErrorReporter Reporter(Fix, FormatStyle, ThreadCount);
   vfs::FileSystem &FileSystem =
       *Reporter.getSourceManager().getFileManager().getVirtualFileSystem();
   auto InitialWorkingDir = FileSystem.getCurrentWorkingDirectory();
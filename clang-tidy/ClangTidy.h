@@ -39,8 +39,7 @@ namespace tidy {
 class OptionsView {
 public:
   /// \brief Initializes the instance using \p CheckName + "." as a prefix.
-  OptionsView(StringRef CheckName,
-              const ClangTidyOptions::OptionMap &CheckOptions);
+  OptionsView(StringRef CheckName, const CheckOptionTable &CheckOptions);
 
   /// \brief Read a named option from the ``Context``.
   ///
@@ -66,11 +65,9 @@ public:
   template <typename T>
   typename std::enable_if<std::is_integral<T>::value, T>::type
   get(StringRef LocalName, T Default) const {
-    std::string Value = get(LocalName, "");
-    T Result = Default;
-    if (!Value.empty())
-      StringRef(Value).getAsInteger(10, Result);
-    return Result;
+    if (const auto *Value = CheckOptions.find(NamePrefix, LocalName))
+      return Value->getAs<T>().getValueOr(Default);
+    return Default;
   }
 
   /// \brief Read a named option from the ``Context`` and parse it as an
@@ -83,13 +80,20 @@ public:
   template <typename T>
   typename std::enable_if<std::is_integral<T>::value, T>::type
   getLocalOrGlobal(StringRef LocalName, T Default) const {
-    std::string Value = getLocalOrGlobal(LocalName, "");
-    T Result = Default;
-    if (!Value.empty())
-      StringRef(Value).getAsInteger(10, Result);
-    return Result;
+    if (const auto *Value = findLocalOrGlobal(LocalName))
+      return Value->getAs<T>().getValueOr(Default);
+    return Default;
   }
 
+  /// \brief Read a named option from the ``Context`` and parse it as a
+  /// semicolon-separated list of strings.
+  ///
+  /// Reads the option with the check-local name \p LocalName from the
+  /// ``CheckOptions``. If the corresponding key is not present, parses
+  /// \p Default. The list is parsed once per configuration.
+  std::vector<std::string> getStringList(StringRef LocalName,
+                                         StringRef Default) const;
+
   /// \brief Stores an option with the check-local name \p LocalName with string
   /// value \p Value to \p Options.
   void store(ClangTidyOptions::OptionMap &Options, StringRef LocalName,
@@ -101,8 +105,10 @@ public:
              int64_t Value) const;
 
 private:
+  const CheckOptionTable::Value *findLocalOrGlobal(StringRef LocalName) const;
+
   std::string NamePrefix;
-  const ClangTidyOptions::OptionMap &CheckOptions;
+  const CheckOptionTable &CheckOptions;
 };
 
 /// \brief Base class for all clang-tidy checks.
@@ -120,10 +126,9 @@ private:
 /// and then override ``check(const MatchResult &Result)`` to do the actual
 /// check for each match.
 ///
-/// A new ``ClangTidyCheck`` instance is created per translation unit.
-///
-/// FIXME: Figure out whether carrying information from one TU to another is
-/// useful/necessary.
+/// A new ``ClangTidyCheck`` instance is created per translation unit. Checks
+/// that need information from several translation units record it with
+/// ``summarize()`` and combine it in ``reduce()``.
 class ClangTidyCheck : public ast_matchers::MatchFinder::MatchCallback {
 public:
   /// \brief Initializes the check with \p CheckName and \p Context.
@@ -132,8 +137,9 @@ public:
   /// delegate it. If a check needs to read options, it can do this in the
   /// constructor using the Options.get() methods below.
   ClangTidyCheck(StringRef CheckName, ClangTidyContext *Context)
-      : CheckName(CheckName), Context(Context),
-        Options(CheckName, Context->getOptions().CheckOptions) {
+      : CheckID(Context->getCheckID(CheckName)),
+        CheckName(Context->getCheckName(CheckID)), Context(Context),
+        Options(CheckName, Context->getCheckOptionTable()) {
     assert(Context != nullptr);
     assert(!CheckName.empty());
   }
@@ -158,6 +164,15 @@ public:
   /// matches occur in the order of the AST traversal.
   virtual void registerMatchers(ast_matchers::MatchFinder *Finder) {}
 
+  /// \brief Override this to return true if the check needs to match
+  /// declarations in headers whose warnings are not displayed.
+  ///
+  /// When the ``SkipHeaders`` option is set, the top-level declarations of such
+  /// headers are not matched, unless a check opts out using this method, e.g.
+  /// because it relates declarations in the main file to declarations in other
+  /// headers.
+  virtual bool needsAllHeaders() const { return false; }
+
   /// \brief ``ClangTidyChecks`` that register ASTMatchers should do the actual
   /// work in here.
   virtual void check(const ast_matchers::MatchFinder::MatchResult &Result) {}
@@ -173,10 +188,24 @@ public:
   /// whether it has the default value or it has been overridden.
   virtual void storeOptions(ClangTidyOptions::OptionMap &Options) {}
 
+  /// \brief Override this to combine the summaries recorded by this check in
+  /// all translation units of a run.
+  ///
+  /// \p Summaries contains the summaries of this check in the order they were
+  /// recorded. ``reduce()`` is called once per run on a separate instance of
+  /// the check, possibly concurrently with other checks, so it must not report
+  /// diagnostics using ``diag()``. Instead, it should append them to \p Errors,
+  /// e.g. using ``summaryDiag()``.
+  virtual void reduce(ArrayRef<CheckSummary> Summaries,
+                      std::vector<ClangTidyError> &Errors) {}
+
 private:
   void run(const ast_matchers::MatchFinder::MatchResult &Result) override;
   StringRef getID() const override { return CheckName; }
-  std::string CheckName;
+  /// \brief The ID of the check in the \c Context, and its name interned
+  /// there.
+  unsigned CheckID;
+  StringRef CheckName;
   ClangTidyContext *Context;
 
 protected:
@@ -185,6 +214,38 @@ protected:
   StringRef getCurrentMainFile() const { return Context->getCurrentFile(); }
   /// \brief Returns the language options from the context.
   LangOptions getLangOpts() const { return Context->getLangOpts(); }
+  /// \brief Returns the index of declaration references in the translation
+  /// unit of \p ASTCtx, shared by all checks.
+  const DeclRefIndex &getDeclRefIndex(ASTContext &ASTCtx) const {
+    return Context->getDeclRefIndex(ASTCtx);
+  }
+  /// \brief Returns the index of comments in the translation unit of
+  /// \p ASTCtx, shared by all checks.
+  CommentIndex &getCommentIndex(ASTContext &ASTCtx) const {
+    return Context->getCommentIndex(ASTCtx);
+  }
+  /// \brief Returns the parent map of the translation unit of \p ASTCtx,
+  /// shared by all checks. Prefer it to ``ASTContext::getParents()``.
+  ScopedParentMap &getParentMap(ASTContext &ASTCtx) const {
+    return Context->getParentMap(ASTCtx);
+  }
+  /// \brief Returns the inclusion directives of the translation unit of
+  /// \p PP, shared by all checks. Call from ``registerPPCallbacks()``.
+  const IncludeDirectives &getIncludeDirectives(Preprocessor &PP) const {
+    return Context->getIncludeDirectives(PP);
+  }
+  /// \brief Records a summary with \p Key and \p Value for the location
+  /// \p Loc, to be passed to ``reduce()`` at the end of the run.
+  void summarize(StringRef Key, StringRef Value, SourceLocation Loc) {
+    Context->summarize(CheckName, Key, Value, Loc);
+  }
+  /// \brief Creates a warning of this check at the location of \p Summary.
+  ClangTidyError summaryDiag(const CheckSummary &Summary,
+                             StringRef Message) const;
+  /// \brief Creates a note at the location of \p Summary, to be added to
+  /// the ``Notes`` of a diagnostic created by ``summaryDiag()``.
+  static tooling::DiagnosticMessage summaryNote(const CheckSummary &Summary,
+                                                StringRef Message);
 };
 
 class ClangTidyCheckFactories;
@@ -203,6 +264,12 @@ public:
   /// \brief Get the union of options from all checks.
   ClangTidyOptions::OptionMap getCheckOptions();
 
+  /// \brief Passes \p Summaries to the ``reduce()`` method of the enabled
+  /// checks that recorded them, using up to \p ThreadCount threads, and
+  /// returns the resulting errors.
+  std::vector<ClangTidyError> reduceSummaries(ArrayRef<CheckSummary> Summaries,
+                                              unsigned ThreadCount);
+
 private:
   ClangTidyContext &Context;
   std::unique_ptr<ClangTidyCheckFactories> CheckFactories;
@@ -224,12 +291,31 @@ ClangTidyOptions::OptionMap getCheckOptions(const ClangTidyOptions &Options);
 ///
 /// \param Profile if provided, it enables check profile collection in
 /// MatchFinder, and will contain the result of the profile.
+///
+/// \param Summaries if provided, will contain the summaries recorded by the
+/// checks, to be passed to \c reduceSummaries.
+///
+/// \param SharePreambles if true, the includes that input files with the same
+/// compile command start with are parsed once and shared through a
+/// precompiled header (see \c SharedPreambles).
 ClangTidyStats
 runClangTidy(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
              const tooling::CompilationDatabase &Compilations,
              ArrayRef<std::string> InputFiles,
              std::vector<ClangTidyError> *Errors,
-             ProfileData *Profile = nullptr);
+             ProfileData *Profile = nullptr,
+             std::vector<CheckSummary> *Summaries = nullptr,
+             bool SharePreambles = false);
+
+/// \brief Combines \p Summaries recorded by one or more \c runClangTidy
+/// invocations and appends the resulting diagnostics to \p Errors.
+///
+/// Checks are reduced on up to \p ThreadCount threads; 0 means one thread per
+/// hardware thread.
+void reduceSummaries(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
+                     ArrayRef<CheckSummary> Summaries,
+                     std::vector<ClangTidyError> &Errors,
+                     unsigned ThreadCount = 1);
 
 // FIXME: This interface will need to be significantly extended to be useful.
 // FIXME: Implement confidence levels for displaying/fixing errors.
@@ -237,8 +323,12 @@ runClangTidy(std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
 /// \brief Displays the found \p Errors to the users. If \p Fix is true, \p
 /// Errors containing fixes are automatically applied and reformatted. If no
 /// clang-format configuration file is found, the given \P FormatStyle is used.
+///
+/// Fixes are applied to different files on up to \p ThreadCount threads; 0
+/// means one thread per hardware thread.
 void handleErrors(const std::vector<ClangTidyError> &Errors, bool Fix,
-                  StringRef FormatStyle, unsigned &WarningsAsErrorsCount);
+                  StringRef FormatStyle, unsigned &WarningsAsErrorsCount,
+                  unsigned ThreadCount = 1);
 
 /// \brief Serializes replacements into YAML and writes them to the specified
 /// output stream.
@@ -21,6 +21,8 @@
 #include "clang/AST/ASTDiagnostic.h"
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Frontend/DiagnosticRenderer.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include <tuple>
 #include <vector>
@@ -45,9 +47,10 @@ protected:
     // FIXME: Remove this once there's a better way to pass check names than
     // appending the check name to the message in ClangTidyContext::diag and
     // using getCustomDiagID.
-    std::string CheckNameInMessage = " [" + Error.DiagnosticName + "]";
-    if (Message.endswith(CheckNameInMessage))
-      Message = Message.substr(0, Message.size() - CheckNameInMessage.size());
+    StringRef CheckName = Error.DiagnosticName;
+    if (Message.endswith("]") && Message.drop_back().endswith(CheckName) &&
+        Message.drop_back(CheckName.size() + 1).endswith(" ["))
+      Message = Message.drop_back(CheckName.size() + 3);
 
     auto TidyMessage = Loc.isValid()
                            ? tooling::DiagnosticMessage(Message, *SM, Loc)
@@ -156,6 +159,15 @@ bool GlobList::contains(StringRef S, bool Contains) {
   return Contains;
 }
 
+unsigned CheckNameTable::getID(StringRef Name) {
+  auto Inserted = IDs.insert(std::make_pair(Name, Names.size()));
+  if (Inserted.second)
+    Names.push_back(Inserted.first->getKey());
+  return Inserted.first->getValue();
+}
+
+const unsigned ClangTidyContext::NoCheckID;
+
 ClangTidyContext::ClangTidyContext(
     std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider)
     : DiagEngine(nullptr), OptionsProvider(std::move(OptionsProvider)),
@@ -168,15 +180,23 @@ ClangTidyContext::ClangTidyContext(
 DiagnosticBuilder ClangTidyContext::diag(
     StringRef CheckName, SourceLocation Loc, StringRef Description,
     DiagnosticIDs::Level Level /* = DiagnosticIDs::Warning*/) {
+  return diag(getCheckID(CheckName), Loc, Description, Level);
+}
+
+DiagnosticBuilder ClangTidyContext::diag(
+    unsigned CheckID, SourceLocation Loc, StringRef Description,
+    DiagnosticIDs::Level Level /* = DiagnosticIDs::Warning*/) {
   assert(Loc.isValid());
   unsigned ID = DiagEngine->getDiagnosticIDs()->getCustomDiagID(
-      Level, (Description + " [" + CheckName + "]").str());
-  CheckNamesByDiagnosticID.try_emplace(ID, CheckName);
+      Level, (Description + " [" + getCheckName(CheckID) + "]").str());
+  CheckIDsByDiagnosticID.try_emplace(ID, CheckID);
   return DiagEngine->Report(Loc, ID);
 }
 
 void ClangTidyContext::setDiagnosticsEngine(DiagnosticsEngine *Engine) {
   DiagEngine = Engine;
+  // Diagnostic IDs are specific to the engine.
+  CheckIDsByDiagnosticID.clear();
 }
 
 void ClangTidyContext::setSourceManager(SourceManager *SourceMgr) {
@@ -186,13 +206,67 @@ void ClangTidyContext::setSourceManager(SourceManager *SourceMgr) {
 void ClangTidyContext::setCurrentFile(StringRef File) {
   CurrentFile = File;
   CurrentOptions = getOptionsForFile(CurrentFile);
-  CheckFilter.reset(new GlobList(*getOptions().Checks));
-  WarningAsErrorFilter.reset(new GlobList(*getOptions().WarningsAsErrors));
+  if (!CheckOptionValues ||
+      !CheckOptionValues->isFor(CurrentOptions.CheckOptions))
+    CheckOptionValues =
+        llvm::make_unique<CheckOptionTable>(CurrentOptions.CheckOptions);
+  // Most files share the same filters, keep the matches of the previous file.
+  if (!CheckFilter || CheckFilterGlobs != *getOptions().Checks) {
+    CheckFilterGlobs = *getOptions().Checks;
+    CheckFilter.reset(new GlobList(CheckFilterGlobs));
+    CheckFilterByID.clear();
+  }
+  if (!WarningAsErrorFilter ||
+      WarningAsErrorFilterGlobs != *getOptions().WarningsAsErrors) {
+    WarningAsErrorFilterGlobs = *getOptions().WarningsAsErrors;
+    WarningAsErrorFilter.reset(new GlobList(WarningAsErrorFilterGlobs));
+    WarningAsErrorFilterByID.clear();
+  }
 }
 
 void ClangTidyContext::setASTContext(ASTContext *Context) {
   DiagEngine->SetArgToStringFn(&FormatASTNodeDiagnosticArgument, Context);
   LangOpts = Context->getLangOpts();
+  RefIndex.reset();
+  Comments.reset();
+  Parents.reset();
+  Includes.reset();
+  NoLint.reset();
+  HeaderVerdicts.startTranslationUnit(CurrentOptions);
+}
+
+const DeclRefIndex &ClangTidyContext::getDeclRefIndex(ASTContext &Context) {
+  if (!RefIndex || &RefIndex->getASTContext() != &Context)
+    RefIndex = llvm::make_unique<DeclRefIndex>(Context);
+  return *RefIndex;
+}
+
+CommentIndex &ClangTidyContext::getCommentIndex(ASTContext &Context) {
+  if (!Comments || &Comments->getSourceManager() != &Context.getSourceManager())
+    Comments = llvm::make_unique<CommentIndex>(Context.getSourceManager(),
+                                               Context.getLangOpts());
+  return *Comments;
+}
+
+ScopedParentMap &ClangTidyContext::getParentMap(ASTContext &Context) {
+  if (!Parents || &Parents->getASTContext() != &Context)
+    Parents = llvm::make_unique<ScopedParentMap>(Context);
+  return *Parents;
+}
+
+const IncludeDirectives &
+ClangTidyContext::getIncludeDirectives(Preprocessor &PP) {
+  if (!Includes || &Includes->getSourceManager() != &PP.getSourceManager()) {
+    Includes = llvm::make_unique<IncludeDirectives>(PP.getSourceManager());
+    PP.addPPCallbacks(Includes->createPPCallbacks());
+  }
+  return *Includes;
+}
+
+NoLintIndex &ClangTidyContext::getNoLintIndex(const SourceManager &SM) {
+  if (!NoLint || &NoLint->getSourceManager() != &SM)
+    NoLint = llvm::make_unique<NoLintIndex>(SM, LangOpts);
+  return *NoLint;
 }
 
 const ClangTidyGlobalOptions &ClangTidyContext::getGlobalOptions() const {
@@ -205,9 +279,10 @@ const ClangTidyOptions &ClangTidyContext::getOptions() const {
 
 ClangTidyOptions ClangTidyContext::getOptionsForFile(StringRef File) const {
   // Merge options on top of getDefaults() as a safeguard against options with
-  // unset values.
-  return ClangTidyOptions::getDefaults().mergeWith(
-      OptionsProvider->getOptions(File));
+  // unset values. The defaults only depend on the registered modules, so
+  // compute them once instead of instantiating every module per file.
+  static const ClangTidyOptions Defaults = ClangTidyOptions::getDefaults();
+  return Defaults.mergeWith(OptionsProvider->getOptions(File));
 }
 
 void ClangTidyContext::setCheckProfileData(ProfileData *P) { Profile = P; }
@@ -222,22 +297,59 @@ GlobList &ClangTidyContext::getWarningAsErrorFilter() {
   return *WarningAsErrorFilter;
 }
 
+bool ClangTidyContext::matchCached(std::vector<char> &Cache, GlobList &Filter,
+                                   unsigned CheckID) {
+  // Diagnostics without a check, e.g. orphan notes, match no filter.
+  if (CheckID == NoCheckID)
+    return false;
+  assert(CheckID < CheckNames.size() && "Unknown check ID");
+  if (CheckID >= Cache.size())
+    Cache.resize(CheckNames.size(), 0);
+  if (Cache[CheckID] == 0)
+    Cache[CheckID] = Filter.contains(getCheckName(CheckID)) ? 2 : 1;
+  return Cache[CheckID] == 2;
+}
+
 /// \brief Store a \c ClangTidyError.
 void ClangTidyContext::storeError(const ClangTidyError &Error) {
   Errors.push_back(Error);
 }
 
-StringRef ClangTidyContext::getCheckName(unsigned DiagnosticID) const {
-  llvm::DenseMap<unsigned, std::string>::const_iterator I =
-      CheckNamesByDiagnosticID.find(DiagnosticID);
-  if (I != CheckNamesByDiagnosticID.end())
+void ClangTidyContext::summarize(StringRef CheckName, StringRef Key,
+                                 StringRef Value, SourceLocation Loc) {
+  assert(Loc.isValid());
+  const SourceManager &SM = DiagEngine->getSourceManager();
+  Loc = SM.getFileLoc(Loc);
+  CheckSummary Summary;
+  Summary.CheckName = CheckName;
+  Summary.MainSourceFile = CurrentFile;
+  Summary.BuildDirectory = CurrentBuildDirectory;
+  Summary.FilePath = SM.getFilename(Loc);
+  Summary.FileOffset = SM.getFileOffset(Loc);
+  Summary.Key = Key;
+  Summary.Value = Value;
+  Summaries.push_back(std::move(Summary));
+}
+
+unsigned ClangTidyContext::getCheckIDForDiagnostic(unsigned DiagnosticID) {
+  auto I = CheckIDsByDiagnosticID.find(DiagnosticID);
+  if (I != CheckIDsByDiagnosticID.end())
     return I->second;
-  return "";
+  // Compiler diagnostics are named after their warning option once per ID.
+  StringRef WarningOption =
+      DiagEngine->getDiagnosticIDs()->getWarningOptionForDiag(DiagnosticID);
+  unsigned CheckID = NoCheckID;
+  if (!WarningOption.empty())
+    CheckID = getCheckID(("clang-diagnostic-" + WarningOption).str());
+  CheckIDsByDiagnosticID[DiagnosticID] = CheckID;
+  return CheckID;
 }
 
 ClangTidyDiagnosticConsumer::ClangTidyDiagnosticConsumer(ClangTidyContext &Ctx)
     : Context(Ctx), LastErrorRelatesToUserCode(false),
-      LastErrorPassesLineFilter(false), LastErrorWasIgnored(false) {
+      LastErrorPassesLineFilter(false), LastErrorWasIgnored(false),
+      LastErrorCheckID(ClangTidyContext::NoCheckID),
+      LastErrorHeaderSources(nullptr) {
   IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
   Diags.reset(new DiagnosticsEngine(
       IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs), &*DiagOpts, this,
@@ -248,7 +360,7 @@ ClangTidyDiagnosticConsumer::ClangTidyDiagnosticConsumer(ClangTidyContext &Ctx)
 void ClangTidyDiagnosticConsumer::finalizeLastError() {
   if (!Errors.empty()) {
     ClangTidyError &Error = Errors.back();
-    if (!Context.getChecksFilter().contains(Error.DiagnosticName) &&
+    if (!Context.isCheckEnabled(LastErrorCheckID) &&
         Error.DiagLevel != ClangTidyError::Error) {
       ++Context.Stats.ErrorsIgnoredCheckFilter;
       Errors.pop_back();
@@ -258,34 +370,26 @@ void ClangTidyDiagnosticConsumer::finalizeLastError() {
     } else if (!LastErrorPassesLineFilter) {
       ++Context.Stats.ErrorsIgnoredLineFilter;
       Errors.pop_back();
+    } else if (isDuplicateHeaderError()) {
+      // Reported by an earlier translation unit including the same header.
+      ++Context.Stats.ErrorsIgnoredDuplicateHeader;
+      Errors.pop_back();
     } else {
       ++Context.Stats.ErrorsDisplayed;
     }
   }
+  LastErrorHeaderSources = nullptr;
+  DeferredDiagnostics.clear();
   LastErrorRelatesToUserCode = false;
   LastErrorPassesLineFilter = false;
 }
 
-static bool LineIsMarkedWithNOLINT(SourceManager &SM, SourceLocation Loc) {
-  bool Invalid;
-  const char *CharacterData = SM.getCharacterData(Loc, &Invalid);
-  if (!Invalid) {
-    const char *P = CharacterData;
-    while (*P != '\0' && *P != '\r' && *P != '\n')
-      ++P;
-    StringRef RestOfLine(CharacterData, P - CharacterData + 1);
-    // FIXME: Handle /\bNOLINT\b(\([^)]*\))?/ as cpplint.py does.
-    if (RestOfLine.find("NOLINT") != StringRef::npos) {
-      return true;
-    }
-  }
-  return false;
-}
-
-static bool LineIsMarkedWithNOLINTinMacro(SourceManager &SM,
-                                          SourceLocation Loc) {
+static bool LineIsMarkedWithNOLINTinMacro(NoLintIndex &NoLint,
+                                          const SourceManager &SM,
+                                          SourceLocation Loc,
+                                          StringRef CheckName) {
   while (true) {
-    if (LineIsMarkedWithNOLINT(SM, Loc))
+    if (NoLint.isSuppressed(Loc, CheckName))
       return true;
     if (!Loc.isMacroID())
       return false;
@@ -294,21 +398,62 @@ static bool LineIsMarkedWithNOLINTinMacro(SourceManager &SM,
   return false;
 }
 
+unsigned
+ClangTidyDiagnosticConsumer::getCheckID(DiagnosticsEngine::Level DiagLevel,
+                                        const Diagnostic &Info) {
+  // Notes belong to the check of the diagnostic they are attached to.
+  if (DiagLevel == DiagnosticsEngine::Note)
+    return Errors.empty() ? ClangTidyContext::NoCheckID : LastErrorCheckID;
+
+  unsigned CheckID = Context.getCheckIDForDiagnostic(Info.getID());
+  if (CheckID != ClangTidyContext::NoCheckID)
+    return CheckID;
+
+  // This is a compiler diagnostic without a warning option. Assign check name
+  // based on its level.
+  switch (DiagLevel) {
+  case DiagnosticsEngine::Error:
+  case DiagnosticsEngine::Fatal:
+    return Context.getCheckID("clang-diagnostic-error");
+  case DiagnosticsEngine::Warning:
+    return Context.getCheckID("clang-diagnostic-warning");
+  default:
+    return Context.getCheckID("clang-diagnostic-unknown");
+  }
+}
+
 void ClangTidyDiagnosticConsumer::HandleDiagnostic(
     DiagnosticsEngine::Level DiagLevel, const Diagnostic &Info) {
   if (LastErrorWasIgnored && DiagLevel == DiagnosticsEngine::Note)
     return;
 
+  unsigned CheckID = getCheckID(DiagLevel, Info);
+  StringRef CheckName = Context.getCheckName(CheckID);
   if (Info.getLocation().isValid() && DiagLevel != DiagnosticsEngine::Error &&
       DiagLevel != DiagnosticsEngine::Fatal &&
-      LineIsMarkedWithNOLINTinMacro(Diags->getSourceManager(),
-                                    Info.getLocation())) {
+      LineIsMarkedWithNOLINTinMacro(
+          Context.getNoLintIndex(Diags->getSourceManager()),
+          Diags->getSourceManager(), Info.getLocation(), CheckName)) {
     ++Context.Stats.ErrorsIgnoredNOLINT;
     // Ignored a warning, should ignore related notes as well
     LastErrorWasIgnored = true;
     return;
   }
 
+  // Diagnostics of checks that are not enabled are dropped regardless of
+  // their notes, so don't format them.
+  if (DiagLevel != DiagnosticsEngine::Note &&
+      DiagLevel != DiagnosticsEngine::Error &&
+      DiagLevel != DiagnosticsEngine::Fatal &&
+      !Context.isCheckEnabled(CheckID)) {
+    ++Context.Stats.ErrorsIgnoredCheckFilter;
+    LastErrorWasIgnored = true;
+    return;
+  }
+
+  SmallString<100> Message;
+  Info.FormatDiagnostic(Message);
+
   LastErrorWasIgnored = false;
   // Count warnings/errors.
   DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
@@ -318,29 +463,6 @@ void ClangTidyDiagnosticConsumer::HandleDiagnostic(
            "A diagnostic note can only be appended to a message.");
   } else {
     finalizeLastError();
-    StringRef WarningOption =
-        Context.DiagEngine->getDiagnosticIDs()->getWarningOptionForDiag(
-            Info.getID());
-    std::string CheckName = !WarningOption.empty()
-                                ? ("clang-diagnostic-" + WarningOption).str()
-                                : Context.getCheckName(Info.getID()).str();
-
-    if (CheckName.empty()) {
-      // This is a compiler diagnostic without a warning option. Assign check
-      // name based on its level.
-      switch (DiagLevel) {
-      case DiagnosticsEngine::Error:
-      case DiagnosticsEngine::Fatal:
-        CheckName = "clang-diagnostic-error";
-        break;
-      case DiagnosticsEngine::Warning:
-        CheckName = "clang-diagnostic-warning";
-        break;
-      default:
-        CheckName = "clang-diagnostic-unknown";
-        break;
-      }
-    }
 
     ClangTidyError::Level Level = ClangTidyError::Warning;
     if (DiagLevel == DiagnosticsEngine::Error ||
@@ -351,25 +473,84 @@ void ClangTidyDiagnosticConsumer::HandleDiagnostic(
       LastErrorRelatesToUserCode = true;
       LastErrorPassesLineFilter = true;
     }
-    bool IsWarningAsError =
-        DiagLevel == DiagnosticsEngine::Warning &&
-        Context.getWarningAsErrorFilter().contains(CheckName);
+    bool IsWarningAsError = DiagLevel == DiagnosticsEngine::Warning &&
+                            Context.isWarningAsError(CheckID);
     Errors.emplace_back(CheckName, Level, Context.getCurrentBuildDirectory(),
                         IsWarningAsError);
+    LastErrorCheckID = CheckID;
+    if (DiagLevel == DiagnosticsEngine::Warning)
+      setLastErrorHeader(Info, Message);
   }
 
-  ClangTidyDiagnosticRenderer Converter(
-      Context.getLangOpts(), &Context.DiagEngine->getDiagnosticOptions(),
-      Errors.back());
-  SmallString<100> Message;
-  Info.FormatDiagnostic(Message);
+  checkFilters(Info.getLocation());
+
   SourceManager *Sources = nullptr;
   if (Info.hasSourceManager())
     Sources = &Info.getSourceManager();
-  Converter.emitDiagnostic(Info.getLocation(), DiagLevel, Message,
-                           Info.getRanges(), Info.getFixItHints(), Sources);
 
-  checkFilters(Info.getLocation());
+  // A diagnostic outside of user code or outside of the line filter is only
+  // kept if one of its notes passes the filters. Defer rendering it and its
+  // notes until then, as most of them are dropped in the end.
+  if (!LastErrorRelatesToUserCode || !LastErrorPassesLineFilter) {
+    DeferredDiagnostics.push_back(
+        {Info.getLocation(), DiagLevel, Message.str().str(),
+         std::vector<CharSourceRange>(Info.getRanges().begin(),
+                                      Info.getRanges().end()),
+         std::vector<FixItHint>(Info.getFixItHints().begin(),
+                                Info.getFixItHints().end()),
+         Sources});
+    return;
+  }
+
+  for (const DeferredDiagnostic &Deferred : DeferredDiagnostics)
+    renderDiagnostic(Deferred.Loc, Deferred.Level, Deferred.Message,
+                     Deferred.Ranges, Deferred.FixIts, Deferred.Sources);
+  DeferredDiagnostics.clear();
+  renderDiagnostic(Info.getLocation(), DiagLevel, Message, Info.getRanges(),
+                   Info.getFixItHints(), Sources);
+}
+
+void ClangTidyDiagnosticConsumer::renderDiagnostic(
+    SourceLocation Loc, DiagnosticsEngine::Level DiagLevel, StringRef Message,
+    ArrayRef<CharSourceRange> Ranges, ArrayRef<FixItHint> FixIts,
+    const SourceManager *Sources) {
+  ClangTidyDiagnosticRenderer Converter(
+      Context.getLangOpts(), &Context.DiagEngine->getDiagnosticOptions(),
+      Errors.back());
+  Converter.emitDiagnostic(Loc, DiagLevel, Message, Ranges, FixIts, Sources);
+}
+
+void ClangTidyDiagnosticConsumer::setLastErrorHeader(const Diagnostic &Info,
+                                                     StringRef Message) {
+  if (!Info.getLocation().isValid() || !Info.hasSourceManager())
+    return;
+  const SourceManager &Sources = Info.getSourceManager();
+  std::pair<FileID, unsigned> Decomposed =
+      Sources.getDecomposedExpansionLoc(Info.getLocation());
+  // Each main file is analyzed once; duplicates within a translation unit are
+  // removed in finish().
+  if (Decomposed.first == Sources.getMainFileID() ||
+      !Sources.getFileEntryForID(Decomposed.first))
+    return;
+  LastErrorHeaderSources = &Sources;
+  LastErrorHeader = Decomposed.first;
+  LastErrorHeaderKey.clear();
+  llvm::raw_string_ostream(LastErrorHeaderKey)
+      << Decomposed.second << ':' << Info.getID() << ':' << Message;
+}
+
+bool ClangTidyDiagnosticConsumer::isDuplicateHeaderError() {
+  if (!LastErrorHeaderSources)
+    return false;
+  // Notes can differ between translation units, e.g. when they point into
+  // the main file, so an error is only a duplicate with the same notes.
+  SmallString<256> Key(LastErrorHeaderKey);
+  llvm::raw_svector_ostream OS(Key);
+  for (const tooling::DiagnosticMessage &Note : Errors.back().Notes)
+    OS << '\0' << Note.FilePath << ':' << Note.FileOffset << ':'
+       << Note.Message;
+  return !Context.HeaderVerdicts.insert(*LastErrorHeaderSources,
+                                        LastErrorHeader, OS.str());
 }
 
 bool ClangTidyDiagnosticConsumer::passesLineFilter(StringRef FileName,
@@ -417,10 +598,13 @@ void ClangTidyDiagnosticConsumer::checkFilters(SourceLocation Location) {
     return;
   }
 
+  // The header a shared precompiled header is built from has no include
+  // location either, so isInMainFile() alone would take it for the main file.
   StringRef FileName(File->getName());
-  LastErrorRelatesToUserCode = LastErrorRelatesToUserCode ||
-                               Sources.isInMainFile(Location) ||
-                               getHeaderFilter()->match(FileName);
+  LastErrorRelatesToUserCode =
+      LastErrorRelatesToUserCode ||
+      (FID == Sources.getMainFileID() && Sources.isInMainFile(Location)) ||
+      getHeaderFilter()->match(FileName);
 
   unsigned LineNumber = Sources.getExpansionLineNumber(Location);
   LastErrorPassesLineFilter =
@@ -10,7 +10,14 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYDIAGNOSTICCONSUMER_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYDIAGNOSTICCONSUMER_H
 
+#include "CheckSummary.h"
 #include "ClangTidyOptions.h"
+#include "CommentIndex.h"
+#include "DeclRefIndex.h"
+#include "HeaderVerdictCache.h"
+#include "IncludeDirectives.h"
+#include "NoLintIndex.h"
+#include "ScopedParentMap.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Tooling/Core/Diagnostic.h"
@@ -24,6 +31,7 @@ namespace clang {
 
 class ASTContext;
 class CompilerInstance;
+class Preprocessor;
 namespace ast_matchers {
 class MatchFinder;
 }
@@ -68,22 +76,50 @@ private:
   std::unique_ptr<GlobList> NextGlob;
 };
 
+/// \brief Interns the names of checks and of the clang diagnostic groups
+/// reported as \c clang-diagnostic-* checks, assigning each name a dense
+/// integer ID.
+///
+/// IDs are assigned in the order names are first seen and stay valid for the
+/// lifetime of the table, as do the interned names.
+class CheckNameTable {
+public:
+  /// \brief Returns the ID of \p Name, assigning the next free ID on first
+  /// use.
+  unsigned getID(StringRef Name);
+
+  /// \brief Returns the interned name of the check with the ID \p ID.
+  StringRef getName(unsigned ID) const { return Names[ID]; }
+
+  /// \brief Returns the number of interned names, which is one past the
+  /// largest ID.
+  unsigned size() const { return Names.size(); }
+
+private:
+  llvm::StringMap<unsigned> IDs;
+  std::vector<StringRef> Names;
+};
+
 /// \brief Contains displayed and ignored diagnostic counters for a ClangTidy
 /// run.
 struct ClangTidyStats {
   ClangTidyStats()
       : ErrorsDisplayed(0), ErrorsIgnoredCheckFilter(0), ErrorsIgnoredNOLINT(0),
-        ErrorsIgnoredNonUserCode(0), ErrorsIgnoredLineFilter(0) {}
+        ErrorsIgnoredNonUserCode(0), ErrorsIgnoredLineFilter(0),
+        ErrorsIgnoredDuplicateHeader(0) {}
 
   unsigned ErrorsDisplayed;
   unsigned ErrorsIgnoredCheckFilter;
   unsigned ErrorsIgnoredNOLINT;
   unsigned ErrorsIgnoredNonUserCode;
   unsigned ErrorsIgnoredLineFilter;
+  /// \brief Errors in headers already reported by an earlier translation unit.
+  unsigned ErrorsIgnoredDuplicateHeader;
 
   unsigned errorsIgnored() const {
     return ErrorsIgnoredNOLINT + ErrorsIgnoredCheckFilter +
-           ErrorsIgnoredNonUserCode + ErrorsIgnoredLineFilter;
+           ErrorsIgnoredNonUserCode + ErrorsIgnoredLineFilter +
+           ErrorsIgnoredDuplicateHeader;
   }
 };
 
@@ -115,6 +151,12 @@ public:
                          StringRef Message,
                          DiagnosticIDs::Level Level = DiagnosticIDs::Warning);
 
+  /// \brief Reports a diagnostic of the check with the ID \p CheckID, as
+  /// returned by \c getCheckID().
+  DiagnosticBuilder diag(unsigned CheckID, SourceLocation Loc,
+                         StringRef Message,
+                         DiagnosticIDs::Level Level = DiagnosticIDs::Warning);
+
   /// \brief Sets the \c SourceManager of the used \c DiagnosticsEngine.
   ///
   /// This is called from the \c ClangTidyCheck base class.
@@ -129,12 +171,54 @@ public:
   /// \brief Sets ASTContext for the current translation unit.
   void setASTContext(ASTContext *Context);
 
+  /// \brief Returns the index of declaration references in the translation
+  /// unit of \p Context, building it on first use.
+  const DeclRefIndex &getDeclRefIndex(ASTContext &Context);
+
+  /// \brief Returns the index of comments in the files of the translation unit
+  /// of \p Context. Files are indexed on first use.
+  CommentIndex &getCommentIndex(ASTContext &Context);
+
+  /// \brief Returns the parent map of the translation unit of \p Context.
+  /// Parent links are built per top-level declaration on first use.
+  ScopedParentMap &getParentMap(ASTContext &Context);
+
+  /// \brief Returns the inclusion directives of the translation unit of
+  /// \p PP. The callbacks recording them are registered with \p PP on first
+  /// use.
+  const IncludeDirectives &getIncludeDirectives(Preprocessor &PP);
+
+  /// \brief Returns the NOLINT markers of the files managed by \p SM. Files are
+  /// indexed on first use.
+  NoLintIndex &getNoLintIndex(const SourceManager &SM);
+
+  /// \brief Returns the headers analyzed and the diagnostics reported in them
+  /// by the translation units processed so far.
+  HeaderVerdictCache &getHeaderVerdicts() { return HeaderVerdicts; }
+
   /// \brief Gets the language options from the AST context.
   const LangOptions &getLangOpts() const { return LangOpts; }
 
-  /// \brief Returns the name of the clang-tidy check which produced this
-  /// diagnostic ID.
-  StringRef getCheckName(unsigned DiagnosticID) const;
+  /// \brief Returns the ID of the check named \p CheckName, interning the
+  /// name on first use.
+  unsigned getCheckID(StringRef CheckName) {
+    return CheckNames.getID(CheckName);
+  }
+
+  /// \brief Returns the name of the check with the ID \p CheckID, or an
+  /// empty string for \c NoCheckID.
+  StringRef getCheckName(unsigned CheckID) const {
+    if (CheckID == NoCheckID)
+      return StringRef();
+    return CheckNames.getName(CheckID);
+  }
+
+  /// \brief Returns the ID of the clang-tidy check or clang diagnostic group
+  /// which produced this diagnostic ID, or \c NoCheckID for compiler
+  /// diagnostics without a warning option.
+  unsigned getCheckIDForDiagnostic(unsigned DiagnosticID);
+
+  static const unsigned NoCheckID = ~0u;
 
   /// \brief Returns check filter for the \c CurrentFile.
   ///
@@ -145,6 +229,20 @@ public:
   /// selects checks for upgrade to error.
   GlobList &getWarningAsErrorFilter();
 
+  /// \brief Returns \c true if the check with the ID \p CheckID is enabled
+  /// by the check filter of the \c CurrentFile. The result is cached per ID.
+  bool isCheckEnabled(unsigned CheckID) {
+    return matchCached(CheckFilterByID, getChecksFilter(), CheckID);
+  }
+
+  /// \brief Returns \c true if the warnings of the check with the ID
+  /// \p CheckID are upgraded to errors for the \c CurrentFile. The result is
+  /// cached per ID.
+  bool isWarningAsError(unsigned CheckID) {
+    return matchCached(WarningAsErrorFilterByID, getWarningAsErrorFilter(),
+                       CheckID);
+  }
+
   /// \brief Returns global options.
   const ClangTidyGlobalOptions &getGlobalOptions() const;
 
@@ -157,6 +255,13 @@ public:
   /// \c CurrentFile.
   ClangTidyOptions getOptionsForFile(StringRef File) const;
 
+  /// \brief Returns the check options for \c CurrentFile, resolved for fast
+  /// lookup. The table is reused while consecutive files share the same check
+  /// options.
+  const CheckOptionTable &getCheckOptionTable() const {
+    return *CheckOptionValues;
+  }
+
   /// \brief Returns \c ClangTidyStats containing issued and ignored diagnostic
   /// counters.
   const ClangTidyStats &getStats() const { return Stats; }
@@ -167,6 +272,15 @@ public:
   /// \brief Clears collected errors.
   void clearErrors() { Errors.clear(); }
 
+  /// \brief Records a summary of \p CheckName for the location \p Loc in the
+  /// current translation unit.
+  void summarize(StringRef CheckName, StringRef Key, StringRef Value,
+                 SourceLocation Loc);
+
+  /// \brief Returns all summaries recorded so far, in the order they were
+  /// recorded.
+  const std::vector<CheckSummary> &getSummaries() const { return Summaries; }
+
   /// \brief Set the output struct for profile data.
   ///
   /// Setting a non-null pointer here will enable profile collection in
@@ -196,22 +310,43 @@ private:
   /// \brief Store an \p Error.
   void storeError(const ClangTidyError &Error);
 
+  /// \brief Returns whether \p Filter contains the check with the ID
+  /// \p CheckID, using and filling \p Cache.
+  bool matchCached(std::vector<char> &Cache, GlobList &Filter,
+                   unsigned CheckID);
+
   std::vector<ClangTidyError> Errors;
+  std::vector<CheckSummary> Summaries;
   DiagnosticsEngine *DiagEngine;
   std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider;
 
   std::string CurrentFile;
   ClangTidyOptions CurrentOptions;
+  std::unique_ptr<CheckOptionTable> CheckOptionValues;
   std::unique_ptr<GlobList> CheckFilter;
   std::unique_ptr<GlobList> WarningAsErrorFilter;
+  std::string CheckFilterGlobs;
+  std::string WarningAsErrorFilterGlobs;
+  // Per check ID: 0 if not matched yet, 1 if excluded, 2 if included.
+  std::vector<char> CheckFilterByID;
+  std::vector<char> WarningAsErrorFilterByID;
 
   LangOptions LangOpts;
 
+  std::unique_ptr<DeclRefIndex> RefIndex;
+  std::unique_ptr<CommentIndex> Comments;
+  std::unique_ptr<ScopedParentMap> Parents;
+  std::unique_ptr<IncludeDirectives> Includes;
+  std::unique_ptr<NoLintIndex> NoLint;
+
+  HeaderVerdictCache HeaderVerdicts;
+
   ClangTidyStats Stats;
 
   std::string CurrentBuildDirectory;
 
-  llvm::DenseMap<unsigned, std::string> CheckNamesByDiagnosticID;
+  CheckNameTable CheckNames;
+  llvm::DenseMap<unsigned, unsigned> CheckIDsByDiagnosticID;
 
   ProfileData *Profile;
 };
@@ -237,6 +372,18 @@ public:
 private:
   void finalizeLastError();
 
+  /// \brief Returns the ID of the check reporting the diagnostic \p Info, or
+  /// of the clang diagnostic group it belongs to.
+  unsigned getCheckID(DiagnosticsEngine::Level DiagLevel,
+                      const Diagnostic &Info);
+
+  /// \brief Converts the diagnostic or note at \p Loc to the message, notes
+  /// and fixes of the last error.
+  void renderDiagnostic(SourceLocation Loc, DiagnosticsEngine::Level DiagLevel,
+                        StringRef Message, ArrayRef<CharSourceRange> Ranges,
+                        ArrayRef<FixItHint> FixIts,
+                        const SourceManager *Sources);
+
   void removeIncompatibleErrors(SmallVectorImpl<ClangTidyError> &Errors) const;
 
   /// \brief Returns the \c HeaderFilter constructed for the options set in the
@@ -248,6 +395,16 @@ private:
   void checkFilters(SourceLocation Location);
   bool passesLineFilter(StringRef FileName, unsigned LineNumber) const;
 
+  /// \brief If the diagnostic \p Info with the formatted \p Message is
+  /// located in a header, remembers the header and the start of its key in
+  /// the header verdicts, to be recorded once the last error is kept.
+  void setLastErrorHeader(const Diagnostic &Info, StringRef Message);
+
+  /// \brief Returns true if the last error, which is kept, is located in a
+  /// header and has already been reported there with the same notes, by this
+  /// or an earlier translation unit. Otherwise, records it.
+  bool isDuplicateHeaderError();
+
   ClangTidyContext &Context;
   std::unique_ptr<DiagnosticsEngine> Diags;
   SmallVector<ClangTidyError, 8> Errors;
@@ -255,6 +412,25 @@ private:
   bool LastErrorRelatesToUserCode;
   bool LastErrorPassesLineFilter;
   bool LastErrorWasIgnored;
+  /// \brief The check ID of the last error in \c Errors.
+  unsigned LastErrorCheckID;
+  /// \brief The header of the last error, if it is located in one, and the
+  /// location, ID and message identifying it there.
+  const SourceManager *LastErrorHeaderSources;
+  FileID LastErrorHeader;
+  std::string LastErrorHeaderKey;
+
+  /// \brief A diagnostic or note of the last error, which is rendered once the
+  /// error is known to be kept.
+  struct DeferredDiagnostic {
+    SourceLocation Loc;
+    DiagnosticsEngine::Level Level;
+    std::string Message;
+    std::vector<CharSourceRange> Ranges;
+    std::vector<FixItHint> FixIts;
+    const SourceManager *Sources;
+  };
+  std::vector<DeferredDiagnostic> DeferredDiagnostics;
 };
 
 } // end namespace tidy
@@ -10,6 +10,7 @@
 #include "ClangTidyOptions.h"
 #include "ClangTidyModuleRegistry.h"
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Errc.h"
@@ -88,12 +89,26 @@ template <> struct MappingTraits<ClangTidyOptions> {
     IO.mapOptional("Checks", Options.Checks);
     IO.mapOptional("WarningsAsErrors", Options.WarningsAsErrors);
     IO.mapOptional("HeaderFilterRegex", Options.HeaderFilterRegex);
+    IO.mapOptional("SkipHeaders", Options.SkipHeaders);
     IO.mapOptional("AnalyzeTemporaryDtors", Options.AnalyzeTemporaryDtors);
+    IO.mapOptional("AnalyzerMaxNodes", Options.AnalyzerMaxNodes);
+    IO.mapOptional("AnalyzerMaxNodesPerTU", Options.AnalyzerMaxNodesPerTU);
+    IO.mapOptional("AnalyzerLineFilterOnly", Options.AnalyzerLineFilterOnly);
     IO.mapOptional("User", Options.User);
     IO.mapOptional("CheckOptions", NOpts->Options);
     IO.mapOptional("ExtraArgs", Options.ExtraArgs);
     IO.mapOptional("ExtraArgsBefore", Options.ExtraArgsBefore);
   }
+
+  static StringRef validate(IO &IO, ClangTidyOptions &Options) {
+    if (Options.SkipHeaders && *Options.SkipHeaders != "none" &&
+        *Options.SkipHeaders != "system" &&
+        *Options.SkipHeaders != "filtered" &&
+        *Options.SkipHeaders != "analyzed")
+      return "SkipHeaders must be one of 'none', 'system', 'filtered' or "
+             "'analyzed'";
+    return StringRef();
+  }
 };
 
 } // namespace yaml
@@ -108,7 +123,11 @@ ClangTidyOptions ClangTidyOptions::getDefaults() {
   Options.WarningsAsErrors = "";
   Options.HeaderFilterRegex = "";
   Options.SystemHeaders = false;
+  Options.SkipHeaders = "none";
   Options.AnalyzeTemporaryDtors = false;
+  Options.AnalyzerMaxNodes = 0;
+  Options.AnalyzerMaxNodesPerTU = 0;
+  Options.AnalyzerLineFilterOnly = false;
   Options.User = llvm::None;
   for (ClangTidyModuleRegistry::iterator I = ClangTidyModuleRegistry::begin(),
                                          E = ClangTidyModuleRegistry::end();
@@ -147,7 +166,11 @@ ClangTidyOptions::mergeWith(const ClangTidyOptions &Other) const {
   mergeCommaSeparatedLists(Result.WarningsAsErrors, Other.WarningsAsErrors);
   overrideValue(Result.HeaderFilterRegex, Other.HeaderFilterRegex);
   overrideValue(Result.SystemHeaders, Other.SystemHeaders);
+  overrideValue(Result.SkipHeaders, Other.SkipHeaders);
   overrideValue(Result.AnalyzeTemporaryDtors, Other.AnalyzeTemporaryDtors);
+  overrideValue(Result.AnalyzerMaxNodes, Other.AnalyzerMaxNodes);
+  overrideValue(Result.AnalyzerMaxNodesPerTU, Other.AnalyzerMaxNodesPerTU);
+  overrideValue(Result.AnalyzerLineFilterOnly, Other.AnalyzerLineFilterOnly);
   overrideValue(Result.User, Other.User);
   mergeVectors(Result.ExtraArgs, Other.ExtraArgs);
   mergeVectors(Result.ExtraArgsBefore, Other.ExtraArgsBefore);
@@ -217,47 +240,79 @@ FileOptionsProvider::FileOptionsProvider(
     : DefaultOptionsProvider(GlobalOptions, DefaultOptions),
       OverrideOptions(OverrideOptions), ConfigHandlers(ConfigHandlers) {}
 
-// FIXME: This method has some common logic with clang::format::getStyle().
-// Consider pulling out common bits to a findParentFileWithName function or
-// similar.
 std::vector<OptionsSource>
 FileOptionsProvider::getRawOptions(StringRef FileName) {
   DEBUG(llvm::dbgs() << "Getting options for file " << FileName << "...\n");
+  return getDirectoryOptions(llvm::sys::path::parent_path(FileName))
+      ->RawOptions;
+}
+
+ClangTidyOptions FileOptionsProvider::getOptions(StringRef FileName) {
+  DEBUG(llvm::dbgs() << "Getting options for file " << FileName << "...\n");
+  return getDirectoryOptions(llvm::sys::path::parent_path(FileName))
+      ->EffectiveOptions;
+}
+
+bool FileOptionsProvider::isUpToDate(const DirectoryOptions &Options) {
+  if (Options.ConfigFile.empty())
+    return true;
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(Options.ConfigFile, Status))
+    return false;
+  return Status.getLastModificationTime() == Options.ModificationTime;
+}
+
+// FIXME: This method has some common logic with clang::format::getStyle().
+// Consider pulling out common bits to a findParentFileWithName function or
+// similar.
+std::shared_ptr<const FileOptionsProvider::DirectoryOptions>
+FileOptionsProvider::getDirectoryOptions(StringRef Directory) {
+  std::lock_guard<std::mutex> Lock(CacheMutex);
 
-  std::vector<OptionsSource> RawOptions =
-      DefaultOptionsProvider::getRawOptions(FileName);
-  OptionsSource CommandLineOptions(OverrideOptions,
-                                   OptionsSourceTypeCheckCommandLineOption);
   // Look for a suitable configuration file in all parent directories of the
   // file. Start with the immediate parent directory and move up.
-  StringRef Path = llvm::sys::path::parent_path(FileName);
-  for (StringRef CurrentPath = Path; !CurrentPath.empty();
+  std::shared_ptr<const DirectoryOptions> Result;
+  SmallVector<StringRef, 8> UncachedPaths;
+  llvm::Optional<OptionsSource> Config;
+  for (StringRef CurrentPath = Directory; !CurrentPath.empty();
        CurrentPath = llvm::sys::path::parent_path(CurrentPath)) {
-    llvm::Optional<OptionsSource> Result;
-
     auto Iter = CachedOptions.find(CurrentPath);
-    if (Iter != CachedOptions.end())
+    if (Iter != CachedOptions.end() && isUpToDate(*Iter->second)) {
       Result = Iter->second;
+      break;
+    }
+    UncachedPaths.push_back(CurrentPath);
+    Config = tryReadConfigFile(CurrentPath);
+    if (Config)
+      break;
+  }
 
-    if (!Result)
-      Result = tryReadConfigFile(CurrentPath);
-
-    if (Result) {
-      // Store cached value for all intermediate directories.
-      while (Path != CurrentPath) {
-        DEBUG(llvm::dbgs() << "Caching configuration for path " << Path
-                           << ".\n");
-        CachedOptions[Path] = *Result;
-        Path = llvm::sys::path::parent_path(Path);
+  if (!Result) {
+    auto Options = std::make_shared<DirectoryOptions>();
+    Options->RawOptions = DefaultOptionsProvider::getRawOptions(Directory);
+    if (Config) {
+      llvm::sys::fs::file_status Status;
+      if (!llvm::sys::fs::status(Config->second, Status)) {
+        Options->ConfigFile = Config->second;
+        Options->ModificationTime = Status.getLastModificationTime();
       }
-      CachedOptions[Path] = *Result;
-
-      RawOptions.push_back(*Result);
-      break;
+      Options->RawOptions.push_back(std::move(*Config));
     }
+    Options->RawOptions.emplace_back(OverrideOptions,
+                                     OptionsSourceTypeCheckCommandLineOption);
+    for (const OptionsSource &Source : Options->RawOptions)
+      Options->EffectiveOptions =
+          Options->EffectiveOptions.mergeWith(Source.first);
+    Result = std::move(Options);
   }
-  RawOptions.push_back(CommandLineOptions);
-  return RawOptions;
+
+  // Store the result for all directories probed, including those without a
+  // configuration file.
+  for (StringRef Path : UncachedPaths) {
+    DEBUG(llvm::dbgs() << "Caching configuration for path " << Path << ".\n");
+    CachedOptions[Path] = Result;
+  }
+  return Result;
 }
 
 llvm::Optional<OptionsSource>
@@ -315,6 +370,46 @@ std::error_code parseLineFilter(StringRef LineFilter,
   return Input.error();
 }
 
+std::vector<std::string> parseCheckOptionList(StringRef Value) {
+  SmallVector<StringRef, 4> Names;
+  Value.split(Names, ";");
+  std::vector<std::string> Result;
+  for (StringRef &Name : Names) {
+    Name = Name.trim();
+    if (!Name.empty())
+      Result.push_back(Name);
+  }
+  return Result;
+}
+
+CheckOptionTable::Value::Value(StringRef Text)
+    : Text(Text), SignedValue(0), UnsignedValue(0) {
+  IsSigned = !Text.getAsInteger(10, SignedValue);
+  IsUnsigned = !Text.getAsInteger(10, UnsignedValue);
+}
+
+const std::vector<std::string> &
+CheckOptionTable::Value::getStringList() const {
+  if (!StringList)
+    StringList = llvm::make_unique<std::vector<std::string>>(
+        parseCheckOptionList(Text));
+  return *StringList;
+}
+
+CheckOptionTable::CheckOptionTable(const ClangTidyOptions::OptionMap &Options)
+    : Options(Options) {
+  for (const auto &Option : Options)
+    Values.try_emplace(Option.first, Option.second);
+}
+
+const CheckOptionTable::Value *CheckOptionTable::find(StringRef Prefix,
+                                                      StringRef Name) const {
+  SmallString<128> Key(Prefix);
+  Key += Name;
+  auto Iter = Values.find(Key);
+  return Iter == Values.end() ? nullptr : &Iter->second;
+}
+
 llvm::ErrorOr<ClangTidyOptions> parseConfiguration(StringRef Config) {
   llvm::yaml::Input Input(Config);
   ClangTidyOptions Options;
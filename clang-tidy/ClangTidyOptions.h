@@ -13,11 +13,16 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Chrono.h"
 #include "llvm/Support/ErrorOr.h"
 #include <functional>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <system_error>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -72,9 +77,34 @@ struct ClangTidyOptions {
   /// \brief Output warnings from system headers matching \c HeaderFilterRegex.
   llvm::Optional<bool> SystemHeaders;
 
+  /// \brief Skips matching the top-level declarations of headers whose
+  /// warnings are not displayed.
+  ///
+  /// "system" skips system headers, unless \c SystemHeaders is set. "filtered"
+  /// skips all headers not matching \c HeaderFilterRegex. "analyzed" also
+  /// skips the headers analyzed by an earlier translation unit, losing the
+  /// warnings that depend on the includer. "none" matches all declarations.
+  /// Checks can opt out using \c ClangTidyCheck::needsAllHeaders(). The
+  /// static analyzer does not analyze skipped declarations either.
+  llvm::Optional<std::string> SkipHeaders;
+
   /// \brief Turns on temporary destructor-based analysis.
   llvm::Optional<bool> AnalyzeTemporaryDtors;
 
+  /// \brief Maximum number of nodes the static analyzer explores per analyzed
+  /// function. 0 keeps the default of the analyzer.
+  llvm::Optional<unsigned> AnalyzerMaxNodes;
+
+  /// \brief Maximum number of nodes the static analyzer explores per
+  /// translation unit, split evenly between the analyzed functions. A function
+  /// never gets more nodes than \c AnalyzerMaxNodes or the default of the
+  /// analyzer. 0 means no limit.
+  llvm::Optional<unsigned> AnalyzerMaxNodesPerTU;
+
+  /// \brief Only runs the static analyzer on the top-level declarations of the
+  /// main file overlapping its line ranges in \c ClangTidyGlobalOptions.
+  llvm::Optional<bool> AnalyzerLineFilterOnly;
+
   /// \brief Specifies the name or e-mail of the user running clang-tidy.
   ///
   /// This option is used, for example, to place the correct user name in TODO()
@@ -96,6 +126,67 @@ struct ClangTidyOptions {
   llvm::Optional<ArgList> ExtraArgsBefore;
 };
 
+/// \brief Splits a semicolon-separated list of strings, trimming whitespace
+/// around the elements and dropping empty ones.
+std::vector<std::string> parseCheckOptionList(llvm::StringRef Value);
+
+/// \brief The check options of one configuration, resolved once and shared by
+/// the checks created for each translation unit using that configuration.
+///
+/// Options are looked up without building key strings. Integer values are
+/// parsed when the table is built and string lists the first time they are
+/// requested.
+class CheckOptionTable {
+public:
+  /// \brief A single check option value.
+  class Value {
+  public:
+    explicit Value(llvm::StringRef Text);
+
+    const std::string &getText() const { return Text; }
+
+    /// \brief Returns the value parsed as the integral type \p T, or \c None
+    /// if it is not a valid \p T.
+    template <typename T> llvm::Optional<T> getAs() const {
+      static_assert(std::is_integral<T>::value, "T must be integral");
+      if (std::numeric_limits<T>::is_signed) {
+        if (!IsSigned || static_cast<T>(SignedValue) != SignedValue)
+          return llvm::None;
+        return static_cast<T>(SignedValue);
+      }
+      if (!IsUnsigned || static_cast<unsigned long long>(static_cast<T>(
+                             UnsignedValue)) != UnsignedValue)
+        return llvm::None;
+      return static_cast<T>(UnsignedValue);
+    }
+
+    /// \brief Returns the value parsed with \c parseCheckOptionList.
+    const std::vector<std::string> &getStringList() const;
+
+  private:
+    std::string Text;
+    bool IsSigned;
+    bool IsUnsigned;
+    long long SignedValue;
+    unsigned long long UnsignedValue;
+    mutable std::unique_ptr<std::vector<std::string>> StringList;
+  };
+
+  explicit CheckOptionTable(const ClangTidyOptions::OptionMap &Options);
+
+  /// \brief Returns \c true if the table was built from \p Options.
+  bool isFor(const ClangTidyOptions::OptionMap &Options) const {
+    return Options == this->Options;
+  }
+
+  /// \brief Returns the option named \p Prefix + \p Name, or \c nullptr.
+  const Value *find(llvm::StringRef Prefix, llvm::StringRef Name) const;
+
+private:
+  ClangTidyOptions::OptionMap Options;
+  llvm::StringMap<Value> Values;
+};
+
 /// \brief Abstract interface for retrieving various ClangTidy options.
 class ClangTidyOptionsProvider {
 public:
@@ -125,7 +216,9 @@ public:
 
   /// \brief Returns options applying to a specific translation unit with the
   /// specified \p FileName.
-  ClangTidyOptions getOptions(llvm::StringRef FileName);
+  ///
+  /// The default implementation merges the result of \c getRawOptions().
+  virtual ClangTidyOptions getOptions(llvm::StringRef FileName);
 };
 
 /// \brief Implementation of the \c ClangTidyOptionsProvider interface, which
@@ -233,14 +326,50 @@ public:
 
   std::vector<OptionsSource> getRawOptions(llvm::StringRef FileName) override;
 
+  /// \brief Returns the options of the directory containing \p FileName,
+  /// merged once per configuration file.
+  ClangTidyOptions getOptions(llvm::StringRef FileName) override;
+
 protected:
+  /// \brief The options resolved for a directory.
+  ///
+  /// All directories using the same configuration file share one instance.
+  struct DirectoryOptions {
+    /// \brief The sources of the options in order of increasing priority.
+    std::vector<OptionsSource> RawOptions;
+    /// \brief \c RawOptions merged.
+    ClangTidyOptions EffectiveOptions;
+    /// \brief The configuration file found, or an empty string if no parent
+    /// directory has one.
+    std::string ConfigFile;
+    /// \brief The modification time of \c ConfigFile when it was read.
+    llvm::sys::TimePoint<> ModificationTime;
+  };
+
   /// \brief Try to read configuration files from \p Directory using registered
   /// \c ConfigHandlers.
   llvm::Optional<OptionsSource> tryReadConfigFile(llvm::StringRef Directory);
 
-  llvm::StringMap<OptionsSource> CachedOptions;
+  /// \brief Returns the options of \p Directory, looking for a configuration
+  /// file in the directories not cached yet.
+  ///
+  /// Directories without a configuration file are cached as well, so each
+  /// directory is probed once. A cached configuration file is read again when
+  /// its modification time changes; configuration files created after their
+  /// directory was probed are not picked up.
+  std::shared_ptr<const DirectoryOptions>
+  getDirectoryOptions(llvm::StringRef Directory);
+
   ClangTidyOptions OverrideOptions;
   ConfigFileHandlers ConfigHandlers;
+
+private:
+  bool isUpToDate(const DirectoryOptions &Options);
+
+  /// \brief Guards \c CachedOptions, so that the provider can be shared by
+  /// threads processing different files.
+  std::mutex CacheMutex;
+  llvm::StringMap<std::shared_ptr<const DirectoryOptions>> CachedOptions;
 };
 
 /// \brief Parses LineFilter from JSON and stores it to the \p Options.
@@ -0,0 +1,69 @@
+//===--- CommentIndex.cpp - clang-tidy ------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CommentIndex.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include <algorithm>
+
+namespace clang {
+namespace tidy {
+
+CommentIndex::CommentIndex(const SourceManager &SM, const LangOptions &LangOpts)
+    : SM(SM), LangOpts(LangOpts) {}
+
+ArrayRef<CommentIndex::Comment> CommentIndex::getComments(FileID FID) {
+  auto It = CommentsByFile.find(FID);
+  if (It != CommentsByFile.end())
+    return It->second;
+
+  std::vector<Comment> &Comments = CommentsByFile[FID];
+  bool Invalid = false;
+  StringRef Buffer = SM.getBufferData(FID, &Invalid);
+  if (Invalid)
+    return Comments;
+
+  SourceLocation FileStart = SM.getLocForStartOfFile(FID);
+  Lexer TheLexer(FileStart, LangOpts, Buffer.begin(), Buffer.begin(),
+                 Buffer.end());
+  TheLexer.SetCommentRetentionState(true);
+
+  Token Tok;
+  while (!TheLexer.LexFromRawLexer(Tok) && Tok.isNot(tok::eof)) {
+    if (Tok.isNot(tok::comment))
+      continue;
+    unsigned Offset = SM.getFileOffset(Tok.getLocation());
+    Comments.push_back({Tok.getLocation(), Offset,
+                        Buffer.substr(Offset, Tok.getLength())});
+  }
+  return Comments;
+}
+
+ArrayRef<CommentIndex::Comment>
+CommentIndex::getCommentsInRange(CharSourceRange Range) {
+  if (Range.isInvalid())
+    return None;
+
+  std::pair<FileID, unsigned> Begin = SM.getDecomposedLoc(Range.getBegin()),
+                              End = SM.getDecomposedLoc(Range.getEnd());
+  if (Begin.first != End.first)
+    return None;
+
+  ArrayRef<Comment> Comments = getComments(Begin.first);
+  auto ByOffset = [](const Comment &C, unsigned Offset) {
+    return C.Offset < Offset;
+  };
+  auto First = std::lower_bound(Comments.begin(), Comments.end(),
+                                Begin.second, ByOffset);
+  auto Last = std::lower_bound(First, Comments.end(), End.second, ByOffset);
+  return Comments.slice(First - Comments.begin(), Last - First);
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,64 @@
+//===--- CommentIndex.h - clang-tidy ----------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_COMMENTINDEX_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_COMMENTINDEX_H
+
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <vector>
+
+namespace clang {
+
+class SourceManager;
+
+namespace tidy {
+
+/// \brief Index of the comment tokens of the files in a translation unit.
+///
+/// Each file is raw-lexed once, the first time its comments are requested,
+/// and its comments are kept sorted by offset. Looking up the comments in a
+/// range is then a binary search instead of lexing the range again.
+class CommentIndex {
+public:
+  /// \brief A comment token.
+  struct Comment {
+    SourceLocation Loc;
+    /// \brief The offset of the comment in its file.
+    unsigned Offset;
+    /// \brief The comment text, including the comment markers.
+    StringRef Text;
+  };
+
+  CommentIndex(const SourceManager &SM, const LangOptions &LangOpts);
+
+  const SourceManager &getSourceManager() const { return SM; }
+
+  /// \brief Returns all comments in \p FID, sorted by offset.
+  ArrayRef<Comment> getComments(FileID FID);
+
+  /// \brief Returns the comments starting within the file range \p Range,
+  /// sorted by offset.
+  ///
+  /// Returns no comments if the range is invalid or spans multiple files.
+  ArrayRef<Comment> getCommentsInRange(CharSourceRange Range);
+
+private:
+  const SourceManager &SM;
+  LangOptions LangOpts;
+  llvm::DenseMap<FileID, std::vector<Comment>> CommentsByFile;
+};
+
+} // namespace tidy
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_COMMENTINDEX_H
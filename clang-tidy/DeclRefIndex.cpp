@@ -0,0 +1,92 @@
+//===--- DeclRefIndex.cpp - clang-tidy ------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DeclRefIndex.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace clang {
+namespace tidy {
+
+class DeclRefIndex::Builder : public RecursiveASTVisitor<Builder> {
+public:
+  explicit Builder(DeclRefIndex &Index) : Index(Index) {}
+
+  // Visit the same nodes as the AST matchers do.
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool TraverseStmt(Stmt *S) {
+    const auto *Call = dyn_cast_or_null<CallExpr>(S);
+    if (Call)
+      EnclosingCalls.push_back(Call);
+    bool Result = RecursiveASTVisitor<Builder>::TraverseStmt(S);
+    if (Call)
+      EnclosingCalls.pop_back();
+    return Result;
+  }
+
+  bool VisitCallExpr(CallExpr *Call) {
+    if (const Decl *Callee = Call->getCalleeDecl())
+      Index.Calls[Callee].push_back(Call);
+    return true;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *Ref) {
+    const Decl *D = Ref->getDecl();
+    bool InCallToReferenced = false;
+    for (const CallExpr *Call : EnclosingCalls) {
+      if (Call->getCalleeDecl() == D) {
+        InCallToReferenced = true;
+        break;
+      }
+    }
+    Index.References[D].push_back(
+        {Ref, !EnclosingCalls.empty(), InCallToReferenced});
+    return true;
+  }
+
+private:
+  DeclRefIndex &Index;
+  llvm::SmallVector<const CallExpr *, 8> EnclosingCalls;
+};
+
+DeclRefIndex::DeclRefIndex(ASTContext &Context) : Context(Context) {
+  Builder(*this).TraverseDecl(Context.getTranslationUnitDecl());
+}
+
+llvm::ArrayRef<DeclRefIndex::Reference>
+DeclRefIndex::references(const Decl *D) const {
+  auto It = References.find(D);
+  if (It == References.end())
+    return llvm::None;
+  return It->second;
+}
+
+llvm::ArrayRef<const CallExpr *> DeclRefIndex::callsTo(const Decl *D) const {
+  auto It = Calls.find(D);
+  if (It == Calls.end())
+    return llvm::None;
+  return It->second;
+}
+
+bool DeclRefIndex::isReferencedOutsideOfCall(const Decl *D) const {
+  return llvm::any_of(references(D),
+                      [](const Reference &R) { return !R.InCall; });
+}
+
+bool DeclRefIndex::isReferencedOutsideOfCallToItself(const Decl *D) const {
+  return llvm::any_of(references(D), [](const Reference &R) {
+    return !R.InCallToReferenced;
+  });
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,77 @@
+//===--- DeclRefIndex.h - clang-tidy ----------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_DECLREFINDEX_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_DECLREFINDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace clang {
+
+class ASTContext;
+class CallExpr;
+class Decl;
+class DeclRefExpr;
+
+namespace tidy {
+
+/// \brief Index of all ``DeclRefExpr``s and call expressions in a translation
+/// unit, keyed by the referenced declaration.
+///
+/// The index is built with a single traversal of the AST, visiting template
+/// instantiations and implicit code the same way AST matchers do. It allows
+/// checks to answer "who references this declaration" without matching the
+/// whole translation unit again for every candidate.
+class DeclRefIndex {
+public:
+  /// \brief A single reference to a declaration.
+  struct Reference {
+    const DeclRefExpr *Ref;
+    /// \brief \c true if the reference has a \c CallExpr ancestor.
+    bool InCall;
+    /// \brief \c true if the reference has a \c CallExpr ancestor whose callee
+    /// is the referenced declaration itself.
+    bool InCallToReferenced;
+  };
+
+  /// \brief Builds the index for the translation unit of \p Context.
+  explicit DeclRefIndex(ASTContext &Context);
+
+  /// \brief Returns the \c ASTContext the index was built for.
+  const ASTContext &getASTContext() const { return Context; }
+
+  /// \brief Returns all references to \p D in traversal order.
+  llvm::ArrayRef<Reference> references(const Decl *D) const;
+
+  /// \brief Returns all call expressions whose callee declaration is \p D in
+  /// traversal order.
+  llvm::ArrayRef<const CallExpr *> callsTo(const Decl *D) const;
+
+  /// \brief Returns \c true if \p D is referenced outside of any call
+  /// expression.
+  bool isReferencedOutsideOfCall(const Decl *D) const;
+
+  /// \brief Returns \c true if \p D is referenced other than from within a
+  /// call to \p D itself.
+  bool isReferencedOutsideOfCallToItself(const Decl *D) const;
+
+private:
+  class Builder;
+
+  const ASTContext &Context;
+  llvm::DenseMap<const Decl *, llvm::SmallVector<Reference, 4>> References;
+  llvm::DenseMap<const Decl *, llvm::SmallVector<const CallExpr *, 4>> Calls;
+};
+
+} // namespace tidy
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_DECLREFINDEX_H
@@ -0,0 +1,66 @@
+//===--- HeaderVerdictCache.cpp - clang-tidy ------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "HeaderVerdictCache.h"
+#include "ClangTidyOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+namespace tidy {
+
+void HeaderVerdictCache::startTranslationUnit(const ClangTidyOptions &Options) {
+  for (Header *H : AnalyzedHeaders)
+    H->Analyzed = true;
+  AnalyzedHeaders.clear();
+  CurrentHeaders.clear();
+  // Only the options that affect which diagnostics are reported and how.
+  OptionsHash = llvm::hash_combine(
+      Options.Checks.getValueOr(""), Options.WarningsAsErrors.getValueOr(""),
+      Options.HeaderFilterRegex.getValueOr(""),
+      Options.SystemHeaders.getValueOr(false),
+      Options.SkipHeaders.getValueOr(""),
+      Options.AnalyzeTemporaryDtors.getValueOr(false),
+      llvm::hash_combine_range(Options.CheckOptions.begin(),
+                               Options.CheckOptions.end()));
+}
+
+HeaderVerdictCache::Header &
+HeaderVerdictCache::getHeader(const SourceManager &SM, FileID FID) {
+  Header *&H = CurrentHeaders[FID];
+  if (!H) {
+    SourceLocation Start = SM.getLocForStartOfFile(FID);
+    SmallString<256> HeaderKey;
+    llvm::raw_svector_ostream OS(HeaderKey);
+    OS << SM.getFilename(Start) << '\0'
+       << size_t(llvm::hash_value(SM.getBufferData(FID))) << '\0'
+       << SM.isInSystemHeader(Start) << '\0' << OptionsHash;
+    H = &Headers[OS.str()];
+  }
+  return *H;
+}
+
+bool HeaderVerdictCache::insert(const SourceManager &SM, FileID FID,
+                                StringRef Key) {
+  return getHeader(SM, FID).Diagnostics.insert(Key).second;
+}
+
+bool HeaderVerdictCache::isAnalyzedBefore(const SourceManager &SM,
+                                          FileID FID) {
+  Header &H = getHeader(SM, FID);
+  if (H.Analyzed)
+    return true;
+  AnalyzedHeaders.push_back(&H);
+  return false;
+}
+
+} // namespace tidy
+} // namespace clang
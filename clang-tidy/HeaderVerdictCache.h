@@ -0,0 +1,76 @@
+//===--- HeaderVerdictCache.h - clang-tidy ----------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_HEADERVERDICTCACHE_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_HEADERVERDICTCACHE_H
+
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include <vector>
+
+namespace clang {
+
+class SourceManager;
+
+namespace tidy {
+
+struct ClangTidyOptions;
+
+/// \brief Remembers the headers analyzed and the diagnostics reported in them
+/// by the translation units of a run, so that a header included by many
+/// translation units has each of its diagnostics reported once, and can be
+/// skipped by the translation units after the first one that analyzed it.
+///
+/// A header is identified by its name, a hash of its contents, whether it is a
+/// system header and the options it is analyzed with. A header analyzed with
+/// different options, or changed between translation units, starts with no
+/// recorded diagnostics.
+class HeaderVerdictCache {
+public:
+  HeaderVerdictCache() : OptionsHash(0) {}
+
+  /// \brief Should be called when starting to process a new translation unit
+  /// that is analyzed with \p Options.
+  void startTranslationUnit(const ClangTidyOptions &Options);
+
+  /// \brief Records the diagnostic identified by \p Key in the header \p FID
+  /// of the current translation unit.
+  ///
+  /// Returns false if the same diagnostic has already been recorded for this
+  /// header, i.e. it is a duplicate that doesn't need to be reported again.
+  bool insert(const SourceManager &SM, FileID FID, StringRef Key);
+
+  /// \brief Returns \c true if the header \p FID was analyzed by an earlier
+  /// translation unit. Otherwise, records that the current translation unit
+  /// analyzes it.
+  bool isAnalyzedBefore(const SourceManager &SM, FileID FID);
+
+private:
+  struct Header {
+    Header() : Analyzed(false) {}
+    llvm::StringSet<> Diagnostics;
+    /// \brief Set once the translation unit that analyzed the header ends.
+    bool Analyzed;
+  };
+
+  Header &getHeader(const SourceManager &SM, FileID FID);
+
+  llvm::StringMap<Header> Headers;
+  llvm::DenseMap<FileID, Header *> CurrentHeaders;
+  /// \brief The headers analyzed by the current translation unit.
+  std::vector<Header *> AnalyzedHeaders;
+  size_t OptionsHash;
+};
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_HEADERVERDICTCACHE_H
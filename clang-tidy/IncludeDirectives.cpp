@@ -0,0 +1,63 @@
+//===--- IncludeDirectives.cpp - clang-tidy -------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IncludeDirectives.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Token.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace clang {
+namespace tidy {
+
+class IncludeDirectives::Callbacks : public PPCallbacks {
+public:
+  explicit Callbacks(IncludeDirectives &Includes) : Includes(Includes) {}
+
+  void InclusionDirective(SourceLocation HashLocation,
+                          const Token &IncludeToken, StringRef FileName,
+                          bool IsAngled, CharSourceRange FileNameRange,
+                          const FileEntry * /*IncludedFile*/,
+                          StringRef /*SearchPath*/, StringRef /*RelativePath*/,
+                          const Module * /*ImportedModule*/) override {
+    FileID FID = Includes.SM.getFileID(HashLocation);
+    Includes.DirectivesByFile[FID].push_back(
+        {FileName.str(), IsAngled, HashLocation, IncludeToken.getEndLoc()});
+  }
+
+private:
+  IncludeDirectives &Includes;
+};
+
+IncludeDirectives::IncludeDirectives(const SourceManager &SM) : SM(SM) {}
+
+IncludeDirectives::~IncludeDirectives() {}
+
+std::unique_ptr<PPCallbacks> IncludeDirectives::createPPCallbacks() {
+  return llvm::make_unique<Callbacks>(*this);
+}
+
+ArrayRef<IncludeDirectives::Directive>
+IncludeDirectives::getDirectives(FileID FID) const {
+  auto It = DirectivesByFile.find(FID);
+  if (It == DirectivesByFile.end())
+    return None;
+  return It->second;
+}
+
+bool IncludeDirectives::isIncluded(FileID FID, StringRef FileName) const {
+  for (const Directive &D : getDirectives(FID)) {
+    if (D.FileName == FileName)
+      return true;
+  }
+  return false;
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,70 @@
+//===--- IncludeDirectives.h - clang-tidy -----------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_INCLUDEDIRECTIVES_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_INCLUDEDIRECTIVES_H
+
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class PPCallbacks;
+class SourceManager;
+
+namespace tidy {
+
+/// \brief The inclusion directives of all files in a translation unit.
+///
+/// The directives are recorded once per translation unit by a single set of
+/// preprocessor callbacks, and shared by all checks that insert includes.
+class IncludeDirectives {
+public:
+  /// \brief An inclusion directive.
+  struct Directive {
+    /// \brief The included file name as written, without quotes or brackets.
+    std::string FileName;
+    bool IsAngled;
+    SourceLocation HashLocation;
+    /// \brief The end of the last token of the directive.
+    SourceLocation EndLocation;
+  };
+
+  explicit IncludeDirectives(const SourceManager &SM);
+  ~IncludeDirectives();
+
+  const SourceManager &getSourceManager() const { return SM; }
+
+  /// \brief Creates the callbacks recording the directives, to be registered
+  /// with the preprocessor of the translation unit once.
+  std::unique_ptr<PPCallbacks> createPPCallbacks();
+
+  /// \brief Returns the inclusion directives of \p FID in source order.
+  ArrayRef<Directive> getDirectives(FileID FID) const;
+
+  /// \brief Returns \c true if \p FID contains an inclusion directive for
+  /// \p FileName as written.
+  bool isIncluded(FileID FID, StringRef FileName) const;
+
+private:
+  class Callbacks;
+
+  const SourceManager &SM;
+  llvm::DenseMap<FileID, std::vector<Directive>> DirectivesByFile;
+};
+
+} // namespace tidy
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_INCLUDEDIRECTIVES_H
@@ -0,0 +1,91 @@
+//===--- NoLintIndex.cpp - clang-tidy -------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "NoLintIndex.h"
+#include "ClangTidyDiagnosticConsumer.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace clang {
+namespace tidy {
+
+static const char NoLintMarker[] = "NOLINT";
+static const char NextLineSuffix[] = "NEXTLINE";
+
+NoLintIndex::NoLintIndex(const SourceManager &SM, const LangOptions &LangOpts)
+    : SM(SM), LangOpts(LangOpts) {}
+
+NoLintIndex::~NoLintIndex() {}
+
+bool NoLintIndex::isSuppressed(SourceLocation Loc, StringRef CheckName) {
+  std::pair<FileID, unsigned> Decomposed = SM.getDecomposedSpellingLoc(Loc);
+  const FileSuppressions &Suppressions = getSuppressions(Decomposed.first);
+  if (Suppressions.empty())
+    return false;
+
+  auto It = Suppressions.find(
+      SM.getLineNumber(Decomposed.first, Decomposed.second));
+  if (It == Suppressions.end())
+    return false;
+  for (const std::unique_ptr<GlobList> &Checks : It->second) {
+    if (!Checks || Checks->contains(CheckName))
+      return true;
+  }
+  return false;
+}
+
+const NoLintIndex::FileSuppressions &
+NoLintIndex::getSuppressions(FileID FID) {
+  auto It = SuppressionsByFile.find(FID);
+  if (It != SuppressionsByFile.end())
+    return It->second;
+
+  FileSuppressions &Suppressions = SuppressionsByFile[FID];
+  bool Invalid = false;
+  StringRef Buffer = SM.getBufferData(FID, &Invalid);
+  // Most files have no markers at all, don't lex those.
+  if (Invalid || Buffer.find(NoLintMarker) == StringRef::npos)
+    return Suppressions;
+
+  SourceLocation FileStart = SM.getLocForStartOfFile(FID);
+  Lexer TheLexer(FileStart, LangOpts, Buffer.begin(), Buffer.begin(),
+                 Buffer.end());
+  TheLexer.SetCommentRetentionState(true);
+
+  Token Tok;
+  while (!TheLexer.LexFromRawLexer(Tok) && Tok.isNot(tok::eof)) {
+    if (Tok.isNot(tok::comment))
+      continue;
+    unsigned Offset = SM.getFileOffset(Tok.getLocation());
+    StringRef Text = Buffer.substr(Offset, Tok.getLength());
+    for (size_t Pos = Text.find(NoLintMarker); Pos != StringRef::npos;
+         Pos = Text.find(NoLintMarker, Pos + 1)) {
+      unsigned Line = SM.getLineNumber(FID, Offset + Pos);
+      StringRef Rest = Text.substr(Pos + strlen(NoLintMarker));
+      if (Rest.startswith(NextLineSuffix)) {
+        ++Line;
+        Rest = Rest.drop_front(strlen(NextLineSuffix));
+      }
+
+      std::unique_ptr<GlobList> Checks;
+      if (Rest.startswith("(")) {
+        // A list without the closing parenthesis suppresses all checks.
+        size_t End = Rest.find(')');
+        if (End != StringRef::npos)
+          Checks = llvm::make_unique<GlobList>(Rest.substr(1, End - 1));
+      }
+      Suppressions[Line].push_back(std::move(Checks));
+    }
+  }
+  return Suppressions;
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,68 @@
+//===--- NoLintIndex.h - clang-tidy -----------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_NOLINTINDEX_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_NOLINTINDEX_H
+
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <vector>
+
+namespace clang {
+
+class SourceManager;
+
+namespace tidy {
+
+class GlobList;
+
+/// \brief Index of the NOLINT comments of the files in a translation unit.
+///
+/// A comment containing "NOLINT" suppresses diagnostics on its line, and a
+/// comment containing "NOLINTNEXTLINE" suppresses diagnostics on the following
+/// line. Either marker can be followed by a parenthesized, comma-separated list
+/// of check name globs, e.g. "NOLINT(google-*, misc-unused-parameters)", to
+/// suppress only the diagnostics of matching checks.
+///
+/// The comments of a file are raw-lexed once, the first time a diagnostic is
+/// reported in it, and only if the file contains a marker at all. Each
+/// suppression decision is then a lookup of the line of the diagnostic.
+class NoLintIndex {
+public:
+  NoLintIndex(const SourceManager &SM, const LangOptions &LangOpts);
+  ~NoLintIndex();
+
+  const SourceManager &getSourceManager() const { return SM; }
+
+  /// \brief Returns \c true if a NOLINT marker suppresses the diagnostics of
+  /// \p CheckName on the spelling line of \p Loc.
+  bool isSuppressed(SourceLocation Loc, StringRef CheckName);
+
+private:
+  /// \brief The check filters of the markers applying to a line. A null
+  /// filter suppresses all checks.
+  typedef std::vector<std::unique_ptr<GlobList>> LineSuppressions;
+  typedef llvm::DenseMap<unsigned, LineSuppressions> FileSuppressions;
+
+  /// \brief Returns the suppressions of \p FID by line number, indexing the
+  /// file on first use.
+  const FileSuppressions &getSuppressions(FileID FID);
+
+  const SourceManager &SM;
+  LangOptions LangOpts;
+  llvm::DenseMap<FileID, FileSuppressions> SuppressionsByFile;
+};
+
+} // namespace tidy
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_NOLINTINDEX_H
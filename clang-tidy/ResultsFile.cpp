@@ -0,0 +1,365 @@
+//===--- ResultsFile.cpp - clang-tidy -------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A results file consists of a header followed by five sections. All integers
+// are 32-bit little-endian, except for the diagnostic level and the
+// warning-as-error flag of each record, which are single bytes. Strings are
+// referred to by their index in the string table.
+//
+//   Header:          magic "CTRS", version, main file path, then the offsets
+//                    of the string table, the records, the record offsets,
+//                    the check index and the file index
+//   String table:    count, then the length and bytes of each string
+//   Records:         one per diagnostic, see writeRecord()
+//   Record offsets:  count, then the offset of each record relative to the
+//                    start of the records section
+//   Check index:     count, then for each check name the number of records
+//                    and their indices
+//   File index:      the same as the check index, for the file paths of the
+//                    diagnostic messages
+//
+//===----------------------------------------------------------------------===//
+
+#include "ResultsFile.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Path.h"
+#include <map>
+
+namespace clang {
+namespace tidy {
+
+namespace {
+
+const char Magic[] = {'C', 'T', 'R', 'S'};
+const uint32_t Version = 1;
+const unsigned HeaderSize = sizeof(Magic) + 7 * sizeof(uint32_t);
+
+/// \brief Assigns each distinct string an index in order of first use.
+class StringTable {
+public:
+  uint32_t add(StringRef S) {
+    auto Inserted = Indices.insert(std::make_pair(S, Strings.size()));
+    if (Inserted.second)
+      Strings.push_back(Inserted.first->getKey());
+    return Inserted.first->getValue();
+  }
+
+  ArrayRef<StringRef> getStrings() const { return Strings; }
+
+private:
+  llvm::StringMap<uint32_t> Indices;
+  std::vector<StringRef> Strings;
+};
+
+/// \brief Reads values from a results file, recording out-of-bounds reads
+/// instead of asserting, as results files come from other processes.
+class Reader {
+public:
+  Reader(StringRef Data, uint64_t Offset)
+      : Data(Data), Offset(Offset), Failed(false) {}
+
+  uint32_t read32() {
+    if (!check(4))
+      return 0;
+    uint32_t Value = llvm::support::endian::read32le(Data.data() + Offset);
+    Offset += 4;
+    return Value;
+  }
+
+  uint8_t read8() {
+    if (!check(1))
+      return 0;
+    return Data[Offset++];
+  }
+
+  StringRef readBytes(uint64_t Size) {
+    if (!check(Size))
+      return StringRef();
+    StringRef Bytes = Data.substr(Offset, Size);
+    Offset += Size;
+    return Bytes;
+  }
+
+  /// \brief Reads a string index and returns the string from \p Strings.
+  StringRef readString(ArrayRef<StringRef> Strings) {
+    uint32_t Index = read32();
+    if (Index >= Strings.size()) {
+      Failed = true;
+      return StringRef();
+    }
+    return Strings[Index];
+  }
+
+  bool failed() const { return Failed; }
+
+private:
+  bool check(uint64_t Size) {
+    if (Offset + Size > Data.size())
+      Failed = true;
+    return !Failed;
+  }
+
+  StringRef Data;
+  uint64_t Offset;
+  bool Failed;
+};
+
+} // namespace
+
+typedef llvm::support::endian::Writer<llvm::support::little> LEWriter;
+// Maps a string index to the indices of the records referring to it.
+typedef std::map<uint32_t, std::vector<uint32_t>> RecordIndex;
+
+static void writeMessage(LEWriter &W, StringTable &Strings,
+                         const tooling::DiagnosticMessage &Message) {
+  W.write<uint32_t>(Strings.add(Message.Message));
+  W.write<uint32_t>(Strings.add(Message.FilePath));
+  W.write<uint32_t>(Message.FileOffset);
+}
+
+static void writeRecord(LEWriter &W, StringTable &Strings,
+                        const ClangTidyError &Error) {
+  W.write<uint32_t>(Strings.add(Error.DiagnosticName));
+  W.write<uint8_t>(Error.DiagLevel);
+  W.write<uint8_t>(Error.IsWarningAsError);
+  W.write<uint32_t>(Strings.add(Error.BuildDirectory));
+  writeMessage(W, Strings, Error.Message);
+  W.write<uint32_t>(Error.Notes.size());
+  for (const tooling::DiagnosticMessage &Note : Error.Notes)
+    writeMessage(W, Strings, Note);
+  W.write<uint32_t>(Error.Fix.size());
+  for (const auto &FileAndReplacements : Error.Fix) {
+    W.write<uint32_t>(Strings.add(FileAndReplacements.first()));
+    W.write<uint32_t>(FileAndReplacements.second.size());
+    for (const tooling::Replacement &R : FileAndReplacements.second) {
+      W.write<uint32_t>(Strings.add(R.getFilePath()));
+      W.write<uint32_t>(R.getOffset());
+      W.write<uint32_t>(R.getLength());
+      W.write<uint32_t>(Strings.add(R.getReplacementText()));
+    }
+  }
+}
+
+static void writeIndex(LEWriter &W, const RecordIndex &Index) {
+  W.write<uint32_t>(Index.size());
+  for (const auto &Entry : Index) {
+    W.write<uint32_t>(Entry.first);
+    W.write<uint32_t>(Entry.second.size());
+    for (uint32_t Record : Entry.second)
+      W.write<uint32_t>(Record);
+  }
+}
+
+static void readMessage(Reader &R, ArrayRef<StringRef> Strings,
+                        tooling::DiagnosticMessage &Message) {
+  Message.Message = R.readString(Strings).str();
+  Message.FilePath = R.readString(Strings).str();
+  Message.FileOffset = R.read32();
+}
+
+static bool readRecord(Reader &R, ArrayRef<StringRef> Strings,
+                       std::vector<ClangTidyError> &Errors) {
+  StringRef CheckName = R.readString(Strings);
+  uint8_t Level = R.read8();
+  bool IsWarningAsError = R.read8() != 0;
+  StringRef BuildDirectory = R.readString(Strings);
+  if (Level != ClangTidyError::Warning && Level != ClangTidyError::Error)
+    return false;
+  ClangTidyError Error(CheckName, static_cast<ClangTidyError::Level>(Level),
+                       BuildDirectory, IsWarningAsError);
+  readMessage(R, Strings, Error.Message);
+  for (uint32_t I = 0, E = R.read32(); I < E && !R.failed(); ++I) {
+    Error.Notes.emplace_back();
+    readMessage(R, Strings, Error.Notes.back());
+  }
+  for (uint32_t I = 0, E = R.read32(); I < E && !R.failed(); ++I) {
+    tooling::Replacements &Replacements = Error.Fix[R.readString(Strings)];
+    for (uint32_t J = 0, F = R.read32(); J < F && !R.failed(); ++J) {
+      StringRef FilePath = R.readString(Strings);
+      uint32_t Offset = R.read32();
+      uint32_t Length = R.read32();
+      StringRef Text = R.readString(Strings);
+      if (llvm::Error Err = Replacements.add(
+              tooling::Replacement(FilePath, Offset, Length, Text))) {
+        llvm::consumeError(std::move(Err));
+        return false;
+      }
+    }
+  }
+  if (R.failed())
+    return false;
+  Errors.push_back(std::move(Error));
+  return true;
+}
+
+/// \brief Returns \c true if \p Path starts with the whole path components
+/// of \p Prefix, so that "/a/b" selects "/a/b/c.h" but not "/a/bc.h".
+static bool startsWithPathPrefix(StringRef Path, StringRef Prefix) {
+  if (!Path.startswith(Prefix))
+    return false;
+  return Path.size() == Prefix.size() ||
+         llvm::sys::path::is_separator(Prefix.back()) ||
+         llvm::sys::path::is_separator(Path[Prefix.size()]);
+}
+
+/// \brief Unselects the records that the index at \p Offset does not list
+/// under any string accepted by \p Matches.
+template <typename MatchFn>
+static bool selectFromIndex(StringRef Buffer, uint32_t Offset,
+                            ArrayRef<StringRef> Strings, MatchFn Matches,
+                            std::vector<bool> &Selected) {
+  std::vector<bool> Matched(Selected.size(), false);
+  Reader R(Buffer, Offset);
+  for (uint32_t I = 0, E = R.read32(); I < E && !R.failed(); ++I) {
+    StringRef Key = R.readString(Strings);
+    uint32_t Count = R.read32();
+    if (R.failed())
+      break;
+    if (!Matches(Key)) {
+      R.readBytes(uint64_t(Count) * 4);
+      continue;
+    }
+    for (uint32_t J = 0; J < Count && !R.failed(); ++J) {
+      uint32_t Record = R.read32();
+      if (Record >= Matched.size())
+        return false;
+      Matched[Record] = true;
+    }
+  }
+  if (R.failed())
+    return false;
+  for (size_t I = 0; I < Selected.size(); ++I)
+    Selected[I] = Selected[I] && Matched[I];
+  return true;
+}
+
+void exportResults(StringRef MainFilePath, ArrayRef<ClangTidyError> Errors,
+                   raw_ostream &OS) {
+  StringTable Strings;
+  uint32_t MainFile = Strings.add(MainFilePath);
+
+  std::string Records;
+  llvm::raw_string_ostream RecordsOS(Records);
+  LEWriter RecordsWriter(RecordsOS);
+  std::vector<uint32_t> RecordOffsets;
+  RecordIndex ByCheck, ByFile;
+  for (const ClangTidyError &Error : Errors) {
+    uint32_t Record = RecordOffsets.size();
+    RecordOffsets.push_back(RecordsOS.tell());
+    writeRecord(RecordsWriter, Strings, Error);
+    ByCheck[Strings.add(Error.DiagnosticName)].push_back(Record);
+    ByFile[Strings.add(Error.Message.FilePath)].push_back(Record);
+  }
+  RecordsOS.flush();
+
+  std::string Tables;
+  llvm::raw_string_ostream TablesOS(Tables);
+  LEWriter TablesWriter(TablesOS);
+  ArrayRef<StringRef> AllStrings = Strings.getStrings();
+  TablesWriter.write<uint32_t>(AllStrings.size());
+  for (StringRef S : AllStrings) {
+    TablesWriter.write<uint32_t>(S.size());
+    TablesOS << S;
+  }
+  uint32_t RecordsOffset = HeaderSize + TablesOS.tell();
+  TablesOS << Records;
+  uint32_t RecordOffsetsOffset = HeaderSize + TablesOS.tell();
+  TablesWriter.write<uint32_t>(RecordOffsets.size());
+  for (uint32_t Offset : RecordOffsets)
+    TablesWriter.write<uint32_t>(Offset);
+  uint32_t CheckIndexOffset = HeaderSize + TablesOS.tell();
+  writeIndex(TablesWriter, ByCheck);
+  uint32_t FileIndexOffset = HeaderSize + TablesOS.tell();
+  writeIndex(TablesWriter, ByFile);
+  TablesOS.flush();
+
+  LEWriter W(OS);
+  OS.write(Magic, sizeof(Magic));
+  W.write<uint32_t>(Version);
+  W.write<uint32_t>(MainFile);
+  W.write<uint32_t>(HeaderSize);
+  W.write<uint32_t>(RecordsOffset);
+  W.write<uint32_t>(RecordOffsetsOffset);
+  W.write<uint32_t>(CheckIndexOffset);
+  W.write<uint32_t>(FileIndexOffset);
+  OS << Tables;
+}
+
+std::error_code parseResults(StringRef Buffer, const ResultsQuery &Query,
+                             std::vector<ClangTidyError> &Errors,
+                             std::string *MainFilePath) {
+  const std::error_code Invalid =
+      std::make_error_code(std::errc::invalid_argument);
+  if (!Buffer.startswith(StringRef(Magic, sizeof(Magic))))
+    return Invalid;
+  Reader Header(Buffer, sizeof(Magic));
+  if (Header.read32() != Version)
+    return Invalid;
+  uint32_t MainFile = Header.read32();
+  uint32_t StringsOffset = Header.read32();
+  uint32_t RecordsOffset = Header.read32();
+  uint32_t RecordOffsetsOffset = Header.read32();
+  uint32_t CheckIndexOffset = Header.read32();
+  uint32_t FileIndexOffset = Header.read32();
+  if (Header.failed())
+    return Invalid;
+
+  std::vector<StringRef> Strings;
+  Reader StringsReader(Buffer, StringsOffset);
+  for (uint32_t I = 0, E = StringsReader.read32();
+       I < E && !StringsReader.failed(); ++I)
+    Strings.push_back(StringsReader.readBytes(StringsReader.read32()));
+  if (StringsReader.failed() || MainFile >= Strings.size())
+    return Invalid;
+  if (MainFilePath)
+    *MainFilePath = Strings[MainFile].str();
+
+  Reader OffsetsReader(Buffer, RecordOffsetsOffset);
+  uint32_t RecordCount = OffsetsReader.read32();
+  if (OffsetsReader.failed() || uint64_t(RecordCount) * 4 > Buffer.size())
+    return Invalid;
+  std::vector<uint32_t> RecordOffsets(RecordCount);
+  for (uint32_t &Offset : RecordOffsets)
+    Offset = OffsetsReader.read32();
+  if (OffsetsReader.failed())
+    return Invalid;
+
+  std::vector<bool> Selected(RecordOffsets.size(), true);
+  if (!Query.Checks.empty()) {
+    GlobList Filter(Query.Checks);
+    if (!selectFromIndex(Buffer, CheckIndexOffset, Strings,
+                         [&Filter](StringRef Check) {
+                           return Filter.contains(Check);
+                         },
+                         Selected))
+      return Invalid;
+  }
+  if (!Query.PathPrefix.empty()) {
+    StringRef Prefix = Query.PathPrefix;
+    if (!selectFromIndex(Buffer, FileIndexOffset, Strings,
+                         [Prefix](StringRef File) {
+                           return startsWithPathPrefix(File, Prefix);
+                         },
+                         Selected))
+      return Invalid;
+  }
+
+  for (size_t I = 0; I < RecordOffsets.size(); ++I) {
+    if (!Selected[I])
+      continue;
+    Reader R(Buffer, uint64_t(RecordsOffset) + RecordOffsets[I]);
+    if (!readRecord(R, Strings, Errors))
+      return Invalid;
+  }
+  return std::error_code();
+}
+
+} // namespace tidy
+} // namespace clang
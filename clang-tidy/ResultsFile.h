@@ -0,0 +1,57 @@
+//===--- ResultsFile.h - clang-tidy -----------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_RESULTSFILE_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_RESULTSFILE_H
+
+#include "ClangTidyDiagnosticConsumer.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace clang {
+namespace tidy {
+
+/// \brief Selects diagnostics of a results file.
+struct ResultsQuery {
+  /// \brief Check filter in the format of the \c Checks option. An empty
+  /// filter selects all checks.
+  std::string Checks;
+  /// \brief Selects the diagnostics located in files whose path starts with
+  /// this prefix, compared by whole path components. An empty prefix selects
+  /// all files.
+  std::string PathPrefix;
+};
+
+/// \brief Serializes \p Errors into the compact results format and writes them
+/// to \p OS.
+///
+/// Unlike the YAML written by \c exportReplacements, the results format stores
+/// each string once, and indexes the diagnostics by check name and by file, so
+/// that \c parseResults only decodes the diagnostics a query selects.
+void exportResults(StringRef MainFilePath, ArrayRef<ClangTidyError> Errors,
+                   raw_ostream &OS);
+
+/// \brief Parses results written by \c exportResults and appends the
+/// diagnostics selected by \p Query to \p Errors, in the order they were
+/// written.
+///
+/// If \p MainFilePath is not null, it is set to the main file path the results
+/// were written with.
+std::error_code parseResults(StringRef Buffer, const ResultsQuery &Query,
+                             std::vector<ClangTidyError> &Errors,
+                             std::string *MainFilePath = nullptr);
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_RESULTSFILE_H
@@ -0,0 +1,254 @@
+//===--- ScopedParentMap.cpp - clang-tidy ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ScopedParentMap.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include <algorithm>
+
+namespace clang {
+namespace tidy {
+
+using ast_type_traits::DynTypedNode;
+
+class ScopedParentMap::Builder : public RecursiveASTVisitor<Builder> {
+public:
+  explicit Builder(ScopedParentMap &Map) : Map(Map) {}
+
+  // Visit the same nodes as the AST matchers and ASTContext::getParents() do.
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool TraverseDecl(Decl *D) {
+    if (!D)
+      return true;
+    bool Template = isTemplateOrInstantiation(D);
+    if (Template)
+      ++TemplateDepth;
+    bool Result =
+        traverseNode(Map.PointerParents, D, DynTypedNode::create(*D), [&] {
+          return RecursiveASTVisitor<Builder>::TraverseDecl(D);
+        });
+    if (Template)
+      --TemplateDepth;
+    return Result;
+  }
+
+  bool TraverseStmt(Stmt *S) {
+    if (!S)
+      return true;
+    return traverseNode(Map.PointerParents, S, DynTypedNode::create(*S), [&] {
+      return RecursiveASTVisitor<Builder>::TraverseStmt(S);
+    });
+  }
+
+  bool TraverseTypeLoc(TypeLoc TL) {
+    if (TL.isNull())
+      return true;
+    DynTypedNode Node = DynTypedNode::create(TL);
+    return traverseNode(Map.OtherParents, Node, Node, [&] {
+      return RecursiveASTVisitor<Builder>::TraverseTypeLoc(TL);
+    });
+  }
+
+  bool TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc NNSLoc) {
+    if (!NNSLoc)
+      return true;
+    DynTypedNode Node = DynTypedNode::create(NNSLoc);
+    return traverseNode(Map.OtherParents, Node, Node, [&] {
+      return RecursiveASTVisitor<Builder>::TraverseNestedNameSpecifierLoc(
+          NNSLoc);
+    });
+  }
+
+private:
+  template <typename MapT, typename KeyT, typename TraverseFn>
+  bool traverseNode(MapT &Parents, const KeyT &Key, const DynTypedNode &Node,
+                    TraverseFn Traverse) {
+    // The parent of the root itself is not recorded; it is derived from its
+    // lexical declaration context instead.
+    if (!ParentStack.empty()) {
+      NodeParents &Entry = Parents[Key];
+      if (std::find(Entry.Parents.begin(), Entry.Parents.end(),
+                    ParentStack.back()) == Entry.Parents.end())
+        Entry.Parents.push_back(ParentStack.back());
+      if (TemplateDepth > 0)
+        Entry.InTemplate = true;
+    }
+    ParentStack.push_back(Node);
+    bool Result = Traverse();
+    ParentStack.pop_back();
+    return Result;
+  }
+
+  static bool isTemplateOrInstantiation(const Decl *D) {
+    if (isa<TemplateDecl>(D) || isa<ClassTemplateSpecializationDecl>(D) ||
+        isa<VarTemplateSpecializationDecl>(D))
+      return true;
+    if (const auto *Record = dyn_cast<CXXRecordDecl>(D))
+      return Record->getTemplateSpecializationKind() != TSK_Undeclared;
+    if (const auto *Function = dyn_cast<FunctionDecl>(D))
+      return Function->getTemplatedKind() != FunctionDecl::TK_NonTemplate;
+    if (const auto *Var = dyn_cast<VarDecl>(D))
+      return Var->getTemplateSpecializationKind() != TSK_Undeclared;
+    return false;
+  }
+
+  ScopedParentMap &Map;
+  llvm::SmallVector<DynTypedNode, 16> ParentStack;
+  unsigned TemplateDepth = 0;
+};
+
+static bool isNamespaceScope(const DeclContext *DC) {
+  return DC->isFileContext() || isa<LinkageSpecDecl>(DC) ||
+         isa<ExportDecl>(DC);
+}
+
+// Returns the namespace-scope declaration whose traversal visits \p D, given
+// the outermost non-namespace declaration \p D is lexically contained in.
+static const Decl *getTraversalRoot(const Decl *D) {
+  if (const auto *Record = dyn_cast<CXXRecordDecl>(D)) {
+    if (const ClassTemplateDecl *Template = Record->getDescribedClassTemplate())
+      return Template;
+    if (const auto *Spec = dyn_cast<ClassTemplateSpecializationDecl>(Record)) {
+      if (Spec->getSpecializationKind() == TSK_ImplicitInstantiation)
+        return Spec->getSpecializedTemplate();
+    }
+  }
+  if (const auto *Function = dyn_cast<FunctionDecl>(D)) {
+    if (const FunctionTemplateDecl *Template =
+            Function->getDescribedFunctionTemplate())
+      return Template;
+    if (Function->getTemplateSpecializationKind() ==
+        TSK_ImplicitInstantiation) {
+      if (const FunctionTemplateDecl *Template = Function->getPrimaryTemplate())
+        return Template;
+    }
+  }
+  return D;
+}
+
+ScopedParentMap::ScopedParentMap(ASTContext &Context)
+    : Context(Context), RootsIndexed(false), CurrentRoot(nullptr) {}
+
+ASTContext::DynTypedNodeList
+ScopedParentMap::getParents(const DynTypedNode &Node) {
+  // Walks up the AST mostly stay within the current root.
+  if (CurrentRoot) {
+    if (const NodeParents *Parents = lookup(CurrentRoot, Node))
+      return getParents(Node, *Parents);
+  }
+
+  if (const auto *D = Node.get<Decl>()) {
+    if (isa<TranslationUnitDecl>(D))
+      return llvm::ArrayRef<DynTypedNode>();
+    const Decl *Outermost = D;
+    while (!isNamespaceScope(Outermost->getLexicalDeclContext()))
+      Outermost = cast<Decl>(Outermost->getLexicalDeclContext());
+    // Some declarations are not children of their lexical context, e.g.
+    // template parameters and closure types of lambdas at namespace scope.
+    // Find those by location like statements.
+    if (Outermost->getLexicalDeclContext()->containsDecl(
+            const_cast<Decl *>(Outermost))) {
+      const Decl *RootDecl = getTraversalRoot(Outermost);
+      if (RootDecl == D)
+        return DynTypedNode::create(*cast<Decl>(D->getLexicalDeclContext()));
+      if (const NodeParents *Parents = lookup(RootDecl, Node))
+        return getParents(Node, *Parents);
+      return Context.getParents(Node);
+    }
+  }
+
+  SourceLocation Loc = Node.getSourceRange().getBegin();
+  if (Loc.isInvalid())
+    return Context.getParents(Node);
+
+  if (!RootsIndexed)
+    indexRoots();
+  const SourceManager &SM = Context.getSourceManager();
+  Loc = SM.getExpansionLoc(Loc);
+  auto It = std::upper_bound(Roots.begin(), Roots.end(), Loc,
+                             [&SM](SourceLocation L, const Root &R) {
+                               return SM.isBeforeInTranslationUnit(L, R.Begin);
+                             });
+  // Try all roots containing the location, innermost first. Roots rarely
+  // overlap, e.g. for "struct S {} s;", so this usually stops after one.
+  while (It != Roots.begin()) {
+    --It;
+    if (SM.isBeforeInTranslationUnit(It->MaxEnd, Loc))
+      break;
+    if (SM.isBeforeInTranslationUnit(It->End, Loc))
+      continue;
+    if (const NodeParents *Parents = lookup(It->D, Node))
+      return getParents(Node, *Parents);
+  }
+  return Context.getParents(Node);
+}
+
+void ScopedParentMap::indexRoots() {
+  RootsIndexed = true;
+  const SourceManager &SM = Context.getSourceManager();
+  llvm::SmallVector<const DeclContext *, 8> Worklist;
+  Worklist.push_back(Context.getTranslationUnitDecl());
+  while (!Worklist.empty()) {
+    const DeclContext *DC = Worklist.pop_back_val();
+    for (const Decl *D : DC->decls()) {
+      const auto *Inner = dyn_cast<DeclContext>(D);
+      if (Inner && isNamespaceScope(Inner)) {
+        Worklist.push_back(Inner);
+        continue;
+      }
+      SourceRange Range = D->getSourceRange();
+      if (Range.isInvalid())
+        continue;
+      Roots.push_back({D, SM.getExpansionLoc(Range.getBegin()),
+                       SM.getExpansionRange(Range.getEnd()).second,
+                       SourceLocation()});
+    }
+  }
+
+  std::sort(Roots.begin(), Roots.end(), [&SM](const Root &A, const Root &B) {
+    return SM.isBeforeInTranslationUnit(A.Begin, B.Begin);
+  });
+  SourceLocation MaxEnd;
+  for (Root &R : Roots) {
+    if (MaxEnd.isInvalid() || SM.isBeforeInTranslationUnit(MaxEnd, R.End))
+      MaxEnd = R.End;
+    R.MaxEnd = MaxEnd;
+  }
+}
+
+ASTContext::DynTypedNodeList
+ScopedParentMap::getParents(const DynTypedNode &Node,
+                            const NodeParents &Found) {
+  if (Found.InTemplate)
+    return Context.getParents(Node);
+  return llvm::makeArrayRef(Found.Parents);
+}
+
+const ScopedParentMap::NodeParents *
+ScopedParentMap::lookup(const Decl *RootDecl, const DynTypedNode &Node) {
+  if (RootDecl != CurrentRoot) {
+    PointerParents.clear();
+    OtherParents.clear();
+    CurrentRoot = RootDecl;
+    Builder(*this).TraverseDecl(const_cast<Decl *>(RootDecl));
+  }
+
+  if (const void *Pointer = Node.getMemoizationData()) {
+    auto It = PointerParents.find(Pointer);
+    return It == PointerParents.end() ? nullptr : &It->second;
+  }
+  auto It = OtherParents.find(Node);
+  return It == OtherParents.end() ? nullptr : &It->second;
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,108 @@
+//===--- ScopedParentMap.h - clang-tidy -------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_SCOPEDPARENTMAP_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_SCOPEDPARENTMAP_H
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTTypeTraits.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <vector>
+
+namespace clang {
+namespace tidy {
+
+/// \brief Parent links of AST nodes, built only for the top-level declaration
+/// containing the nodes being inspected.
+///
+/// The first call to \c ASTContext::getParents() builds the parent links of
+/// the whole translation unit. This map instead finds the namespace-scope
+/// declaration containing a node and builds the links of that declaration's
+/// subtree only, visiting template instantiations and implicit code the same
+/// way AST matchers do. The links of the most recently inspected declaration
+/// are kept, so that all checks looking at nodes of the same function share
+/// them.
+///
+/// Nodes that cannot be placed in a top-level declaration, e.g. nodes without
+/// a valid source location, are looked up with \c ASTContext::getParents().
+/// So are nodes of templates and their instantiations: an instantiation can
+/// reuse the non-dependent nodes of its pattern, and be traversed from a
+/// different top-level declaration, e.g. an explicit instantiation, so these
+/// nodes may have parents in several top-level declarations.
+class ScopedParentMap {
+public:
+  /// \brief Creates an empty map for the translation unit of \p Context.
+  explicit ScopedParentMap(ASTContext &Context);
+
+  /// \brief Returns the \c ASTContext the map was created for.
+  ASTContext &getASTContext() const { return Context; }
+
+  /// \brief Returns the parents of \p Node, like \c ASTContext::getParents().
+  ///
+  /// The result stays valid until the parents of a node in a different
+  /// top-level declaration are requested.
+  template <typename NodeT>
+  ASTContext::DynTypedNodeList getParents(const NodeT &Node) {
+    return getParents(ast_type_traits::DynTypedNode::create(Node));
+  }
+
+  ASTContext::DynTypedNodeList
+  getParents(const ast_type_traits::DynTypedNode &Node);
+
+private:
+  class Builder;
+
+  using ParentVector = llvm::SmallVector<ast_type_traits::DynTypedNode, 1>;
+
+  /// \brief The parents of a node in the current root.
+  struct NodeParents {
+    NodeParents() : InTemplate(false) {}
+    ParentVector Parents;
+    /// \brief Whether the node is part of a template or an instantiation, and
+    /// may have parents in other roots as well.
+    bool InTemplate;
+  };
+
+  /// \brief A namespace-scope declaration and the expansion range it covers.
+  struct Root {
+    const Decl *D;
+    SourceLocation Begin;
+    SourceLocation End;
+    /// \brief The largest \c End of this and all preceding roots.
+    SourceLocation MaxEnd;
+  };
+
+  /// \brief Collects and sorts the namespace-scope declarations of the
+  /// translation unit.
+  void indexRoots();
+
+  /// \brief Looks \p Node up in the parent links of \p RootDecl, building
+  /// them if \p RootDecl is not the current root.
+  const NodeParents *lookup(const Decl *RootDecl,
+                            const ast_type_traits::DynTypedNode &Node);
+
+  /// \brief Returns the parents of \p Node found in a root, falling back to
+  /// \c ASTContext::getParents() if it may have parents in other roots.
+  ASTContext::DynTypedNodeList
+  getParents(const ast_type_traits::DynTypedNode &Node,
+             const NodeParents &Found);
+
+  ASTContext &Context;
+  bool RootsIndexed;
+  std::vector<Root> Roots;
+  const Decl *CurrentRoot;
+  llvm::DenseMap<const void *, NodeParents> PointerParents;
+  llvm::DenseMap<ast_type_traits::DynTypedNode, NodeParents> OtherParents;
+};
+
+} // namespace tidy
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_SCOPEDPARENTMAP_H
@@ -0,0 +1,382 @@
+//===--- SharedPreambles.cpp - clang-tidy ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SharedPreambles.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <map>
+
+using namespace clang::tooling;
+
+namespace clang {
+namespace tidy {
+
+std::vector<std::string> getLeadingIncludes(StringRef Code) {
+  std::vector<std::string> Includes;
+  bool InBlockComment = false;
+  while (!Code.empty()) {
+    StringRef Line;
+    std::tie(Line, Code) = Code.split('\n');
+
+    // Remove the comments from the line.
+    SmallString<128> Text;
+    while (!Line.empty()) {
+      if (InBlockComment) {
+        size_t End = Line.find("*/");
+        if (End == StringRef::npos)
+          break;
+        Line = Line.drop_front(End + 2);
+        InBlockComment = false;
+      } else if (Line.startswith("//")) {
+        break;
+      } else if (Line.startswith("/*")) {
+        Line = Line.drop_front(2);
+        InBlockComment = true;
+        Text += ' ';
+      } else {
+        Text += Line.front();
+        Line = Line.drop_front();
+      }
+    }
+
+    StringRef Directive = StringRef(Text).trim();
+    if (Directive.empty())
+      continue;
+    // Stop at the first line that isn't a plain #include, including
+    // #include_next, #import and directives continued on the next line.
+    if (!Directive.consume_front("#"))
+      break;
+    Directive = Directive.ltrim();
+    if (!Directive.consume_front("include"))
+      break;
+    Directive = Directive.ltrim();
+    if (Directive.size() < 3)
+      break;
+    char Close = Directive.front() == '<' ? '>' : '"';
+    if ((Directive.front() != '<' && Directive.front() != '"') ||
+        Directive.back() != Close ||
+        Directive.find(Close, 1) != Directive.size() - 1)
+      break;
+    Includes.push_back(("#include " + Directive).str());
+  }
+  return Includes;
+}
+
+namespace {
+
+/// \brief Translation units whose compile commands only differ in the name
+/// of the main file.
+struct PreambleGroup {
+  std::string Directory;
+  CommandLineArguments Arguments;
+  StringRef HeaderKind;
+  std::vector<std::string> Files;
+  /// \brief The include directives all files of the group start with.
+  std::vector<std::string> Includes;
+};
+
+/// \brief Generates a precompiled header, and checks that all headers it
+/// includes are guarded against multiple inclusion.
+class GeneratePreambleAction : public GeneratePCHAction {
+public:
+  GeneratePreambleAction(StringRef OutputFile, bool &AllGuarded)
+      : OutputFile(OutputFile), AllGuarded(AllGuarded) {}
+
+protected:
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
+                                                 StringRef InFile) override {
+    CI.getFrontendOpts().OutputFile = OutputFile;
+    CI.getPreprocessor().addPPCallbacks(
+        llvm::make_unique<Callbacks>(CI.getSourceManager(), Headers));
+    return GeneratePCHAction::CreateASTConsumer(CI, InFile);
+  }
+
+  void EndSourceFileAction() override {
+    HeaderSearch &HS =
+        getCompilerInstance().getPreprocessor().getHeaderSearchInfo();
+    for (const FileEntry *File : Headers)
+      if (!File || !HS.isFileMultipleIncludeGuarded(File))
+        AllGuarded = false;
+    GeneratePCHAction::EndSourceFileAction();
+  }
+
+private:
+  class Callbacks : public PPCallbacks {
+  public:
+    Callbacks(const SourceManager &SM,
+              std::vector<const FileEntry *> &Headers)
+        : SM(SM), Headers(Headers) {}
+
+    void InclusionDirective(SourceLocation HashLocation,
+                            const Token & /*IncludeToken*/,
+                            StringRef /*FileName*/, bool /*IsAngled*/,
+                            CharSourceRange /*FileNameRange*/,
+                            const FileEntry *IncludedFile,
+                            StringRef /*SearchPath*/,
+                            StringRef /*RelativePath*/,
+                            const Module * /*ImportedModule*/) override {
+      if (SM.isInMainFile(HashLocation))
+        Headers.push_back(IncludedFile);
+    }
+
+  private:
+    const SourceManager &SM;
+    std::vector<const FileEntry *> &Headers;
+  };
+
+  std::string OutputFile;
+  bool &AllGuarded;
+  std::vector<const FileEntry *> Headers;
+};
+
+/// \brief Records whether a precompiled header build produced any compiler
+/// warnings or errors, without printing them.
+class HeaderDiagnostics : public DiagnosticConsumer {
+public:
+  HeaderDiagnostics() : Found(false) {}
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                        const Diagnostic & /*Info*/) override {
+    if (DiagLevel >= DiagnosticsEngine::Warning)
+      Found = true;
+  }
+
+  bool Found;
+};
+
+} // namespace
+
+/// \brief Returns the -x value of a header in the language of \p FileName, or
+/// an empty string if precompiled headers aren't shared for the language.
+static StringRef getHeaderKind(StringRef FileName) {
+  StringRef Extension = llvm::sys::path::extension(FileName);
+  if (Extension == ".c")
+    return "c-header";
+  if (Extension == ".cc" || Extension == ".cpp" || Extension == ".cxx" ||
+      Extension == ".c++" || Extension == ".cp" || Extension == ".C")
+    return "c++-header";
+  return "";
+}
+
+static std::string makeAbsolute(StringRef Directory, StringRef Path) {
+  SmallString<256> AbsolutePath;
+  if (!llvm::sys::path::is_absolute(Path))
+    AbsolutePath = Directory;
+  llvm::sys::path::append(AbsolutePath, Path);
+  llvm::sys::path::remove_dots(AbsolutePath, /*remove_dot_dot=*/true);
+  return AbsolutePath.str();
+}
+
+/// \brief Removes the main file and the dependency file options from \p Args.
+///
+/// Returns \c false if the main file isn't found, or if the command already
+/// includes files before the main file.
+static bool getGroupArguments(const CommandLineArguments &Args,
+                              const CompileCommand &Command,
+                              CommandLineArguments &GroupArgs) {
+  std::string MainFile = makeAbsolute(Command.Directory, Command.Filename);
+  bool FoundMainFile = false;
+  for (size_t I = 0, E = Args.size(); I < E; ++I) {
+    StringRef Arg = Args[I];
+    if (I > 0 && !Arg.startswith("-") &&
+        makeAbsolute(Command.Directory, Arg) == MainFile) {
+      FoundMainFile = true;
+      continue;
+    }
+    if (Arg.startswith("-include") || Arg.startswith("-imacros"))
+      return false;
+    // Dependency files are named after each main file, and don't affect the
+    // precompiled header.
+    if (Arg.startswith("-M")) {
+      if (Arg == "-MF" || Arg == "-MT" || Arg == "-MQ")
+        ++I;
+      continue;
+    }
+    GroupArgs.push_back(Args[I]);
+  }
+  return FoundMainFile;
+}
+
+/// \brief Resolves the quoted includes of \p Includes found in the directory
+/// of the main file to absolute paths, so that they are found the same way
+/// from a header in another directory.
+static void resolveIncludes(std::vector<std::string> &Includes,
+                            StringRef MainFile) {
+  StringRef Directory = llvm::sys::path::parent_path(MainFile);
+  for (std::string &Include : Includes) {
+    StringRef Name = Include;
+    if (!Name.consume_front("#include \""))
+      continue;
+    Name = Name.drop_back();
+    if (llvm::sys::path::is_absolute(Name))
+      continue;
+    std::string Path = makeAbsolute(Directory, Name);
+    if (llvm::sys::fs::exists(Path))
+      Include = "#include \"" + Path + "\"";
+  }
+}
+
+/// \brief Precompiles the shared includes of \p Group, and returns the path
+/// of the precompiled header, or an empty string on failure.
+static std::string buildPreamble(const PreambleGroup &Group,
+                                 std::vector<std::string> &TemporaryFiles) {
+  int FD;
+  SmallString<128> HeaderFile;
+  if (llvm::sys::fs::createTemporaryFile("clang-tidy-preamble", "h", FD,
+                                         HeaderFile))
+    return "";
+  TemporaryFiles.push_back(HeaderFile.str());
+  llvm::sys::RemoveFileOnSignal(HeaderFile);
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "#pragma once\n";
+    for (const std::string &Include : Group.Includes)
+      OS << Include << '\n';
+  }
+
+  std::string PCHFile = (HeaderFile.str() + ".pch").str();
+  TemporaryFiles.push_back(PCHFile);
+  llvm::sys::RemoveFileOnSignal(PCHFile);
+
+  CommandLineArguments Args = Group.Arguments;
+  Args.push_back("-x");
+  Args.push_back(Group.HeaderKind.str());
+  Args.push_back(HeaderFile.str());
+
+  FileSystemOptions FileSystemOpts;
+  FileSystemOpts.WorkingDir = Group.Directory;
+  llvm::IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOpts));
+  bool AllGuarded = true;
+  ToolInvocation Invocation(
+      Args, new GeneratePreambleAction(PCHFile, AllGuarded), Files.get());
+  // Compiler diagnostics in the shared headers are only produced here, and
+  // not when the translation units are parsed with the precompiled header.
+  // Rather than losing them, the group is parsed as usual if there are any,
+  // so that each translation unit reports them through the normal filters.
+  HeaderDiagnostics Diagnostics;
+  Invocation.setDiagnosticConsumer(&Diagnostics);
+  if (!Invocation.run() || !AllGuarded || Diagnostics.Found) {
+    llvm::sys::fs::remove(PCHFile);
+    return "";
+  }
+  return PCHFile;
+}
+
+SharedPreambles::~SharedPreambles() {
+  for (const std::string &File : TemporaryFiles) {
+    llvm::sys::fs::remove(File);
+    llvm::sys::DontRemoveFileOnSignal(File);
+  }
+}
+
+void SharedPreambles::build(const CompilationDatabase &Compilations,
+                            ArrayRef<std::string> InputFiles,
+                            ArgumentsAdjuster Adjuster) {
+  // Ordered by the key, so that the groups are built in a stable order.
+  std::map<std::string, PreambleGroup> Groups;
+  // The arguments adjuster only gets the file name of a compile command,
+  // which can be relative. Files whose names are ambiguous aren't shared.
+  llvm::StringMap<std::string> PathsByName;
+  llvm::StringSet<> AmbiguousNames;
+  for (const std::string &InputFile : InputFiles) {
+    std::string File = tooling::getAbsolutePath(InputFile);
+    std::vector<CompileCommand> Commands =
+        Compilations.getCompileCommands(File);
+    for (const CompileCommand &Command : Commands) {
+      std::string Path = makeAbsolute(Command.Directory, Command.Filename);
+      auto Inserted =
+          PathsByName.insert(std::make_pair(Command.Filename, Path));
+      if (!Inserted.second && Inserted.first->second != Path)
+        AmbiguousNames.insert(Command.Filename);
+    }
+    if (Commands.size() != 1)
+      continue;
+    const CompileCommand &Command = Commands.front();
+    StringRef HeaderKind = getHeaderKind(Command.Filename);
+    if (HeaderKind.empty())
+      continue;
+    CommandLineArguments Args;
+    if (!getGroupArguments(Adjuster(Command.CommandLine, Command.Filename),
+                           Command, Args))
+      continue;
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+        llvm::MemoryBuffer::getFile(File);
+    if (!Buffer)
+      continue;
+    std::vector<std::string> Includes =
+        getLeadingIncludes((*Buffer)->getBuffer());
+    if (Includes.empty())
+      continue;
+    resolveIncludes(Includes, File);
+
+    // FixedCompilationDatabase uses the same arguments for all languages, so
+    // the header language is part of the key as well.
+    std::string Key = (HeaderKind + Twine('\0') + Command.Directory).str();
+    for (const std::string &Arg : Args)
+      Key += '\0' + Arg;
+    PreambleGroup &Group = Groups[Key];
+    if (Group.Files.empty()) {
+      Group.Directory = Command.Directory;
+      Group.Arguments = std::move(Args);
+      Group.HeaderKind = HeaderKind;
+      Group.Includes = std::move(Includes);
+    } else {
+      auto Mismatch = std::mismatch(
+          Group.Includes.begin(),
+          Group.Includes.begin() +
+              std::min(Group.Includes.size(), Includes.size()),
+          Includes.begin());
+      Group.Includes.erase(Mismatch.first, Group.Includes.end());
+    }
+    Group.Files.push_back(Command.Filename);
+  }
+
+  for (const auto &Entry : Groups) {
+    const PreambleGroup &Group = Entry.second;
+    if (Group.Files.size() < 2 || Group.Includes.empty())
+      continue;
+    std::string PCHFile = buildPreamble(Group, TemporaryFiles);
+    if (PCHFile.empty())
+      continue;
+    for (const std::string &File : Group.Files)
+      if (!AmbiguousNames.count(File))
+        PCHFiles[File] = PCHFile;
+  }
+}
+
+ArgumentsAdjuster SharedPreambles::getArgumentsAdjuster() const {
+  return [this](const CommandLineArguments &Args, StringRef Filename) {
+    CommandLineArguments AdjustedArgs = Args;
+    auto PCHFile = PCHFiles.find(Filename);
+    if (PCHFile != PCHFiles.end()) {
+      auto I = AdjustedArgs.begin();
+      if (I != AdjustedArgs.end() && !StringRef(*I).startswith("-"))
+        ++I; // Skip compiler binary name, if it is there.
+      AdjustedArgs.insert(I, {"-include-pch", PCHFile->second});
+    }
+    return AdjustedArgs;
+  };
+}
+
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,72 @@
+//===--- SharedPreambles.h - clang-tidy -------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_SHAREDPREAMBLES_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_SHAREDPREAMBLES_H
+
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tidy {
+
+/// \brief Returns the \c #include directives at the start of \p Code, before
+/// any other token, in the form '#include "name"' or '#include <name>'.
+///
+/// Comments and empty lines between the directives are skipped.
+std::vector<std::string> getLeadingIncludes(StringRef Code);
+
+/// \brief Precompiled headers of the includes shared by translation units.
+///
+/// Translation units with identical compile commands and languages are
+/// grouped, and the longest sequence of \c #include directives all of them
+/// start with is precompiled once per group. Each translation unit of the group is then
+/// parsed with \c -include-pch, so that its own copies of the directives hit
+/// the include guards of the precompiled headers instead of parsing them
+/// again.
+///
+/// A group only gets a precompiled header if all headers in the shared prefix
+/// are guarded against multiple inclusion, and if they compile without errors
+/// or warnings, which the translation units wouldn't report otherwise.
+/// The precompiled headers are removed when the object is destroyed.
+class SharedPreambles {
+public:
+  SharedPreambles() = default;
+  ~SharedPreambles();
+
+  /// \brief Groups the compile commands of \p InputFiles and builds the
+  /// precompiled header of each group.
+  ///
+  /// \p Adjuster must be the arguments adjuster the translation units are
+  /// parsed with, excluding \c getArgumentsAdjuster().
+  void build(const tooling::CompilationDatabase &Compilations,
+             ArrayRef<std::string> InputFiles,
+             tooling::ArgumentsAdjuster Adjuster);
+
+  /// \brief Returns an arguments adjuster including the precompiled header
+  /// of the group of each file, if any.
+  tooling::ArgumentsAdjuster getArgumentsAdjuster() const;
+
+private:
+  /// \brief The precompiled header of each file, by the file name of its
+  /// compile command. Names used by compile commands for different files,
+  /// e.g. relative names in different directories, are left out.
+  llvm::StringMap<std::string> PCHFiles;
+  std::vector<std::string> TemporaryFiles;
+};
+
+} // namespace tidy
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_SHAREDPREAMBLES_H
@@ -37,8 +37,8 @@ void ProBoundsConstantArrayIndexCheck::registerPPCallbacks(
     return;
 
   Inserter.reset(new utils::IncludeInserter(
-      Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle));
-  Compiler.getPreprocessor().addPPCallbacks(Inserter->CreatePPCallbacks());
+      Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle,
+      getIncludeDirectives(Compiler.getPreprocessor())));
 }
 
 void ProBoundsConstantArrayIndexCheck::registerMatchers(MatchFinder *Finder) {
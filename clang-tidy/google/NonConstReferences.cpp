@@ -23,8 +23,7 @@ namespace runtime {
 NonConstReferences::NonConstReferences(StringRef Name,
                                        ClangTidyContext *Context)
     : ClangTidyCheck(Name, Context),
-      WhiteListTypes(
-          utils::options::parseStringList(Options.get("WhiteListTypes", ""))) {}
+      WhiteListTypes(Options.getStringList("WhiteListTypes", "")) {}
 
 void NonConstReferences::storeOptions(ClangTidyOptions::OptionMap &Opts) {
   Options.store(Opts, "WhiteListTypes",
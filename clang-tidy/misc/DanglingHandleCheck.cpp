@@ -86,9 +86,9 @@ ast_matchers::internal::BindableMatcher<Stmt> makeContainerMatcher(
 DanglingHandleCheck::DanglingHandleCheck(StringRef Name,
                                          ClangTidyContext *Context)
     : ClangTidyCheck(Name, Context),
-      HandleClasses(utils::options::parseStringList(Options.get(
+      HandleClasses(Options.getStringList(
           "HandleClasses",
-          "std::basic_string_view;std::experimental::basic_string_view"))),
+          "std::basic_string_view;std::experimental::basic_string_view")),
       IsAHandle(cxxRecordDecl(hasAnyName(std::vector<StringRef>(
                                   HandleClasses.begin(), HandleClasses.end())))
                     .bind("handle")) {}
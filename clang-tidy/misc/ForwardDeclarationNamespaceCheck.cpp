@@ -12,6 +12,8 @@
 #include "clang/AST/Decl.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/ADT/StringSet.h"
+#include <map>
 #include <stack>
 #include <string>
 
@@ -167,6 +169,113 @@ void ForwardDeclarationNamespaceCheck::onEndOfTranslationUnit() {
       }
     }
   }
+  summarizeDeclarations();
+}
+
+static bool isSummarized(const CXXRecordDecl *Decl) {
+  SourceLocation Loc = Decl->getLocation();
+  return Loc.isValid() && !Loc.isMacroID() &&
+         !Decl->getASTContext().getSourceManager().isInSystemHeader(Loc);
+}
+
+void ForwardDeclarationNamespaceCheck::summarizeDeclarations() {
+  // Summaries have the form "<kind> <namespace>", where <kind> is one of
+  // "unused", "used" or "definition". Forward declarations with a definition
+  // in this translation unit are not interesting to other translation units.
+  for (const auto &KeyValuePair : DeclNameToDeclarations) {
+    for (const auto *CurDecl : KeyValuePair.second) {
+      if (CurDecl->hasDefinition() || !isSummarized(CurDecl))
+        continue;
+      bool IsUsed = CurDecl->isReferenced() ||
+                    FriendTypes.count(CurDecl->getTypeForDecl()) != 0;
+      summarize(KeyValuePair.first(),
+                (IsUsed ? "used " : "unused ") + getNameOfNamespace(CurDecl),
+                CurDecl->getLocation());
+    }
+  }
+  for (const auto &KeyValuePair : DeclNameToDefinitions) {
+    for (const auto *Def : KeyValuePair.second) {
+      if (isSummarized(Def))
+        summarize(KeyValuePair.first(), "definition " + getNameOfNamespace(Def),
+                  Def->getLocation());
+    }
+  }
+}
+
+namespace {
+/// A declaration or definition merged from the summaries of all translation
+/// units that contain it.
+struct SummarizedRecord {
+  SummarizedRecord() : Summary(nullptr), IsUsed(false) {}
+
+  const CheckSummary *Summary;
+  StringRef Namespace;
+  bool IsUsed;
+  llvm::StringSet<> TranslationUnits;
+
+  bool sharesTranslationUnitWith(const SummarizedRecord &Other) const {
+    for (const auto &TU : TranslationUnits)
+      if (Other.TranslationUnits.count(TU.getKey()))
+        return true;
+    return false;
+  }
+};
+} // namespace
+
+void ForwardDeclarationNamespaceCheck::reduce(
+    ArrayRef<CheckSummary> Summaries, std::vector<ClangTidyError> &Errors) {
+  // Declarations in headers are summarized by each translation unit including
+  // them, so merge the summaries by location.
+  typedef std::map<std::pair<StringRef, unsigned>, SummarizedRecord> RecordMap;
+  RecordMap Declarations, Definitions;
+  for (const CheckSummary &Summary : Summaries) {
+    StringRef Kind, Namespace;
+    std::tie(Kind, Namespace) = StringRef(Summary.Value).split(' ');
+    RecordMap &Records = Kind == "definition" ? Definitions : Declarations;
+    SummarizedRecord &Record =
+        Records[std::make_pair(StringRef(Summary.FilePath), Summary.FileOffset)];
+    if (!Record.Summary) {
+      Record.Summary = &Summary;
+      Record.Namespace = Namespace;
+    }
+    Record.IsUsed |= Kind == "used";
+    Record.TranslationUnits.insert(Summary.MainSourceFile);
+  }
+
+  llvm::StringMap<std::vector<const SummarizedRecord *>> DefinitionsByName;
+  for (const auto &Entry : Definitions)
+    DefinitionsByName[Entry.second.Summary->Key].push_back(&Entry.second);
+
+  for (const auto &Entry : Declarations) {
+    const SummarizedRecord &Decl = Entry.second;
+    if (Decl.IsUsed)
+      continue;
+    StringRef DeclName = Decl.Summary->Key;
+    auto Iter = DefinitionsByName.find(DeclName);
+    if (Iter == DefinitionsByName.end())
+      continue;
+    const auto &NamedDefinitions = Iter->second;
+    if (llvm::any_of(NamedDefinitions, [&Decl](const SummarizedRecord *Def) {
+          return Def->Namespace == Decl.Namespace;
+        }))
+      continue; // The declaration is defined in another translation unit.
+    for (const auto *Def : NamedDefinitions) {
+      // Definitions in a translation unit that also contains the declaration
+      // were already diagnosed by onEndOfTranslationUnit().
+      if (Def->sharesTranslationUnitWith(Decl))
+        continue;
+      ClangTidyError Error = summaryDiag(
+          *Decl.Summary, ("no definition found for '" + DeclName +
+                          "', but a definition with the same name '" +
+                          DeclName + "' found in another namespace '" +
+                          Def->Namespace + "'")
+                             .str());
+      Error.Notes.push_back(summaryNote(
+          *Def->Summary,
+          ("a definition of '" + DeclName + "' is found here").str()));
+      Errors.push_back(std::move(Error));
+    }
+  }
 }
 
 } // namespace misc
@@ -33,6 +33,9 @@ namespace misc {
 ///   name 'A' found in another namespace 'nb::'
 /// \endcode
 ///
+/// Unused forward declarations and definitions are also summarized, so that
+/// definitions in other translation units of the same run are found.
+///
 /// This check can only generate warnings, but it can't suggest fixes at this
 /// point.
 ///
@@ -43,10 +46,15 @@ public:
   ForwardDeclarationNamespaceCheck(StringRef Name, ClangTidyContext *Context)
       : ClangTidyCheck(Name, Context) {}
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
+  bool needsAllHeaders() const override { return true; }
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
   void onEndOfTranslationUnit() override;
+  void reduce(ArrayRef<CheckSummary> Summaries,
+              std::vector<ClangTidyError> &Errors) override;
 
 private:
+  void summarizeDeclarations();
+
   llvm::StringMap<std::vector<const CXXRecordDecl *>> DeclNameToDefinitions;
   llvm::StringMap<std::vector<const CXXRecordDecl *>> DeclNameToDeclarations;
   llvm::SmallPtrSet<const Type *, 16> FriendTypes;
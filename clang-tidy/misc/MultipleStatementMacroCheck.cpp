@@ -22,8 +22,8 @@ namespace {
 AST_MATCHER(Expr, isInMacro) { return Node.getLocStart().isMacroID(); }
 
 /// \brief Find the next statement after `S`.
-const Stmt *nextStmt(const MatchFinder::MatchResult &Result, const Stmt *S) {
-  auto Parents = Result.Context->getParents(*S);
+const Stmt *nextStmt(ScopedParentMap &ParentMap, const Stmt *S) {
+  auto Parents = ParentMap.getParents(*S);
   if (Parents.empty())
     return nullptr;
   const auto *Parent = Parents[0].get<Stmt>();
@@ -35,7 +35,7 @@ const Stmt *nextStmt(const MatchFinder::MatchResult &Result, const Stmt *S) {
       return Child;
     Prev = Child;
   }
-  return nextStmt(Result, Parent);
+  return nextStmt(ParentMap, Parent);
 }
 
 using ExpansionRanges = std::vector<std::pair<SourceLocation, SourceLocation>>;
@@ -68,7 +68,7 @@ void MultipleStatementMacroCheck::check(
     const MatchFinder::MatchResult &Result) {
   const auto *Inner = Result.Nodes.getNodeAs<Expr>("inner");
   const auto *Outer = Result.Nodes.getNodeAs<Stmt>("outer");
-  const auto *Next = nextStmt(Result, Outer);
+  const auto *Next = nextStmt(getParentMap(*Result.Context), Outer);
   if (!Next)
     return;
 
@@ -21,12 +21,6 @@ namespace {
 
 bool isConcatenatedLiteralsOnPurpose(ASTContext *Ctx,
                                      const StringLiteral *Lit) {
-  // String literals surrounded by parentheses are assumed to be on purpose.
-  //    i.e.:  const char* Array[] = { ("a" "b" "c"), "d", [...] };
-  auto Parents = Ctx->getParents(*Lit);
-  if (Parents.size() == 1 && Parents[0].get<ParenExpr>() != nullptr)
-    return true;
-
   // Appropriately indented string literals are assumed to be on purpose.
   // The following frequent indentation is accepted:
   //     const char* Array[] = {
@@ -66,6 +60,27 @@ AST_MATCHER_P(StringLiteral, isConcatenatedLiteral, unsigned,
          !isConcatenatedLiteralsOnPurpose(&Finder->getASTContext(), &Node);
 }
 
+// Matches an initializer whose string literal, once implicit casts and
+// parentheses are stripped, is directly surrounded by parentheses. Such string
+// literals are assumed to be concatenated on purpose.
+//    i.e.:  const char* Array[] = { ("a" "b" "c"), "d", [...] };
+AST_MATCHER(Expr, isParenthesizedLiteral) {
+  const Expr *E = &Node;
+  bool Parenthesized = false;
+  while (true) {
+    if (const auto *Paren = dyn_cast<ParenExpr>(E)) {
+      Parenthesized = true;
+      E = Paren->getSubExpr();
+    } else if (const auto *Cast = dyn_cast<ImplicitCastExpr>(E)) {
+      Parenthesized = false;
+      E = Cast->getSubExpr();
+    } else {
+      break;
+    }
+  }
+  return Parenthesized && isa<StringLiteral>(E);
+}
+
 } // namespace
 
 SuspiciousMissingCommaCheck::SuspiciousMissingCommaCheck(
@@ -86,9 +101,10 @@ void SuspiciousMissingCommaCheck::registerMatchers(MatchFinder *Finder) {
   const auto ConcatenatedStringLiteral =
       stringLiteral(isConcatenatedLiteral(MaxConcatenatedTokens)).bind("str");
 
-  const auto StringsInitializerList =
-      initListExpr(hasType(constantArrayType()),
-                   has(ignoringParenImpCasts(expr(ConcatenatedStringLiteral))));
+  const auto StringsInitializerList = initListExpr(
+      hasType(constantArrayType()),
+      has(expr(unless(isParenthesizedLiteral()),
+               ignoringParenImpCasts(expr(ConcatenatedStringLiteral)))));
 
   Finder->addMatcher(StringsInitializerList.bind("list"), this);
 }
@@ -37,7 +37,8 @@ struct UseAfterMove {
 /// various internal helper functions).
 class UseAfterMoveFinder {
 public:
-  UseAfterMoveFinder(ASTContext *TheContext);
+  UseAfterMoveFinder(ASTContext *TheContext, ScopedParentMap &Parents,
+                     FunctionCFGCache &CFGs);
 
   // Within the given function body, finds the first use of 'MovedVariable' that
   // occurs after 'MovingCall' (the expression that performs the move). If a
@@ -60,8 +61,10 @@ private:
                   llvm::SmallPtrSetImpl<const DeclRefExpr *> *DeclRefs);
 
   ASTContext *Context;
-  std::unique_ptr<ExprSequence> Sequence;
-  std::unique_ptr<StmtToBlockMap> BlockMap;
+  ScopedParentMap &Parents;
+  FunctionCFGCache &CFGs;
+  const ExprSequence *Sequence;
+  const StmtToBlockMap *BlockMap;
   llvm::SmallPtrSet<const CFGBlock *, 8> Visited;
 };
 
@@ -81,29 +84,21 @@ static StatementMatcher inDecltypeOrTemplateArg() {
                    to(functionDecl(ast_matchers::isTemplateInstantiation())))));
 }
 
-UseAfterMoveFinder::UseAfterMoveFinder(ASTContext *TheContext)
-    : Context(TheContext) {}
+UseAfterMoveFinder::UseAfterMoveFinder(ASTContext *TheContext,
+                                       ScopedParentMap &Parents,
+                                       FunctionCFGCache &CFGs)
+    : Context(TheContext), Parents(Parents), CFGs(CFGs), Sequence(nullptr),
+      BlockMap(nullptr) {}
 
 bool UseAfterMoveFinder::find(Stmt *FunctionBody, const Expr *MovingCall,
                               const ValueDecl *MovedVariable,
                               UseAfterMove *TheUseAfterMove) {
-  // Generate the CFG manually instead of through an AnalysisDeclContext because
-  // it seems the latter can't be used to generate a CFG for the body of a
-  // labmda.
-  //
-  // We include implicit and temporary destructors in the CFG so that
-  // destructors marked [[noreturn]] are handled correctly in the control flow
-  // analysis. (These are used in some styles of assertion macros.)
-  CFG::BuildOptions Options;
-  Options.AddImplicitDtors = true;
-  Options.AddTemporaryDtors = true;
-  std::unique_ptr<CFG> TheCFG =
-      CFG::buildCFG(nullptr, FunctionBody, Context, Options);
-  if (!TheCFG)
+  const FunctionCFG *Function = CFGs.get(FunctionBody, Parents);
+  if (!Function)
     return false;
 
-  Sequence.reset(new ExprSequence(TheCFG.get(), Context));
-  BlockMap.reset(new StmtToBlockMap(TheCFG.get(), Context));
+  Sequence = &Function->Sequence;
+  BlockMap = &Function->BlockMap;
   Visited.clear();
 
   const CFGBlock *Block = BlockMap->blockContainingStmt(MovingCall);
@@ -367,6 +362,23 @@ static void emitDiagnostic(const Expr *MovingCall, const DeclRefExpr *MoveArg,
   }
 }
 
+// Generate the CFG manually instead of through an AnalysisDeclContext because
+// it seems the latter can't be used to generate a CFG for the body of a
+// labmda.
+//
+// We include implicit and temporary destructors in the CFG so that
+// destructors marked [[noreturn]] are handled correctly in the control flow
+// analysis. (These are used in some styles of assertion macros.)
+static CFG::BuildOptions getCFGBuildOptions() {
+  CFG::BuildOptions Options;
+  Options.AddImplicitDtors = true;
+  Options.AddTemporaryDtors = true;
+  return Options;
+}
+
+UseAfterMoveCheck::UseAfterMoveCheck(StringRef Name, ClangTidyContext *Context)
+    : ClangTidyCheck(Name, Context), CFGs(getCFGBuildOptions()) {}
+
 void UseAfterMoveCheck::registerMatchers(MatchFinder *Finder) {
   if (!getLangOpts().CPlusPlus11)
     return;
@@ -414,7 +426,8 @@ void UseAfterMoveCheck::check(const MatchFinder::MatchResult &Result) {
   if (!Arg->getDecl()->getDeclContext()->isFunctionOrMethod())
     return;
 
-  UseAfterMoveFinder finder(Result.Context);
+  UseAfterMoveFinder finder(Result.Context, getParentMap(*Result.Context),
+                            CFGs);
   UseAfterMove Use;
   if (finder.find(FunctionBody, MovingCall, Arg->getDecl(), &Use))
     emitDiagnostic(MovingCall, Arg, Use, this, Result.Context);
@@ -11,6 +11,7 @@
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_MISC_USEAFTERMOVECHECK_H
 
 #include "../ClangTidy.h"
+#include "../utils/ExprSequence.h"
 
 namespace clang {
 namespace tidy {
@@ -23,10 +24,12 @@ namespace misc {
 /// http://clang.llvm.org/extra/clang-tidy/checks/misc-use-after-move.html
 class UseAfterMoveCheck : public ClangTidyCheck {
 public:
-  UseAfterMoveCheck(StringRef Name, ClangTidyContext *Context)
-      : ClangTidyCheck(Name, Context) {}
+  UseAfterMoveCheck(StringRef Name, ClangTidyContext *Context);
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
+
+private:
+  utils::FunctionCFGCache CFGs;
 };
 
 } // namespace misc
@@ -31,31 +31,16 @@ namespace clang {
 namespace tidy {
 namespace modernize {
 
-/// \brief Tracks a stack of parent statements during traversal.
-///
-/// All this really does is inject push_back() before running
-/// RecursiveASTVisitor::TraverseStmt() and pop_back() afterwards. The Stmt atop
-/// the stack is the parent of the current statement (NULL for the topmost
-/// statement).
-bool StmtAncestorASTVisitor::TraverseStmt(Stmt *Statement) {
-  StmtAncestors.insert(std::make_pair(Statement, StmtStack.back()));
-  StmtStack.push_back(Statement);
-  RecursiveASTVisitor<StmtAncestorASTVisitor>::TraverseStmt(Statement);
-  StmtStack.pop_back();
-  return true;
-}
-
-/// \brief Keep track of the DeclStmt associated with each VarDecl.
-///
-/// Combined with StmtAncestors, this provides roughly the same information as
-/// Scope, as we can map a VarDecl to its DeclStmt, then walk up the parent tree
-/// using StmtAncestors.
-bool StmtAncestorASTVisitor::VisitDeclStmt(DeclStmt *Decls) {
-  for (const auto *decl : Decls->decls()) {
-    if (const auto *V = dyn_cast<VarDecl>(decl))
-      DeclParents.insert(std::make_pair(V, Decls));
+const Stmt *getParentStmt(ScopedParentMap &Parents, const Stmt *S) {
+  auto Node = ast_type_traits::DynTypedNode::create(*S);
+  while (true) {
+    auto NodeParents = Parents.getParents(Node);
+    if (NodeParents.empty())
+      return nullptr;
+    Node = NodeParents[0];
+    if (const auto *Parent = Node.get<Stmt>())
+      return Parent;
   }
-  return true;
 }
 
 /// \brief record the DeclRefExpr as part of the parent expression.
@@ -80,14 +65,17 @@ bool DependencyFinderASTVisitor::VisitDeclRefExpr(DeclRefExpr *DeclRef) {
 
 /// \brief Determine if any this variable is declared inside the ContainingStmt.
 bool DependencyFinderASTVisitor::VisitVarDecl(VarDecl *V) {
-  const Stmt *Curr = DeclParents->lookup(V);
+  // Only variables declared in a DeclStmt can be local to the loop.
+  auto VarParents = Parents->getParents(*V);
+  const Stmt *Curr =
+      VarParents.empty() ? nullptr : VarParents[0].get<DeclStmt>();
   // First, see if the variable was declared within an inner scope of the loop.
   while (Curr != nullptr) {
     if (Curr == ContainingStmt) {
       DependsOnInsideVariable = true;
       return false;
     }
-    Curr = StmtParents->lookup(Curr);
+    Curr = getParentStmt(*Parents, Curr);
   }
 
   // Next, check if the variable was removed from existence by an earlier
@@ -887,7 +875,8 @@ bool VariableNamer::declarationExists(StringRef Symbol) {
     return true;
 
   // Determine if the symbol was generated in a parent context.
-  for (const Stmt *S = SourceStmt; S != nullptr; S = ReverseAST->lookup(S)) {
+  for (const Stmt *S = SourceStmt; S != nullptr;
+       S = getParentStmt(*ReverseAST, S)) {
     StmtGeneratedVarNameMap::const_iterator I = GeneratedDecls->find(S);
     if (I != GeneratedDecls->end() && I->second == Symbol)
       return true;
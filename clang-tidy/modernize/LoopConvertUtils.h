@@ -10,6 +10,7 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_MODERNIZE_LOOP_CONVERT_UTILS_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_MODERNIZE_LOOP_CONVERT_UTILS_H
 
+#include "../ScopedParentMap.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
@@ -29,14 +30,6 @@ namespace modernize {
 
 enum LoopFixerKind { LFK_Array, LFK_Iterator, LFK_PseudoArray };
 
-/// A map used to walk the AST in reverse: maps child Stmt to parent Stmt.
-typedef llvm::DenseMap<const clang::Stmt *, const clang::Stmt *> StmtParentMap;
-
-/// A map used to walk the AST in reverse:
-///  maps VarDecl to the to parent DeclStmt.
-typedef llvm::DenseMap<const clang::VarDecl *, const clang::DeclStmt *>
-    DeclParentMap;
-
 /// A map used to track which variables have been removed by a refactoring pass.
 /// It maps the parent ForStmt to the removed index variable's VarDecl.
 typedef llvm::DenseMap<const clang::ForStmt *, const clang::VarDecl *>
@@ -49,37 +42,14 @@ typedef llvm::DenseMap<const clang::Stmt *, std::string>
 /// A vector used to store the AST subtrees of an Expr.
 typedef llvm::SmallVector<const clang::Expr *, 16> ComponentVector;
 
-/// \brief Class used build the reverse AST properties needed to detect
-/// name conflicts and free variables.
-class StmtAncestorASTVisitor
-    : public clang::RecursiveASTVisitor<StmtAncestorASTVisitor> {
-public:
-  StmtAncestorASTVisitor() { StmtStack.push_back(nullptr); }
-
-  /// \brief Run the analysis on the TranslationUnitDecl.
-  ///
-  /// In case we're running this analysis multiple times, don't repeat the work.
-  void gatherAncestors(const clang::TranslationUnitDecl *T) {
-    if (StmtAncestors.empty())
-      TraverseDecl(const_cast<clang::TranslationUnitDecl *>(T));
-  }
-
-  /// Accessor for StmtAncestors.
-  const StmtParentMap &getStmtToParentStmtMap() { return StmtAncestors; }
-
-  /// Accessor for DeclParents.
-  const DeclParentMap &getDeclToParentStmtMap() { return DeclParents; }
-
-  friend class clang::RecursiveASTVisitor<StmtAncestorASTVisitor>;
-
-private:
-  StmtParentMap StmtAncestors;
-  DeclParentMap DeclParents;
-  llvm::SmallVector<const clang::Stmt *, 16> StmtStack;
-
-  bool TraverseStmt(clang::Stmt *Statement);
-  bool VisitDeclStmt(clang::DeclStmt *Statement);
-};
+/// \brief Returns the closest statement enclosing \p S, skipping any
+/// intermediate declarations, or nullptr if there is none.
+///
+/// Together with the parent \c DeclStmt of a \c VarDecl, this provides roughly
+/// the same information as Scope. Parent links are built on demand, for the
+/// enclosing top-level declaration only, and shared with the other checks.
+const clang::Stmt *getParentStmt(ScopedParentMap &Parents,
+                                 const clang::Stmt *S);
 
 /// Class used to find the variables and member expressions on which an
 /// arbitrary expression depends.
@@ -110,12 +80,11 @@ private:
 class DependencyFinderASTVisitor
     : public clang::RecursiveASTVisitor<DependencyFinderASTVisitor> {
 public:
-  DependencyFinderASTVisitor(const StmtParentMap *StmtParents,
-                             const DeclParentMap *DeclParents,
+  DependencyFinderASTVisitor(ScopedParentMap *Parents,
                              const ReplacedVarsMap *ReplacedVars,
                              const clang::Stmt *ContainingStmt)
-      : StmtParents(StmtParents), DeclParents(DeclParents),
-        ContainingStmt(ContainingStmt), ReplacedVars(ReplacedVars) {}
+      : Parents(Parents), ContainingStmt(ContainingStmt),
+        ReplacedVars(ReplacedVars) {}
 
   /// \brief Run the analysis on Body, and return true iff the expression
   /// depends on some variable declared within ContainingStmt.
@@ -156,8 +125,7 @@ public:
   friend class clang::RecursiveASTVisitor<DependencyFinderASTVisitor>;
 
 private:
-  const StmtParentMap *StmtParents;
-  const DeclParentMap *DeclParents;
+  ScopedParentMap *Parents;
   const clang::Stmt *ContainingStmt;
   const ReplacedVarsMap *ReplacedVars;
   bool DependsOnInsideVariable;
@@ -399,17 +367,10 @@ private:
 };
 
 struct TUTrackingInfo {
-  /// \brief Reset and initialize per-TU tracking information.
-  ///
-  /// Must be called before using container accessors.
-  TUTrackingInfo() : ParentFinder(new StmtAncestorASTVisitor) {}
-
-  StmtAncestorASTVisitor &getParentFinder() { return *ParentFinder; }
   StmtGeneratedVarNameMap &getGeneratedDecls() { return GeneratedDecls; }
   ReplacedVarsMap &getReplacedVars() { return ReplacedVars; }
 
 private:
-  std::unique_ptr<StmtAncestorASTVisitor> ParentFinder;
   StmtGeneratedVarNameMap GeneratedDecls;
   ReplacedVarsMap ReplacedVars;
 };
@@ -431,7 +392,7 @@ public:
   };
 
   VariableNamer(StmtGeneratedVarNameMap *GeneratedDecls,
-                const StmtParentMap *ReverseAST, const clang::Stmt *SourceStmt,
+                ScopedParentMap *ReverseAST, const clang::Stmt *SourceStmt,
                 const clang::VarDecl *OldIndex,
                 const clang::ValueDecl *TheContainer,
                 const clang::ASTContext *Context, NamingStyle Style)
@@ -448,7 +409,7 @@ public:
 
 private:
   StmtGeneratedVarNameMap *GeneratedDecls;
-  const StmtParentMap *ReverseAST;
+  ScopedParentMap *ReverseAST;
   const clang::Stmt *SourceStmt;
   const clang::VarDecl *OldIndex;
   const clang::ValueDecl *TheContainer;
@@ -169,8 +169,8 @@ void PassByValueCheck::registerPPCallbacks(CompilerInstance &Compiler) {
   // benign.
   if (getLangOpts().CPlusPlus) {
     Inserter.reset(new utils::IncludeInserter(
-        Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle));
-    Compiler.getPreprocessor().addPPCallbacks(Inserter->CreatePPCallbacks());
+        Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle,
+        getIncludeDirectives(Compiler.getPreprocessor())));
   }
 }
 
@@ -213,8 +213,8 @@ void ReplaceAutoPtrCheck::registerPPCallbacks(CompilerInstance &Compiler) {
   // benign.
   if (getLangOpts().CPlusPlus) {
     Inserter.reset(new utils::IncludeInserter(
-        Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle));
-    Compiler.getPreprocessor().addPPCallbacks(Inserter->CreatePPCallbacks());
+        Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle,
+        getIncludeDirectives(Compiler.getPreprocessor())));
   }
 }
 
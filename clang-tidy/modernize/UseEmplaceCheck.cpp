@@ -22,10 +22,10 @@ static const auto DefaultSmartPointers =
 
 UseEmplaceCheck::UseEmplaceCheck(StringRef Name, ClangTidyContext *Context)
     : ClangTidyCheck(Name, Context),
-      ContainersWithPushBack(utils::options::parseStringList(Options.get(
-          "ContainersWithPushBack", DefaultContainersWithPushBack))),
-      SmartPointers(utils::options::parseStringList(
-          Options.get("SmartPointers", DefaultSmartPointers))) {}
+      ContainersWithPushBack(Options.getStringList(
+          "ContainersWithPushBack", DefaultContainersWithPushBack)),
+      SmartPointers(
+          Options.getStringList("SmartPointers", DefaultSmartPointers)) {}
 
 void UseEmplaceCheck::registerMatchers(MatchFinder *Finder) {
   if (!getLangOpts().CPlusPlus11)
@@ -51,8 +51,8 @@ AST_MATCHER_FUNCTION(ast_matchers::internal::Matcher<Expr>,
 FasterStringFindCheck::FasterStringFindCheck(StringRef Name,
                                              ClangTidyContext *Context)
     : ClangTidyCheck(Name, Context),
-      StringLikeClasses(utils::options::parseStringList(
-          Options.get("StringLikeClasses", "std::basic_string"))) {}
+      StringLikeClasses(
+          Options.getStringList("StringLikeClasses", "std::basic_string")) {}
 
 void FasterStringFindCheck::storeOptions(ClangTidyOptions::OptionMap &Opts) {
   Options.store(Opts, "StringLikeClasses",
@@ -38,9 +38,8 @@ TypePromotionInMathFnCheck::TypePromotionInMathFnCheck(
 void TypePromotionInMathFnCheck::registerPPCallbacks(
     CompilerInstance &Compiler) {
   IncludeInserter = llvm::make_unique<utils::IncludeInserter>(
-      Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle);
-  Compiler.getPreprocessor().addPPCallbacks(
-      IncludeInserter->CreatePPCallbacks());
+      Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle,
+      getIncludeDirectives(Compiler.getPreprocessor()));
 }
 
 void TypePromotionInMathFnCheck::storeOptions(
@@ -28,7 +28,6 @@ void recordFixes(const VarDecl &Var, ASTContext &Context,
 } // namespace
 
 using namespace ::clang::ast_matchers;
-using utils::decl_ref_expr::isOnlyUsedAsConst;
 
 void UnnecessaryCopyInitialization::registerMatchers(MatchFinder *Finder) {
   auto ConstReference = referenceType(pointee(qualType(isConstQualified())));
@@ -110,10 +109,10 @@ void UnnecessaryCopyInitialization::handleCopyFromMethodReturn(
     const VarDecl &Var, const Stmt &BlockStmt, bool IssueFix,
     const VarDecl *ObjectArg, ASTContext &Context) {
   bool IsConstQualified = Var.getType().isConstQualified();
-  if (!IsConstQualified && !isOnlyUsedAsConst(Var, BlockStmt, Context))
+  if (!IsConstQualified && !DeclRefs.isOnlyUsedAsConst(Var, BlockStmt))
     return;
   if (ObjectArg != nullptr &&
-      !isOnlyUsedAsConst(*ObjectArg, BlockStmt, Context))
+      !DeclRefs.isOnlyUsedAsConst(*ObjectArg, BlockStmt))
     return;
 
   auto Diagnostic =
@@ -132,8 +131,8 @@ void UnnecessaryCopyInitialization::handleCopyFromMethodReturn(
 void UnnecessaryCopyInitialization::handleCopyFromLocalVar(
     const VarDecl &NewVar, const VarDecl &OldVar, const Stmt &BlockStmt,
     bool IssueFix, ASTContext &Context) {
-  if (!isOnlyUsedAsConst(NewVar, BlockStmt, Context) ||
-      !isOnlyUsedAsConst(OldVar, BlockStmt, Context))
+  if (!DeclRefs.isOnlyUsedAsConst(NewVar, BlockStmt) ||
+      !DeclRefs.isOnlyUsedAsConst(OldVar, BlockStmt))
     return;
 
   auto Diagnostic = diag(NewVar.getLocation(),
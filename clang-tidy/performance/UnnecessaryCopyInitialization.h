@@ -11,6 +11,7 @@
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_PERFORMANCE_UNNECESSARY_COPY_INITIALIZATION_H
 
 #include "../ClangTidy.h"
+#include "../utils/DeclRefExprUtils.h"
 
 namespace clang {
 namespace tidy {
@@ -38,6 +39,10 @@ private:
   void handleCopyFromLocalVar(const VarDecl &NewVar, const VarDecl &OldVar,
                               const Stmt &BlockStmt, bool IssueFix,
                               ASTContext &Context);
+
+  // Variables in the same block share the classification of the references
+  // within it.
+  utils::decl_ref_expr::DeclRefExprCache DeclRefs;
 };
 
 } // namespace performance
@@ -39,14 +39,6 @@ bool isSubset(const S &SubsetCandidate, const S &SupersetCandidate) {
   return true;
 }
 
-bool isReferencedOutsideOfCallExpr(const FunctionDecl &Function,
-                                   ASTContext &Context) {
-  auto Matches = match(declRefExpr(to(functionDecl(equalsNode(&Function))),
-                                   unless(hasAncestor(callExpr()))),
-                       Context);
-  return !Matches.empty();
-}
-
 bool hasLoopStmtAncestor(const DeclRefExpr &DeclRef, const Decl &Decl,
                          ASTContext &Context) {
   auto Matches =
@@ -89,10 +81,12 @@ void UnnecessaryValueParamCheck::check(const MatchFinder::MatchResult &Result) {
   bool IsConstQualified =
       Param->getType().getCanonicalType().isConstQualified();
 
-  auto AllDeclRefExprs = utils::decl_ref_expr::allDeclRefExprs(
-      *Param, *Function, *Result.Context);
-  auto ConstDeclRefExprs = utils::decl_ref_expr::constReferenceDeclRefExprs(
-      *Param, *Function, *Result.Context);
+  const DeclRefIndex &RefIndex = getDeclRefIndex(*Result.Context);
+  // All references to a parameter are within its function, so they can be
+  // taken from the translation unit index.
+  auto AllDeclRefExprs =
+      utils::decl_ref_expr::allDeclRefExprs(*Param, RefIndex);
+  const auto &ConstDeclRefExprs = DeclRefs.get(*Param, *Function).Const;
 
   // Do not trigger on non-const value parameters when they are not only used as
   // const.
@@ -136,7 +130,7 @@ void UnnecessaryValueParamCheck::check(const MatchFinder::MatchResult &Result) {
   //    compilation unit as the signature change could introduce build errors.
   const auto *Method = llvm::dyn_cast<CXXMethodDecl>(Function);
   if (Param->getLocStart().isMacroID() || (Method && Method->isVirtual()) ||
-      isReferencedOutsideOfCallExpr(*Function, *Result.Context))
+      RefIndex.isReferencedOutsideOfCall(Function))
     return;
   for (const auto *FunctionDecl = Function; FunctionDecl != nullptr;
        FunctionDecl = FunctionDecl->getPreviousDecl()) {
@@ -154,8 +148,8 @@ void UnnecessaryValueParamCheck::check(const MatchFinder::MatchResult &Result) {
 void UnnecessaryValueParamCheck::registerPPCallbacks(
     CompilerInstance &Compiler) {
   Inserter.reset(new utils::IncludeInserter(
-      Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle));
-  Compiler.getPreprocessor().addPPCallbacks(Inserter->CreatePPCallbacks());
+      Compiler.getSourceManager(), Compiler.getLangOpts(), IncludeStyle,
+      getIncludeDirectives(Compiler.getPreprocessor())));
 }
 
 void UnnecessaryValueParamCheck::storeOptions(
@@ -11,6 +11,7 @@
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_PERFORMANCE_UNNECESSARY_VALUE_PARAM_H
 
 #include "../ClangTidy.h"
+#include "../utils/DeclRefExprUtils.h"
 #include "../utils/IncludeInserter.h"
 
 namespace clang {
@@ -34,6 +35,9 @@ private:
   void handleMoveFix(const ParmVarDecl &Var, const DeclRefExpr &CopyArgument,
                      const ASTContext &Context);
 
+  // The parameters of a function share the classification of the references
+  // within it.
+  utils::decl_ref_expr::DeclRefExprCache DeclRefs;
   std::unique_ptr<utils::IncludeInserter> Inserter;
   const utils::IncludeSorter::IncludeStyle IncludeStyle;
 };
@@ -114,7 +114,8 @@ bool areParensNeededForStatement(const Stmt *Statement) {
 
 void addFixItHintsForGenericExpressionCastToBool(
     DiagnosticBuilder &Diagnostic, const ImplicitCastExpr *CastExpression,
-    const Stmt *ParentStatement, ASTContext &Context) {
+    const Stmt *ParentStatement, ASTContext &Context,
+    ScopedParentMap &Parents) {
   // In case of expressions like (! integer), we should remove the redundant not
   // operator and use inverted comparison (integer == 0).
   bool InvertComparison =
@@ -126,7 +127,7 @@ void addFixItHintsForGenericExpressionCastToBool(
     Diagnostic.AddFixItHint(FixItHint::CreateRemoval(
         CharSourceRange::getCharRange(ParentStartLoc, ParentEndLoc)));
 
-    auto FurtherParents = Context.getParents(*ParentStatement);
+    auto FurtherParents = Parents.getParents(*ParentStatement);
     ParentStatement = FurtherParents[0].get<Stmt>();
   }
 
@@ -281,20 +282,38 @@ void addFixItHintsForLiteralCastFromBool(DiagnosticBuilder &Diagnostic,
                                          Context)));
 }
 
-StatementMatcher createConditionalExpressionMatcher() {
-  return stmt(anyOf(ifStmt(), conditionalOperator(),
-                    parenExpr(hasParent(conditionalOperator()))));
+bool isConditionalExpression(const Stmt *Statement, ScopedParentMap &Parents) {
+  if (isa<IfStmt>(Statement) || isa<ConditionalOperator>(Statement))
+    return true;
+  if (!isa<ParenExpr>(Statement))
+    return false;
+  for (const auto &Parent : Parents.getParents(*Statement)) {
+    if (Parent.get<ConditionalOperator>())
+      return true;
+  }
+  return false;
 }
 
 bool isAllowedConditionalCast(const ImplicitCastExpr *CastExpression,
-                              ASTContext &Context) {
-  auto AllowedConditionalMatcher = stmt(hasParent(stmt(
-      anyOf(createConditionalExpressionMatcher(),
-            unaryOperator(hasOperatorName("!"),
-                          hasParent(createConditionalExpressionMatcher()))))));
-
-  auto MatchResult = match(AllowedConditionalMatcher, *CastExpression, Context);
-  return !MatchResult.empty();
+                              ScopedParentMap &Parents) {
+  for (const auto &Parent : Parents.getParents(*CastExpression)) {
+    const auto *ParentStatement = Parent.get<Stmt>();
+    if (!ParentStatement)
+      continue;
+    if (isConditionalExpression(ParentStatement, Parents))
+      return true;
+
+    const auto *NotOperator = dyn_cast<UnaryOperator>(ParentStatement);
+    if (!NotOperator || NotOperator->getOpcode() != UO_LNot)
+      continue;
+    for (const auto &FurtherParent : Parents.getParents(*NotOperator)) {
+      const auto *FurtherStatement = FurtherParent.get<Stmt>();
+      if (FurtherStatement &&
+          isConditionalExpression(FurtherStatement, Parents))
+        return true;
+    }
+  }
+  return false;
 }
 
 } // anonymous namespace
@@ -380,13 +399,13 @@ void ImplicitBoolCastCheck::handleCastToBool(
   if (AllowConditionalPointerCasts &&
       (CastExpression->getCastKind() == CK_PointerToBoolean ||
        CastExpression->getCastKind() == CK_MemberPointerToBoolean) &&
-      isAllowedConditionalCast(CastExpression, Context)) {
+      isAllowedConditionalCast(CastExpression, getParentMap(Context))) {
     return;
   }
 
   if (AllowConditionalIntegerCasts &&
       CastExpression->getCastKind() == CK_IntegralToBoolean &&
-      isAllowedConditionalCast(CastExpression, Context)) {
+      isAllowedConditionalCast(CastExpression, getParentMap(Context))) {
     return;
   }
 
@@ -402,7 +421,8 @@ void ImplicitBoolCastCheck::handleCastToBool(
                                       EquivalentLiteralExpression);
   } else {
     addFixItHintsForGenericExpressionCastToBool(Diagnostic, CastExpression,
-                                                ParentStatement, Context);
+                                                ParentStatement, Context,
+                                                getParentMap(Context));
   }
 }
 
@@ -16,7 +16,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "../ClangTidy.h"
+#include "../ResultsFile.h"
 #include "clang/Tooling/CommonOptionsParser.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
 
 using namespace clang::ast_matchers;
@@ -92,6 +94,28 @@ static cl::opt<bool>
     SystemHeaders("system-headers",
                   cl::desc("Display the errors from system headers."),
                   cl::init(false), cl::cat(ClangTidyCategory));
+static cl::opt<std::string> SkipHeaders("skip-headers", cl::desc(R"(
+Skips matching the top-level declarations of
+headers whose warnings are not displayed:
+  none     - match all declarations;
+  system   - skip system headers, unless
+             -system-headers is specified;
+  filtered - skip all headers not matching
+             -header-filter;
+  analyzed - like 'filtered', and also skip the
+             headers analyzed by an earlier input
+             file with the same contents and
+             options. Lossy: warnings that depend
+             on the includer, e.g. on its macros
+             or template instantiations, are only
+             reported as the first includer sees
+             them.
+This option overrides the 'SkipHeaders' option
+in .clang-tidy file, if any.
+)"),
+                                        cl::init("none"),
+                                        cl::cat(ClangTidyCategory));
+
 static cl::opt<std::string> LineFilter("line-filter", cl::desc(R"(
 List of files with line ranges to filter the
 warnings. Can be used together with
@@ -180,6 +204,40 @@ This option overrides the value read from a
                                            cl::init(false),
                                            cl::cat(ClangTidyCategory));
 
+static cl::opt<unsigned> AnalyzerMaxNodes("analyzer-max-nodes", cl::desc(R"(
+Maximum number of nodes explored by the
+clang-analyzer- checks per analyzed function.
+0 keeps the default of the static analyzer.
+This option overrides the value read from a
+.clang-tidy file.
+)"),
+                                          cl::init(0),
+                                          cl::cat(ClangTidyCategory));
+
+static cl::opt<unsigned> AnalyzerMaxNodesPerTU("analyzer-max-nodes-per-tu",
+                                               cl::desc(R"(
+Maximum number of nodes explored by the
+clang-analyzer- checks per translation unit,
+split evenly between the analyzed functions,
+up to the maximum per function of the static
+analyzer. 0 means no limit.
+This option overrides the value read from a
+.clang-tidy file.
+)"),
+                                               cl::init(0),
+                                               cl::cat(ClangTidyCategory));
+
+static cl::opt<bool> AnalyzerLineFilterOnly("analyzer-line-filter-only",
+                                            cl::desc(R"(
+Only run the clang-analyzer- checks on the
+declarations of the main file overlapping the
+line ranges of -line-filter.
+This option overrides the value read from a
+.clang-tidy file.
+)"),
+                                            cl::init(false),
+                                            cl::cat(ClangTidyCategory));
+
 static cl::opt<std::string> ExportFixes("export-fixes", cl::desc(R"(
 YAML file to store suggested fixes in. The
 stored fixes can be applied to the input source
@@ -188,6 +246,63 @@ code with clang-apply-replacements.
                                         cl::value_desc("filename"),
                                         cl::cat(ClangTidyCategory));
 
+static cl::opt<std::string> ExportResults("export-results", cl::desc(R"(
+File to store the diagnostics and suggested
+fixes in, using the compact results format read
+by clang-tidy-results. The file is written even
+if there are no diagnostics.
+)"),
+                                          cl::value_desc("filename"),
+                                          cl::cat(ClangTidyCategory));
+
+static cl::opt<std::string> ExportSummaries("export-summaries", cl::desc(R"(
+YAML file to store the cross-translation-unit
+summaries recorded by checks in, together with
+the ones read from -reduce-summaries. When
+specified, the summaries are not reduced in this
+run; pass the file to -reduce-summaries in a
+later run instead.
+)"),
+                                            cl::value_desc("filename"),
+                                            cl::cat(ClangTidyCategory));
+
+static cl::list<std::string> ReduceSummaries("reduce-summaries", cl::desc(R"(
+Comma-separated list of YAML files written by
+-export-summaries. The summaries are combined
+with the ones recorded for the input files, if
+any, and reduced by the checks that recorded
+them.
+)"),
+                                             cl::value_desc("filenames"),
+                                             cl::CommaSeparated,
+                                             cl::cat(ClangTidyCategory));
+
+static cl::opt<unsigned> ReduceThreads("reduce-threads", cl::desc(R"(
+Number of threads used to reduce the summaries.
+0 means one thread per hardware thread.
+)"),
+                                       cl::init(1),
+                                       cl::cat(ClangTidyCategory));
+
+static cl::opt<unsigned> FixThreads("fix-threads", cl::desc(R"(
+Number of threads used to apply fixes to
+different files. 0 means one thread per
+hardware thread.
+)"),
+                                    cl::init(0), cl::cat(ClangTidyCategory));
+
+static cl::opt<bool> SharePreambles("share-preambles", cl::desc(R"(
+Parse the #include directives that input files
+with identical compile commands start with only
+once, and share them through a precompiled
+header. Only headers guarded against multiple
+inclusion and compiling without warnings or
+errors are shared. Preprocessor-based checks
+don't see the contents of shared headers.
+)"),
+                                    cl::init(false),
+                                    cl::cat(ClangTidyCategory));
+
 namespace clang {
 namespace tidy {
 
@@ -208,6 +323,11 @@ static void printStats(const ClangTidyStats &Stats) {
       llvm::errs() << Separator << Stats.ErrorsIgnoredNOLINT << " NOLINT";
       Separator = ", ";
     }
+    if (Stats.ErrorsIgnoredDuplicateHeader) {
+      llvm::errs() << Separator << Stats.ErrorsIgnoredDuplicateHeader
+                   << " already reported in headers";
+      Separator = ", ";
+    }
     if (Stats.ErrorsIgnoredCheckFilter)
       llvm::errs() << Separator << Stats.ErrorsIgnoredCheckFilter
                    << " with check filters";
@@ -266,12 +386,24 @@ static std::unique_ptr<ClangTidyOptionsProvider> createOptionsProvider() {
     return nullptr;
   }
 
+  if (SkipHeaders != "none" && SkipHeaders != "system" &&
+      SkipHeaders != "filtered" && SkipHeaders != "analyzed") {
+    llvm::errs() << "Invalid SkipHeaders: '" << SkipHeaders
+                 << "', expected 'none', 'system', 'filtered' or "
+                    "'analyzed'.\n";
+    return nullptr;
+  }
+
   ClangTidyOptions DefaultOptions;
   DefaultOptions.Checks = DefaultChecks;
   DefaultOptions.WarningsAsErrors = "";
   DefaultOptions.HeaderFilterRegex = HeaderFilter;
   DefaultOptions.SystemHeaders = SystemHeaders;
+  DefaultOptions.SkipHeaders = SkipHeaders;
   DefaultOptions.AnalyzeTemporaryDtors = AnalyzeTemporaryDtors;
+  DefaultOptions.AnalyzerMaxNodes = AnalyzerMaxNodes;
+  DefaultOptions.AnalyzerMaxNodesPerTU = AnalyzerMaxNodesPerTU;
+  DefaultOptions.AnalyzerLineFilterOnly = AnalyzerLineFilterOnly;
   DefaultOptions.User = llvm::sys::Process::GetEnv("USER");
   // USERNAME is used on Windows.
   if (!DefaultOptions.User)
@@ -286,8 +418,16 @@ static std::unique_ptr<ClangTidyOptionsProvider> createOptionsProvider() {
     OverrideOptions.HeaderFilterRegex = HeaderFilter;
   if (SystemHeaders.getNumOccurrences() > 0)
     OverrideOptions.SystemHeaders = SystemHeaders;
+  if (SkipHeaders.getNumOccurrences() > 0)
+    OverrideOptions.SkipHeaders = SkipHeaders;
   if (AnalyzeTemporaryDtors.getNumOccurrences() > 0)
     OverrideOptions.AnalyzeTemporaryDtors = AnalyzeTemporaryDtors;
+  if (AnalyzerMaxNodes.getNumOccurrences() > 0)
+    OverrideOptions.AnalyzerMaxNodes = AnalyzerMaxNodes;
+  if (AnalyzerMaxNodesPerTU.getNumOccurrences() > 0)
+    OverrideOptions.AnalyzerMaxNodesPerTU = AnalyzerMaxNodesPerTU;
+  if (AnalyzerLineFilterOnly.getNumOccurrences() > 0)
+    OverrideOptions.AnalyzerLineFilterOnly = AnalyzerLineFilterOnly;
 
   if (!Config.empty()) {
     if (llvm::ErrorOr<ClangTidyOptions> ParsedConfig =
@@ -371,7 +511,7 @@ static int clangTidyMain(int argc, const char **argv) {
     return 1;
   }
 
-  if (PathList.empty()) {
+  if (PathList.empty() && ReduceSummaries.empty()) {
     llvm::errs() << "Error: no input files specified.\n";
     llvm::cl::PrintHelpMessage(/*Hidden=*/false, /*Categorized=*/true);
     return 1;
@@ -380,9 +520,39 @@ static int clangTidyMain(int argc, const char **argv) {
   ProfileData Profile;
 
   std::vector<ClangTidyError> Errors;
-  ClangTidyStats Stats =
-      runClangTidy(std::move(OptionsProvider), OptionsParser.getCompilations(),
-                   PathList, &Errors, EnableCheckProfile ? &Profile : nullptr);
+  std::vector<CheckSummary> Summaries;
+  ClangTidyStats Stats;
+  if (!PathList.empty())
+    Stats = runClangTidy(std::move(OptionsProvider),
+                         OptionsParser.getCompilations(), PathList, &Errors,
+                         EnableCheckProfile ? &Profile : nullptr, &Summaries,
+                         SharePreambles);
+
+  for (const std::string &SummaryFile : ReduceSummaries) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Text =
+        llvm::MemoryBuffer::getFile(SummaryFile);
+    std::error_code EC = Text.getError();
+    if (!EC)
+      EC = parseSummaries((*Text)->getBuffer(), Summaries);
+    if (EC) {
+      llvm::errs() << "Error reading " << SummaryFile << ": " << EC.message()
+                   << '\n';
+      return 1;
+    }
+  }
+
+  if (!ExportSummaries.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(ExportSummaries, EC, llvm::sys::fs::F_None);
+    if (EC) {
+      llvm::errs() << "Error opening output file: " << EC.message() << '\n';
+      return 1;
+    }
+    exportSummaries(Summaries, OS);
+  } else if (!Summaries.empty()) {
+    reduceSummaries(createOptionsProvider(), Summaries, Errors, ReduceThreads);
+  }
+
   bool FoundErrors =
       std::find_if(Errors.begin(), Errors.end(), [](const ClangTidyError &E) {
         return E.DiagLevel == ClangTidyError::Error;
@@ -394,7 +564,7 @@ static int clangTidyMain(int argc, const char **argv) {
 
   // -fix-errors implies -fix.
   handleErrors(Errors, (FixErrors || Fix) && !DisableFixes, FormatStyle,
-               WErrorCount);
+               WErrorCount, FixThreads);
 
   if (!ExportFixes.empty() && !Errors.empty()) {
     std::error_code EC;
@@ -406,6 +576,16 @@ static int clangTidyMain(int argc, const char **argv) {
     exportReplacements(FilePath.str(), Errors, OS);
   }
 
+  if (!ExportResults.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(ExportResults, EC, llvm::sys::fs::F_None);
+    if (EC) {
+      llvm::errs() << "Error opening output file: " << EC.message() << '\n';
+      return 1;
+    }
+    exportResults(FilePath.str(), Errors, OS);
+  }
+
   printStats(Stats);
   if (DisableFixes)
     llvm::errs()
@@ -0,0 +1,220 @@
+//===--- tools/extra/clang-tidy/ClangTidyResultsMain.cpp - clang-tidy -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+///  \file This file implements clang-tidy-results, a tool that queries, merges
+///  and converts the results files written by clang-tidy -export-results.
+///
+//===----------------------------------------------------------------------===//
+
+#include "../ClangTidy.h"
+#include "../ResultsFile.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Signals.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace llvm;
+using namespace clang::tidy;
+
+static cl::OptionCategory ResultsCategory("clang-tidy-results options");
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+                                        cl::desc("<results files>"),
+                                        cl::cat(ResultsCategory));
+
+static cl::opt<std::string> Checks("checks", cl::desc(R"(
+Comma-separated list of globs with optional '-'
+prefix selecting the checks whose diagnostics
+are output, in the same format as clang-tidy's
+-checks option. By default all diagnostics are
+output.
+)"),
+                                   cl::init(""), cl::cat(ResultsCategory));
+
+static cl::opt<std::string> PathPrefix("path-prefix", cl::desc(R"(
+Only output the diagnostics located in files
+whose path starts with this prefix. Only whole
+path components match: /a/b selects /a/b/c.h,
+but not /a/bc.h.
+)"),
+                                       cl::init(""), cl::cat(ResultsCategory));
+
+enum OutputFormat { OF_Results, OF_YAML, OF_Text, OF_Counts };
+
+static cl::opt<OutputFormat> Format(
+    "format", cl::desc("Output format:"),
+    cl::values(clEnumValN(OF_Results, "results",
+                          "a results file merging all inputs (default)"),
+               clEnumValN(OF_YAML, "yaml",
+                          "the YAML written by clang-tidy -export-fixes"),
+               clEnumValN(OF_Text, "text",
+                          "one line per diagnostic, located by the current "
+                          "contents of its file"),
+               clEnumValN(OF_Counts, "counts",
+                          "the number of diagnostics of each check")),
+    cl::init(OF_Results), cl::cat(ResultsCategory));
+
+static cl::opt<std::string> OutputFile("o", cl::desc("Output file"),
+                                       cl::value_desc("filename"),
+                                       cl::init("-"),
+                                       cl::cat(ResultsCategory));
+
+namespace {
+/// \brief Finds the line and column of file offsets in the current contents of
+/// the files.
+class LineTable {
+public:
+  /// \brief Sets \p Line and \p Column to the position of \p Offset in the file
+  /// at \p FilePath. Returns \c false if the file can't be read or is too
+  /// short.
+  bool getPosition(StringRef FilePath, unsigned Offset, unsigned &Line,
+                   unsigned &Column) {
+    auto Inserted = Files.insert(std::make_pair(FilePath, FileLines()));
+    FileLines &Lines = Inserted.first->second;
+    if (Inserted.second) {
+      llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+          MemoryBuffer::getFile(FilePath);
+      if (Buffer) {
+        StringRef Text = (*Buffer)->getBuffer();
+        Lines.Size = Text.size();
+        Lines.Starts.push_back(0);
+        for (size_t I = 0, E = Text.size(); I != E; ++I)
+          if (Text[I] == '\n')
+            Lines.Starts.push_back(I + 1);
+      }
+    }
+    if (Lines.Starts.empty() || Offset > Lines.Size)
+      return false;
+    auto Next =
+        std::upper_bound(Lines.Starts.begin(), Lines.Starts.end(), Offset);
+    Line = Next - Lines.Starts.begin();
+    Column = Offset - *(Next - 1) + 1;
+    return true;
+  }
+
+private:
+  struct FileLines {
+    FileLines() : Size(0) {}
+    size_t Size;
+    std::vector<unsigned> Starts;
+  };
+  llvm::StringMap<FileLines> Files;
+};
+} // namespace
+
+static void printText(ArrayRef<ClangTidyError> Errors, raw_ostream &OS) {
+  LineTable Lines;
+  for (const ClangTidyError &Error : Errors) {
+    unsigned Line, Column;
+    OS << Error.Message.FilePath;
+    if (Lines.getPosition(Error.Message.FilePath, Error.Message.FileOffset,
+                          Line, Column))
+      OS << ':' << Line << ':' << Column << ':';
+    else
+      OS << ": offset " << Error.Message.FileOffset << ':';
+    OS << ' '
+       << (Error.DiagLevel == ClangTidyError::Error ? "error" : "warning")
+       << ": " << Error.Message.Message << " [" << Error.DiagnosticName
+       << "]\n";
+  }
+}
+
+static void printCounts(ArrayRef<ClangTidyError> Errors, raw_ostream &OS) {
+  llvm::StringMap<unsigned> Counts;
+  for (const ClangTidyError &Error : Errors)
+    ++Counts[Error.DiagnosticName];
+  std::vector<std::pair<StringRef, unsigned>> Sorted;
+  for (const auto &Count : Counts)
+    Sorted.emplace_back(Count.getKey(), Count.getValue());
+  std::sort(Sorted.begin(), Sorted.end());
+  for (const auto &Count : Sorted)
+    OS << Count.second << ' ' << Count.first << '\n';
+}
+
+// Removes the diagnostics reported by several inputs, comparing them like
+// ClangTidyDiagnosticConsumer does within a run, and sorts them by location.
+static void removeDuplicates(std::vector<ClangTidyError> &Errors) {
+  auto Key = [](const ClangTidyError &Error) {
+    return std::tie(Error.Message.FilePath, Error.Message.FileOffset,
+                    Error.Message.Message, Error.DiagnosticName);
+  };
+  std::sort(Errors.begin(), Errors.end(),
+            [&](const ClangTidyError &LHS, const ClangTidyError &RHS) {
+              return Key(LHS) < Key(RHS);
+            });
+  Errors.erase(std::unique(Errors.begin(), Errors.end(),
+                           [&](const ClangTidyError &LHS,
+                               const ClangTidyError &RHS) {
+                             return Key(LHS) == Key(RHS);
+                           }),
+               Errors.end());
+}
+
+int main(int argc, const char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  cl::HideUnrelatedOptions(ResultsCategory);
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "Queries, merges and converts clang-tidy results files.\n\n"
+      "Reads the results files written by clang-tidy -export-results, selects\n"
+      "the diagnostics matching -checks and -path-prefix using the indexes of\n"
+      "the files, and writes them in the requested format.\n");
+
+  ResultsQuery Query;
+  Query.Checks = Checks;
+  Query.PathPrefix = PathPrefix;
+
+  std::vector<ClangTidyError> Errors;
+  std::string MainFilePath;
+  for (size_t I = 0; I < InputFiles.size(); ++I) {
+    llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+        MemoryBuffer::getFile(InputFiles[I]);
+    std::error_code EC = Buffer.getError();
+    std::string InputMainFilePath;
+    if (!EC)
+      EC = parseResults((*Buffer)->getBuffer(), Query, Errors,
+                        &InputMainFilePath);
+    if (EC) {
+      llvm::errs() << "Error reading " << InputFiles[I] << ": "
+                   << EC.message() << '\n';
+      return 1;
+    }
+    // Merged results only keep a main file that all inputs share.
+    if (I == 0)
+      MainFilePath = InputMainFilePath;
+    else if (MainFilePath != InputMainFilePath)
+      MainFilePath.clear();
+  }
+  removeDuplicates(Errors);
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_None);
+  if (EC) {
+    llvm::errs() << "Error opening output file: " << EC.message() << '\n';
+    return 1;
+  }
+  switch (Format) {
+  case OF_Results:
+    exportResults(MainFilePath, Errors, OS);
+    break;
+  case OF_YAML:
+    exportReplacements(MainFilePath, Errors, OS);
+    break;
+  case OF_Text:
+    printText(Errors, OS);
+    break;
+  case OF_Counts:
+    printCounts(Errors, OS);
+    break;
+  }
+  return 0;
+}
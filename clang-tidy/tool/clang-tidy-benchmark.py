@@ -0,0 +1,295 @@
+#!/usr/bin/env python
+#
+#===- clang-tidy-benchmark.py - clang-tidy benchmark suite ---*- python -*--===#
+#
+#                     The LLVM Compiler Infrastructure
+#
+# This file is distributed under the University of Illinois Open Source
+# License. See LICENSE.TXT for details.
+#
+#===------------------------------------------------------------------------===#
+
+r"""
+clang-tidy benchmark suite
+==========================
+
+Generates synthetic translation units of a configurable size and runs
+clang-tidy on each of them, once with every registered check enabled alone and
+once with all checks enabled together. For each run the script reports the
+matcher time of each check (as measured by -enable-check-profile) and the wall
+time of the whole process per thousand lines of code, as well as the peak
+memory usage of the process on POSIX systems.
+
+The results can be stored as a baseline and compared against later runs, so
+that checks whose cost grows faster than the code they inspect are caught
+early.
+
+Example invocations.
+- Benchmark all checks on the default set of translation units.
+    clang-tidy-benchmark.py -clang-tidy-binary=bin/clang-tidy
+
+- Benchmark the modernize checks on translation units twice as large, and
+  store the results as a baseline.
+    clang-tidy-benchmark.py -checks=-*,modernize-* -scale=2 \
+                            -save-baseline=baseline.json
+
+- Compare against the baseline, failing if any check got more than 50% slower.
+    clang-tidy-benchmark.py -checks=-*,modernize-* -scale=2 \
+                            -baseline=baseline.json -tolerance=1.5
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_functions(scale):
+  """Generates many small functions with loops, calls and local variables."""
+  lines = ['#include <vector>', '']
+  for i in range(1000 * scale):
+    lines += [
+        'int function%d(const std::vector<int> &v, int *p) {' % i,
+        '  int sum = 0;',
+        '  for (int j = 0; j < (int)v.size(); ++j)',
+        '    sum += v[j] * %d;' % (i % 7),
+        '  if (p != 0 && sum > %d)' % i,
+        '    *p = sum;',
+        '  return sum%s;' % (' + function%d(v, p)' % (i - 1) if i else ''),
+        '}',
+        '']
+  return lines
+
+
+def generate_templates(scale):
+  """Generates deeply nested class and function template instantiations."""
+  depth = 64
+  lines = [
+      'template <int N, typename T> struct Nest {',
+      '  typedef Nest<N - 1, T> Inner;',
+      '  T value;',
+      '  Inner inner;',
+      '  T get() const { return value + inner.get(); }',
+      '  template <typename U> U convert(U u) const {',
+      '    return inner.template convert<U>(u) + static_cast<U>(value);',
+      '  }',
+      '};',
+      'template <typename T> struct Nest<0, T> {',
+      '  T value;',
+      '  T get() const { return value; }',
+      '  template <typename U> U convert(U u) const { return u; }',
+      '};',
+      '']
+  for i in range(50 * scale):
+    lines += [
+        'struct Type%d { int x; Type%d(int x = 0) : x(x) {} };' % (i, i),
+        'inline int operator+(Type%d a, Type%d b) { return a.x + b.x; }' %
+        (i, i),
+        'long instantiate%d() {' % i,
+        '  Nest<%d, long> n;' % depth,
+        '  Nest<%d, int> m;' % (depth - i % 8),
+        '  return n.get() + m.convert<long>(%d);' % i,
+        '}',
+        '']
+  return lines
+
+
+def generate_macros(scale):
+  """Generates code that mostly comes from nested macro expansions."""
+  lines = [
+      '#define CONCAT_(a, b) a##b',
+      '#define CONCAT(a, b) CONCAT_(a, b)',
+      '#define CHECK(x) do { if (!(x)) return -1; } while (0)',
+      '#define FIELD(type, name) type name; type CONCAT(get_, name)() const '
+      '{ return name; }',
+      '#define STRUCT(name, a, b) struct name { FIELD(int, a) FIELD(long, b) };',
+      '#define FUNCTION(name, s) int name(const s &x) { CHECK(x.get_first() > '
+      '0); CHECK(x.get_second() != 0); return x.first + (int)x.second; }',
+      '']
+  for i in range(1000 * scale):
+    lines += [
+        'STRUCT(Macro%d, first, second)' % i,
+        'FUNCTION(macroFunction%d, Macro%d)' % (i, i),
+        '']
+  return lines
+
+
+def generate_initializers(scale):
+  """Generates long initializer lists of numbers, strings and structs."""
+  lines = ['struct Entry { const char *name; int value; double weight; };', '']
+  for i in range(10 * scale):
+    lines.append('int numbers%d[] = {' % i)
+    lines += ['  %d, %d, %d, %d, %d, %d, %d, %d,' % tuple(range(j, j + 8))
+              for j in range(0, 800, 8)]
+    lines += ['};', 'const char *strings%d[] = {' % i]
+    lines += ['  "string%d", "string%d", "string%d", "string%d",' %
+              tuple(range(j, j + 4)) for j in range(0, 400, 4)]
+    lines += ['};', 'Entry entries%d[] = {' % i]
+    lines += ['  {"entry%d", %d, %d.5},' % (j, j, j) for j in range(200)]
+    lines += ['};', '']
+  return lines
+
+
+GENERATORS = [
+    ('functions', generate_functions),
+    ('templates', generate_templates),
+    ('macros', generate_macros),
+    ('initializers', generate_initializers),
+]
+
+
+def get_checks(args):
+  """Returns the names of the checks enabled by args.checks."""
+  invocation = [args.clang_tidy_binary, '-list-checks', '-checks=' + args.checks,
+                '--']
+  output = subprocess.check_output(invocation).decode('utf-8')
+  return [line.strip() for line in output.splitlines()[1:] if line.strip()]
+
+
+def parse_profile(output):
+  """Returns the wall time of each check reported by -enable-check-profile."""
+  times = {}
+  for line in output.splitlines():
+    # The wall time is the last time column; the check name is the last word.
+    columns = re.findall(r'(\d+\.\d+) \(\s*\d+\.\d+%\)', line)
+    words = line.split()
+    if columns and words and words[-1] != 'Total':
+      times[words[-1]] = float(columns[-1])
+  return times
+
+
+def run_tidy(args, checks, filename):
+  """Runs clang-tidy on filename and returns the wall time, the peak resident
+  memory in megabytes and the profile of each check."""
+  invocation = [args.clang_tidy_binary, '-checks=' + checks,
+                '-enable-check-profile', filename, '--', '-std=c++11']
+  invocation += args.extra_arg
+  start = time.time()
+  process = subprocess.Popen(invocation, stdout=open(os.devnull, 'w'),
+                             stderr=subprocess.PIPE)
+  output = process.stderr.read().decode('utf-8', 'replace')
+  if not hasattr(os, 'wait4'):
+    # The resource usage of a single process is only available on POSIX
+    # systems; report no peak memory elsewhere.
+    process.wait()
+    return time.time() - start, 0.0, parse_profile(output)
+  _, _, usage = os.wait4(process.pid, 0)
+  wall_time = time.time() - start
+  # ru_maxrss is in bytes on Darwin and in kilobytes elsewhere.
+  peak_memory = usage.ru_maxrss / 1024.0
+  if sys.platform == 'darwin':
+    peak_memory /= 1024.0
+  return wall_time, peak_memory, parse_profile(output)
+
+
+def compare(results, baseline, tolerance):
+  """Prints the results exceeding the baseline by more than tolerance and
+  returns their number."""
+  regressions = 0
+  for key in sorted(results):
+    if key not in baseline:
+      continue
+    for metric in ['match_ms_per_kloc', 'wall_ms_per_kloc',
+                   'peak_memory_mb']:
+      old = baseline[key][metric]
+      new = results[key][metric]
+      if old > 0 and new > old * tolerance:
+        print('Regression in %s: %s %.2f -> %.2f' % (key, metric, old, new))
+        regressions += 1
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(description='Runs clang-tidy checks on '
+                                   'synthetic translation units and reports '
+                                   'their cost per thousand lines of code.')
+  parser.add_argument('-clang-tidy-binary', metavar='PATH',
+                      default='clang-tidy',
+                      help='path to clang-tidy binary')
+  parser.add_argument('-checks', default='*',
+                      help='checks filter selecting the checks to benchmark')
+  parser.add_argument('-scale', type=int, default=1,
+                      help='size multiplier of the generated translation '
+                      'units')
+  parser.add_argument('-tu', dest='tus', action='append',
+                      choices=[name for name, _ in GENERATORS],
+                      help='kinds of translation units to generate, all by '
+                      'default')
+  parser.add_argument('-only-all', action='store_true',
+                      help='only run all checks together')
+  parser.add_argument('-extra-arg', dest='extra_arg',
+                      action='append', default=[],
+                      help='Additional argument to append to the compiler '
+                      'command line.')
+  parser.add_argument('-baseline', metavar='FILE',
+                      help='compare the results against this baseline')
+  parser.add_argument('-tolerance', type=float, default=1.5,
+                      help='maximum ratio of a result to its baseline')
+  parser.add_argument('-save-baseline', metavar='FILE',
+                      help='store the results as a baseline in this file')
+  args = parser.parse_args()
+
+  try:
+    checks = get_checks(args)
+  except (OSError, subprocess.CalledProcessError):
+    print('Unable to run clang-tidy.', file=sys.stderr)
+    sys.exit(1)
+
+  runs = [('all', ','.join(['-*'] + checks))]
+  if not args.only_all:
+    runs += [(check, '-*,' + check) for check in checks]
+
+  tmpdir = tempfile.mkdtemp()
+  results = {}
+  try:
+    for name, generator in GENERATORS:
+      if args.tus and name not in args.tus:
+        continue
+      lines = generator(args.scale)
+      kloc = len(lines) / 1000.0
+      filename = os.path.join(tmpdir, name + '.cpp')
+      with open(filename, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+      print('%s.cpp: %.1f KLOC' % (name, kloc))
+      print('  %-50s %12s %12s %10s' % ('check', 'match ms/KLOC',
+                                        'wall ms/KLOC', 'peak MB'))
+      for run_name, run_checks in runs:
+        wall_time, peak_memory, profile = run_tidy(args, run_checks, filename)
+        if run_name == 'all':
+          match_time = sum(profile.values())
+        else:
+          match_time = profile.get(run_name, 0.0)
+        result = {
+            'match_ms_per_kloc': match_time * 1000 / kloc,
+            'wall_ms_per_kloc': wall_time * 1000 / kloc,
+            'peak_memory_mb': peak_memory,
+        }
+        results['%s:%s' % (name, run_name)] = result
+        print('  %-50s %12.2f %12.2f %10.1f' % (
+            run_name, result['match_ms_per_kloc'], result['wall_ms_per_kloc'],
+            result['peak_memory_mb']))
+        sys.stdout.flush()
+  finally:
+    shutil.rmtree(tmpdir)
+
+  if args.save_baseline:
+    with open(args.save_baseline, 'w') as f:
+      json.dump(results, f, indent=2, sort_keys=True)
+
+  if args.baseline:
+    with open(args.baseline) as f:
+      baseline = json.load(f)
+    if compare(results, baseline, args.tolerance):
+      sys.exit(1)
+
+
+if __name__ == '__main__':
+  main()
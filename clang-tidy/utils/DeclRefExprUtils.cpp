@@ -11,6 +11,7 @@
 #include "Matchers.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclCXX.h"
+#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 
 namespace clang {
@@ -30,45 +31,143 @@ template <typename S> bool isSetDifferenceEmpty(const S &S1, const S &S2) {
   return true;
 }
 
-// Extracts all Nodes keyed by ID from Matches and inserts them into Nodes.
-template <typename Node>
-void extractNodesByIdTo(ArrayRef<BoundNodes> Matches, StringRef ID,
-                        SmallPtrSet<const Node *, 16> &Nodes) {
-  for (const auto &Match : Matches)
-    Nodes.insert(Match.getNodeAs<Node>(ID));
+// Returns true if a parameter of type \p ParamType only allows const access to
+// its argument, i.e. it is a const reference or a value that isn't a pointer.
+// Like the AST matchers, this does not look through type sugar.
+bool isConstReferenceOrValue(QualType ParamType) {
+  if (const auto *Ref = dyn_cast<ReferenceType>(ParamType.getTypePtr()))
+    return Ref->getPointeeType().isConstQualified();
+  return !isa<PointerType>(ParamType.getTypePtr());
 }
 
+// Classifies all references to variables within a statement or declaration in
+// a single traversal. If \p Only is set, other variables are ignored.
+//
+// A reference is const if a const method or member operator is called on the
+// variable, or if the variable is passed to a const reference or value
+// parameter of a CallExpr or CXXConstructExpr.
+class DeclRefClassifier : public RecursiveASTVisitor<DeclRefClassifier> {
+public:
+  DeclRefClassifier(ScopeDeclRefs &Uses, const VarDecl *Only)
+      : Uses(Uses), Only(Only) {}
+
+  // Visit the same nodes as the AST matchers do.
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool VisitDeclRefExpr(DeclRefExpr *Ref) {
+    if (const auto *Var = dyn_cast<VarDecl>(Ref->getDecl()))
+      if (!Only || Var == Only)
+        Uses[Var].All.insert(Ref);
+    return true;
+  }
+
+  bool VisitCXXMemberCallExpr(CXXMemberCallExpr *Call) {
+    if (isConstMethod(Call->getCalleeDecl()))
+      if (const Expr *Object = Call->getImplicitObjectArgument())
+        addConstUse(Object->IgnoreParenImpCasts());
+    return true;
+  }
+
+  bool VisitCallExpr(CallExpr *Call) {
+    const Decl *Callee = Call->getCalleeDecl();
+    ArrayRef<const Expr *> Args(Call->getArgs(), Call->getNumArgs());
+    // The first argument of an overloaded member operator is the implicit
+    // object argument, which doesn't correspond to a parameter.
+    if (isa<CXXOperatorCallExpr>(Call) && Callee &&
+        isa<CXXMethodDecl>(Callee) && !Args.empty()) {
+      if (isConstMethod(Callee))
+        addConstUse(Args.front()->IgnoreParenImpCasts());
+      Args = Args.drop_front();
+    }
+    addConstArguments(dyn_cast_or_null<FunctionDecl>(Callee), Args);
+    return true;
+  }
+
+  bool VisitCXXConstructExpr(CXXConstructExpr *Construct) {
+    addConstArguments(Construct->getConstructor(),
+                      ArrayRef<const Expr *>(Construct->getArgs(),
+                                             Construct->getNumArgs()));
+    return true;
+  }
+
+private:
+  static bool isConstMethod(const Decl *D) {
+    const auto *Method = dyn_cast_or_null<CXXMethodDecl>(D);
+    return Method && Method->isConst();
+  }
+
+  void addConstUse(const Expr *E) {
+    if (const auto *Ref = dyn_cast<DeclRefExpr>(E))
+      if (const auto *Var = dyn_cast<VarDecl>(Ref->getDecl()))
+        if (!Only || Var == Only)
+          Uses[Var].Const.insert(Ref);
+  }
+
+  void addConstArguments(const FunctionDecl *Callee,
+                         ArrayRef<const Expr *> Args) {
+    if (!Callee)
+      return;
+    for (unsigned I = 0, E = std::min<unsigned>(Args.size(),
+                                                Callee->getNumParams());
+         I != E; ++I)
+      if (isConstReferenceOrValue(Callee->getParamDecl(I)->getType()))
+        addConstUse(Args[I]->IgnoreParenCasts());
+  }
+
+  ScopeDeclRefs &Uses;
+  const VarDecl *Only;
+};
+
 } // namespace
 
+ScopeDeclRefs classifyDeclRefExprs(const Stmt &Stmt, const VarDecl *Only) {
+  ScopeDeclRefs Uses;
+  DeclRefClassifier(Uses, Only).TraverseStmt(const_cast<class Stmt *>(&Stmt));
+  return Uses;
+}
+
+ScopeDeclRefs classifyDeclRefExprs(const Decl &Decl, const VarDecl *Only) {
+  ScopeDeclRefs Uses;
+  DeclRefClassifier(Uses, Only).TraverseDecl(const_cast<class Decl *>(&Decl));
+  return Uses;
+}
+
+static const VarDeclRefs &getVarDeclRefs(const ScopeDeclRefs &Uses,
+                                         const VarDecl &Var) {
+  static const VarDeclRefs Empty;
+  auto It = Uses.find(&Var);
+  return It == Uses.end() ? Empty : It->second;
+}
+
+const VarDeclRefs &DeclRefExprCache::get(const VarDecl &Var,
+                                         const Stmt &Stmt) {
+  auto It = Scopes.find(&Stmt);
+  if (It == Scopes.end())
+    It = Scopes.insert({&Stmt, classifyDeclRefExprs(Stmt)}).first;
+  return getVarDeclRefs(It->second, Var);
+}
+
+const VarDeclRefs &DeclRefExprCache::get(const VarDecl &Var,
+                                         const Decl &Decl) {
+  auto It = Scopes.find(&Decl);
+  if (It == Scopes.end())
+    It = Scopes.insert({&Decl, classifyDeclRefExprs(Decl)}).first;
+  return getVarDeclRefs(It->second, Var);
+}
+
+bool DeclRefExprCache::isOnlyUsedAsConst(const VarDecl &Var,
+                                         const Stmt &Stmt) {
+  const VarDeclRefs &Refs = get(Var, Stmt);
+  return isSetDifferenceEmpty(Refs.All, Refs.Const);
+}
+
 // Finds all DeclRefExprs where a const method is called on VarDecl or VarDecl
 // is the a const reference or value argument to a CallExpr or CXXConstructExpr.
 SmallPtrSet<const DeclRefExpr *, 16>
 constReferenceDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt,
                            ASTContext &Context) {
-  auto DeclRefToVar =
-      declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef");
-  auto ConstMethodCallee = callee(cxxMethodDecl(isConst()));
-  // Match method call expressions where the variable is referenced as the this
-  // implicit object argument and opertor call expression for member operators
-  // where the variable is the 0-th argument.
-  auto Matches = match(
-      findAll(expr(anyOf(cxxMemberCallExpr(ConstMethodCallee, on(DeclRefToVar)),
-                         cxxOperatorCallExpr(ConstMethodCallee,
-                                             hasArgument(0, DeclRefToVar))))),
-      Stmt, Context);
-  SmallPtrSet<const DeclRefExpr *, 16> DeclRefs;
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  auto ConstReferenceOrValue =
-      qualType(anyOf(referenceType(pointee(qualType(isConstQualified()))),
-                     unless(anyOf(referenceType(), pointerType()))));
-  auto UsedAsConstRefOrValueArg = forEachArgumentWithParam(
-      DeclRefToVar, parmVarDecl(hasType(ConstReferenceOrValue)));
-  Matches = match(findAll(callExpr(UsedAsConstRefOrValueArg)), Stmt, Context);
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  Matches =
-      match(findAll(cxxConstructExpr(UsedAsConstRefOrValueArg)), Stmt, Context);
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  return DeclRefs;
+  return getVarDeclRefs(classifyDeclRefExprs(Stmt, &VarDecl), VarDecl).Const;
 }
 
 // Finds all DeclRefExprs where a const method is called on VarDecl or VarDecl
@@ -76,33 +175,7 @@ constReferenceDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt,
 SmallPtrSet<const DeclRefExpr *, 16>
 constReferenceDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl,
                            ASTContext &Context) {
-  auto DeclRefToVar =
-      declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef");
-  auto ConstMethodCallee = callee(cxxMethodDecl(isConst()));
-  // Match method call expressions where the variable is referenced as the this
-  // implicit object argument and opertor call expression for member operators
-  // where the variable is the 0-th argument.
-  auto Matches =
-      match(decl(forEachDescendant(expr(
-                anyOf(cxxMemberCallExpr(ConstMethodCallee, on(DeclRefToVar)),
-                      cxxOperatorCallExpr(ConstMethodCallee,
-                                          hasArgument(0, DeclRefToVar)))))),
-            Decl, Context);
-  SmallPtrSet<const DeclRefExpr *, 16> DeclRefs;
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  auto ConstReferenceOrValue =
-      qualType(anyOf(referenceType(pointee(qualType(isConstQualified()))),
-                     unless(anyOf(referenceType(), pointerType()))));
-  auto UsedAsConstRefOrValueArg = forEachArgumentWithParam(
-      DeclRefToVar, parmVarDecl(hasType(ConstReferenceOrValue)));
-  Matches = match(decl(forEachDescendant(callExpr(UsedAsConstRefOrValueArg))),
-                  Decl, Context);
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  Matches =
-      match(decl(forEachDescendant(cxxConstructExpr(UsedAsConstRefOrValueArg))),
-            Decl, Context);
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  return DeclRefs;
+  return getVarDeclRefs(classifyDeclRefExprs(Decl, &VarDecl), VarDecl).Const;
 }
 
 bool isOnlyUsedAsConst(const VarDecl &Var, const Stmt &Stmt,
@@ -112,29 +185,26 @@ bool isOnlyUsedAsConst(const VarDecl &Var, const Stmt &Stmt,
   // reference parameter.
   // If the difference is empty it is safe for the loop variable to be a const
   // reference.
-  auto AllDeclRefs = allDeclRefExprs(Var, Stmt, Context);
-  auto ConstReferenceDeclRefs = constReferenceDeclRefExprs(Var, Stmt, Context);
-  return isSetDifferenceEmpty(AllDeclRefs, ConstReferenceDeclRefs);
+  ScopeDeclRefs Uses = classifyDeclRefExprs(Stmt, &Var);
+  const VarDeclRefs &Refs = getVarDeclRefs(Uses, Var);
+  return isSetDifferenceEmpty(Refs.All, Refs.Const);
 }
 
 SmallPtrSet<const DeclRefExpr *, 16>
 allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context) {
-  auto Matches = match(
-      findAll(declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef")),
-      Stmt, Context);
-  SmallPtrSet<const DeclRefExpr *, 16> DeclRefs;
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
-  return DeclRefs;
+  return getVarDeclRefs(classifyDeclRefExprs(Stmt, &VarDecl), VarDecl).All;
 }
 
 SmallPtrSet<const DeclRefExpr *, 16>
 allDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl, ASTContext &Context) {
-  auto Matches = match(
-      decl(forEachDescendant(
-          declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef"))),
-      Decl, Context);
+  return getVarDeclRefs(classifyDeclRefExprs(Decl, &VarDecl), VarDecl).All;
+}
+
+SmallPtrSet<const DeclRefExpr *, 16>
+allDeclRefExprs(const VarDecl &VarDecl, const DeclRefIndex &Index) {
   SmallPtrSet<const DeclRefExpr *, 16> DeclRefs;
-  extractNodesByIdTo(Matches, "declRef", DeclRefs);
+  for (const DeclRefIndex::Reference &R : Index.references(&VarDecl))
+    DeclRefs.insert(R.Ref);
   return DeclRefs;
 }
 
@@ -10,8 +10,10 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_UTILS_DECLREFEXPRUTILS_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_UTILS_DECLREFEXPRUTILS_H
 
+#include "../DeclRefIndex.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Type.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 
 namespace clang {
@@ -19,6 +21,53 @@ namespace tidy {
 namespace utils {
 namespace decl_ref_expr {
 
+/// \brief The references to one variable within a statement or declaration.
+struct VarDeclRefs {
+  /// All ``DeclRefExprs`` to the variable.
+  llvm::SmallPtrSet<const DeclRefExpr *, 16> All;
+  /// The ``DeclRefExprs`` where the variable is guaranteed to be accessed in a
+  /// const fashion. This is a subset of ``All``.
+  llvm::SmallPtrSet<const DeclRefExpr *, 16> Const;
+};
+
+/// \brief The references to each variable referenced within a statement or
+/// declaration.
+using ScopeDeclRefs = llvm::DenseMap<const VarDecl *, VarDeclRefs>;
+
+/// \brief Classifies all ``DeclRefExprs`` to variables within ``Stmt`` in a
+/// single traversal. If ``Only`` is not null, only references to that variable
+/// are collected.
+ScopeDeclRefs classifyDeclRefExprs(const Stmt &Stmt,
+                                   const VarDecl *Only = nullptr);
+
+/// \brief Classifies all ``DeclRefExprs`` to variables within ``Decl`` in a
+/// single traversal. If ``Only`` is not null, only references to that variable
+/// are collected.
+ScopeDeclRefs classifyDeclRefExprs(const Decl &Decl,
+                                   const VarDecl *Only = nullptr);
+
+/// \brief Caches the classification of ``DeclRefExprs`` per scope, so that
+/// queries for several variables in the same statement or declaration share a
+/// single traversal.
+///
+/// The cache holds pointers into the AST and must not outlive the translation
+/// unit, so checks should own one as a member.
+class DeclRefExprCache {
+public:
+  /// Returns the references to ``Var`` within ``Stmt``.
+  const VarDeclRefs &get(const VarDecl &Var, const Stmt &Stmt);
+
+  /// Returns the references to ``Var`` within ``Decl``.
+  const VarDeclRefs &get(const VarDecl &Var, const Decl &Decl);
+
+  /// Same as the ``isOnlyUsedAsConst`` function, using the cache.
+  bool isOnlyUsedAsConst(const VarDecl &Var, const Stmt &Stmt);
+
+private:
+  // Keyed by the Stmt or Decl the references were collected in.
+  llvm::DenseMap<const void *, ScopeDeclRefs> Scopes;
+};
+
 /// \brief Returns true if all ``DeclRefExpr`` to the variable within ``Stmt``
 /// do not modify it.
 ///
@@ -36,6 +85,11 @@ allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context);
 llvm::SmallPtrSet<const DeclRefExpr *, 16>
 allDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl, ASTContext &Context);
 
+/// Returns set of all ``DeclRefExprs`` to ``VarDecl`` in the translation unit
+/// indexed by ``Index``.
+llvm::SmallPtrSet<const DeclRefExpr *, 16>
+allDeclRefExprs(const VarDecl &VarDecl, const DeclRefIndex &Index);
+
 /// Returns set of all ``DeclRefExprs`` to ``VarDecl`` within ``Stmt`` where
 /// ``VarDecl`` is guaranteed to be accessed in a const fashion.
 llvm::SmallPtrSet<const DeclRefExpr *, 16>
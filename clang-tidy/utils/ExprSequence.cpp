@@ -25,11 +25,11 @@ namespace utils {
 // nodes in their subtree because RecursiveASTVisitor visits both the syntactic
 // and semantic forms of InitListExpr, and the parent-child relationships are
 // different between the two forms.
-static SmallVector<const Stmt *, 1> getParentStmts(const Stmt *S,
-                                                   ASTContext *Context) {
+static SmallVector<const Stmt *, 1>
+getParentStmts(const Stmt *S, ScopedParentMap *ParentMap) {
   SmallVector<const Stmt *, 1> Result;
 
-  ASTContext::DynTypedNodeList Parents = Context->getParents(*S);
+  ASTContext::DynTypedNodeList Parents = ParentMap->getParents(*S);
 
   SmallVector<ast_type_traits::DynTypedNode, 1> NodesToProcess(Parents.begin(),
                                                                Parents.end());
@@ -41,7 +41,7 @@ static SmallVector<const Stmt *, 1> getParentStmts(const Stmt *S,
     if (const auto *S = Node.get<Stmt>()) {
       Result.push_back(S);
     } else {
-      Parents = Context->getParents(Node);
+      Parents = ParentMap->getParents(Node);
       NodesToProcess.append(Parents.begin(), Parents.end());
     }
   }
@@ -51,11 +51,11 @@ static SmallVector<const Stmt *, 1> getParentStmts(const Stmt *S,
 
 namespace {
 bool isDescendantOrEqual(const Stmt *Descendant, const Stmt *Ancestor,
-                         ASTContext *Context) {
+                         ScopedParentMap *Parents) {
   if (Descendant == Ancestor)
     return true;
-  for (const Stmt *Parent : getParentStmts(Descendant, Context)) {
-    if (isDescendantOrEqual(Parent, Ancestor, Context))
+  for (const Stmt *Parent : getParentStmts(Descendant, Parents)) {
+    if (isDescendantOrEqual(Parent, Ancestor, Parents))
       return true;
   }
 
@@ -63,8 +63,8 @@ bool isDescendantOrEqual(const Stmt *Descendant, const Stmt *Ancestor,
 }
 }
 
-ExprSequence::ExprSequence(const CFG *TheCFG, ASTContext *TheContext)
-    : Context(TheContext) {
+ExprSequence::ExprSequence(const CFG *TheCFG, ScopedParentMap &TheParents)
+    : Parents(&TheParents) {
   for (const auto &SyntheticStmt : TheCFG->synthetic_stmts()) {
     SyntheticStmtSourceMap[SyntheticStmt.first] = SyntheticStmt.second;
   }
@@ -78,13 +78,13 @@ bool ExprSequence::inSequence(const Stmt *Before, const Stmt *After) const {
   // chain of successors, we know that 'After' is sequenced after 'Before'.
   for (const Stmt *Successor = getSequenceSuccessor(Before); Successor;
        Successor = getSequenceSuccessor(Successor)) {
-    if (isDescendantOrEqual(After, Successor, Context))
+    if (isDescendantOrEqual(After, Successor, Parents))
       return true;
   }
 
   // If 'After' is a parent of 'Before' or is sequenced after one of these
   // parents, we know that it is sequenced after 'Before'.
-  for (const Stmt *Parent : getParentStmts(Before, Context)) {
+  for (const Stmt *Parent : getParentStmts(Before, Parents)) {
     if (Parent == After || inSequence(Parent, After))
       return true;
   }
@@ -98,7 +98,7 @@ bool ExprSequence::potentiallyAfter(const Stmt *After,
 }
 
 const Stmt *ExprSequence::getSequenceSuccessor(const Stmt *S) const {
-  for (const Stmt *Parent : getParentStmts(S, Context)) {
+  for (const Stmt *Parent : getParentStmts(S, Parents)) {
     if (const auto *BO = dyn_cast<BinaryOperator>(Parent)) {
       // Comma operator: Right-hand side is sequenced after the left-hand side.
       if (BO->getLHS() == S && BO->getOpcode() == BO_Comma)
@@ -156,8 +156,8 @@ const Stmt *ExprSequence::resolveSyntheticStmt(const Stmt *S) const {
   return S;
 }
 
-StmtToBlockMap::StmtToBlockMap(const CFG *TheCFG, ASTContext *TheContext)
-    : Context(TheContext) {
+StmtToBlockMap::StmtToBlockMap(const CFG *TheCFG, ScopedParentMap &TheParents)
+    : Parents(&TheParents) {
   for (const auto *B : *TheCFG) {
     for (const auto &Elem : *B) {
       if (Optional<CFGStmt> S = Elem.getAs<CFGStmt>())
@@ -168,15 +168,39 @@ StmtToBlockMap::StmtToBlockMap(const CFG *TheCFG, ASTContext *TheContext)
 
 const CFGBlock *StmtToBlockMap::blockContainingStmt(const Stmt *S) const {
   while (!Map.count(S)) {
-    SmallVector<const Stmt *, 1> Parents = getParentStmts(S, Context);
-    if (Parents.empty())
+    SmallVector<const Stmt *, 1> ParentStmts = getParentStmts(S, Parents);
+    if (ParentStmts.empty())
       return nullptr;
-    S = Parents[0];
+    S = ParentStmts[0];
   }
 
   return Map.lookup(S);
 }
 
+FunctionCFG::FunctionCFG(std::unique_ptr<CFG> TheCFG, ScopedParentMap &Parents)
+    : TheCFG(std::move(TheCFG)), Sequence(this->TheCFG.get(), Parents),
+      BlockMap(this->TheCFG.get(), Parents) {}
+
+FunctionCFGCache::FunctionCFGCache(const CFG::BuildOptions &Options)
+    : Options(Options), Parents(nullptr) {}
+
+const FunctionCFG *FunctionCFGCache::get(Stmt *Body,
+                                         ScopedParentMap &TheParents) {
+  if (Parents != &TheParents) {
+    Functions.clear();
+    Parents = &TheParents;
+  }
+  auto Inserted = Functions.try_emplace(Body);
+  std::unique_ptr<FunctionCFG> &Function = Inserted.first->second;
+  // A body for which no CFG can be built is cached as nullptr as well.
+  if (Inserted.second) {
+    if (std::unique_ptr<CFG> TheCFG =
+            CFG::buildCFG(nullptr, Body, &Parents->getASTContext(), Options))
+      Function = llvm::make_unique<FunctionCFG>(std::move(TheCFG), *Parents);
+  }
+  return Function.get();
+}
+
 } // namespace utils
 } // namespace tidy
 } // namespace clang
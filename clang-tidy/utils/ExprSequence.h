@@ -69,8 +69,8 @@ namespace utils {
 class ExprSequence {
 public:
   /// Initializes this `ExprSequence` with sequence information for the given
-  /// `CFG`.
-  ExprSequence(const CFG *TheCFG, ASTContext *TheContext);
+  /// `CFG`, looking up parents of statements in \p TheParents.
+  ExprSequence(const CFG *TheCFG, ScopedParentMap &TheParents);
 
   /// Returns whether \p Before is sequenced before \p After.
   bool inSequence(const Stmt *Before, const Stmt *After) const;
@@ -93,7 +93,7 @@ private:
 
   const Stmt *resolveSyntheticStmt(const Stmt *S) const;
 
-  ASTContext *Context;
+  ScopedParentMap *Parents;
 
   llvm::DenseMap<const Stmt *, const Stmt *> SyntheticStmtSourceMap;
 };
@@ -104,7 +104,7 @@ private:
 class StmtToBlockMap {
 public:
   /// Initializes the map for the given `CFG`.
-  StmtToBlockMap(const CFG *TheCFG, ASTContext *TheContext);
+  StmtToBlockMap(const CFG *TheCFG, ScopedParentMap &TheParents);
 
   /// Returns the block that \p S is contained in. Some `Stmt`s may be contained
   /// in more than one `CFGBlock`; in this case, this function returns the
@@ -112,11 +112,43 @@ public:
   const CFGBlock *blockContainingStmt(const Stmt *S) const;
 
 private:
-  ASTContext *Context;
+  ScopedParentMap *Parents;
 
   llvm::DenseMap<const Stmt *, const CFGBlock *> Map;
 };
 
+/// The `CFG` of a function body, together with the `ExprSequence` and
+/// `StmtToBlockMap` built from it.
+struct FunctionCFG {
+  FunctionCFG(std::unique_ptr<CFG> TheCFG, ScopedParentMap &Parents);
+
+  std::unique_ptr<CFG> TheCFG;
+  ExprSequence Sequence;
+  StmtToBlockMap BlockMap;
+};
+
+/// Builds the `FunctionCFG` of each function body once and reuses it for all
+/// later queries about the same body, e.g. for every `std::move()` call in
+/// the function.
+///
+/// A check should keep a cache as a member; as checks are created per
+/// translation unit, so is the cache.
+class FunctionCFGCache {
+public:
+  /// Initializes the cache to build `CFG`s with the given \p Options.
+  explicit FunctionCFGCache(const CFG::BuildOptions &Options);
+
+  /// Returns the `FunctionCFG` of \p Body, building it on first use, or
+  /// nullptr if no `CFG` can be built for \p Body. \p TheParents is the
+  /// parent map of the translation unit containing \p Body.
+  const FunctionCFG *get(Stmt *Body, ScopedParentMap &TheParents);
+
+private:
+  CFG::BuildOptions Options;
+  ScopedParentMap *Parents;
+  llvm::DenseMap<const Stmt *, std::unique_ptr<FunctionCFG>> Functions;
+};
+
 } // namespace utils
 } // namespace tidy
 } // namespace clang
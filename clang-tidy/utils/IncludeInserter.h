@@ -10,12 +10,13 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_INCLUDEINSERTER_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_INCLUDEINSERTER_H
 
+#include "../IncludeDirectives.h"
 #include "IncludeSorter.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceManager.h"
-#include "clang/Lex/PPCallbacks.h"
 #include <memory>
+#include <set>
 #include <string>
 
 namespace clang {
@@ -25,16 +26,20 @@ namespace utils {
 /// \brief Produces fixes to insert specified includes to source files, if not
 /// yet present.
 ///
+/// The existing inclusion directives are taken from the ``IncludeDirectives``
+/// shared by all checks of a translation unit. Headers a file already
+/// includes are skipped without sorting its directives; they are sorted only
+/// for the files an include is inserted into.
+///
 /// ``IncludeInserter`` can be used by ``ClangTidyCheck`` in the following
 /// fashion:
 /// \code
 /// class MyCheck : public ClangTidyCheck {
 ///  public:
 ///   void registerPPCallbacks(CompilerInstance& Compiler) override {
-///     Inserter.reset(new IncludeInserter(&Compiler.getSourceManager(),
-///                                        &Compiler.getLangOpts()));
-///     Compiler.getPreprocessor().addPPCallbacks(
-///         Inserter->CreatePPCallback());
+///     Inserter.reset(new IncludeInserter(
+///         Compiler.getSourceManager(), Compiler.getLangOpts(), Style,
+///         getIncludeDirectives(Compiler.getPreprocessor())));
 ///   }
 ///
 ///   void registerMatchers(ast_matchers::MatchFinder* Finder) override { ... }
@@ -55,27 +60,22 @@ namespace utils {
 class IncludeInserter {
 public:
   IncludeInserter(const SourceManager &SourceMgr, const LangOptions &LangOpts,
-                  IncludeSorter::IncludeStyle Style);
+                  IncludeSorter::IncludeStyle Style,
+                  const IncludeDirectives &Includes);
   ~IncludeInserter();
 
-  /// Create ``PPCallbacks`` for registration with the compiler's preprocessor.
-  std::unique_ptr<PPCallbacks> CreatePPCallbacks();
-
   /// Creates a \p Header inclusion directive fixit. Returns ``llvm::None`` on
   /// error or if inclusion directive already exists.
   llvm::Optional<FixItHint>
   CreateIncludeInsertion(FileID FileID, llvm::StringRef Header, bool IsAngled);
 
 private:
-  void AddInclude(StringRef FileName, bool IsAngled,
-                  SourceLocation HashLocation, SourceLocation EndLocation);
-
   llvm::DenseMap<FileID, std::unique_ptr<IncludeSorter>> IncludeSorterByFile;
   llvm::DenseMap<FileID, std::set<std::string>> InsertedHeaders;
   const SourceManager &SourceMgr;
   const LangOptions &LangOpts;
   const IncludeSorter::IncludeStyle Style;
-  friend class IncludeInserterCallback;
+  const IncludeDirectives &Includes;
 };
 
 } // namespace utils
@@ -17,15 +17,7 @@ namespace options {
 static const char StringsDelimiter[] = ";";
 
 std::vector<std::string> parseStringList(StringRef Option) {
-  SmallVector<StringRef, 4> Names;
-  Option.split(Names, StringsDelimiter);
-  std::vector<std::string> Result;
-  for (StringRef &Name : Names) {
-    Name = Name.trim();
-    if (!Name.empty())
-      Result.push_back(Name);
-  }
-  return Result;
+  return parseCheckOptionList(Option);
 }
 
 std::string serializeStringList(ArrayRef<std::string> Strings) {
@@ -81,6 +81,11 @@
 //          a set of headers.  You can start with a full list of headers,
 //          use -display-file-lists option, and then use the combined list as
 //          your intermediate list, uncommenting-out headers as you fix them.
+//    -j=(number of threads)
+//          Check the headers using the given number of threads, or all
+//          available hardware threads if 0.  The default is 1.  Note that
+//          with more than one thread, the diagnostics emitted while
+//          compiling the headers may appear in a different order.
 //
 // Note that by default, the modularize assumes .h files contain C++ source.
 // If your .h files in the file list contain another language, you should
@@ -246,10 +251,13 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace clang;
@@ -330,6 +338,12 @@ DisplayFileLists("display-file-lists", cl::init(false),
 cl::desc("Display lists of good files (no compile errors), problem files,"
   " and a combined list with problem files preceded by a '#'."));
 
+// Option for the number of threads used for compiling the headers.
+static cl::opt<unsigned>
+NumThreads("j", cl::init(1),
+cl::desc("Number of threads to use for checking the headers."
+  " 0 uses all available hardware threads."));
+
 // Save the program name for error messages.
 const char *Argv0;
 // Save the command line for comments.
@@ -357,7 +371,9 @@ getModularizeArgumentsAdjuster(DependencyMap &Dependencies) {
   return [&Dependencies](const CommandLineArguments &Args,
                          StringRef /*unused*/) {
     std::string InputFile = findInputFile(Args);
-    DependentsVector &FileDependents = Dependencies[InputFile];
+    // Use a lookup that doesn't modify the map, as the adjuster can be called
+    // from several threads at once.
+    DependentsVector FileDependents = Dependencies.lookup(InputFile);
     CommandLineArguments NewArgs(Args);
     if (int Count = FileDependents.size()) {
       for (int Index = 0; Index < Count; ++Index) {
@@ -492,6 +508,49 @@ public:
     HeaderEntry HE = { Name, Loc };
     CurHeaderContents[Loc.File].push_back(HE);
 
+    addEntry(Name, Kind, Loc);
+  }
+
+  void mergeCurHeaderContents() {
+    for (DenseMap<const FileEntry *, HeaderContents>::iterator
+             H = CurHeaderContents.begin(),
+             HEnd = CurHeaderContents.end();
+         H != HEnd; ++H) {
+      // Sort contents.
+      std::sort(H->second.begin(), H->second.end());
+
+      mergeHeaderContents(H->first, H->second);
+    }
+
+    CurHeaderContents.clear();
+  }
+
+  // Merge the entities and header contents collected in Other into this map,
+  // as if the compilations that filled Other had been done after the ones
+  // that filled this map.  Each ClangTool run has its own FileManager, so
+  // the file entries in Other are first mapped to equivalent entries already
+  // known to this map, using the unique file ID.
+  void mergeFrom(const EntityMap &Other) {
+    for (const auto &E : Other) {
+      for (const Entry &OtherEntry : E.second)
+        addEntry(E.first(), OtherEntry.Kind,
+                 getCanonicalLocation(OtherEntry.Loc));
+    }
+
+    for (const auto &H : Other.AllHeaderContents)
+      mergeHeaderContents(getCanonicalFile(H.first),
+                          getCanonicalContents(H.second));
+
+    for (const auto &H : Other.HeaderContentMismatches) {
+      HeaderContents Contents = getCanonicalContents(H.second);
+      HeaderContents &Mismatches =
+          HeaderContentMismatches[getCanonicalFile(H.first)];
+      Mismatches.insert(Mismatches.end(), Contents.begin(), Contents.end());
+    }
+  }
+
+private:
+  void addEntry(StringRef Name, enum Entry::EntryKind Kind, Location Loc) {
     // Check whether we've seen this entry before.
     SmallVector<Entry, 2> &Entries = (*this)[Name];
     for (unsigned I = 0, N = Entries.size(); I != N; ++I) {
@@ -504,40 +563,55 @@ public:
     Entries.push_back(E);
   }
 
-  void mergeCurHeaderContents() {
-    for (DenseMap<const FileEntry *, HeaderContents>::iterator
-             H = CurHeaderContents.begin(),
-             HEnd = CurHeaderContents.end();
-         H != HEnd; ++H) {
-      // Sort contents.
-      std::sort(H->second.begin(), H->second.end());
+  // Merge the sorted contents of one header from a compilation.
+  void mergeHeaderContents(const FileEntry *File,
+                           const HeaderContents &Contents) {
+    // Check whether we've seen this header before.
+    DenseMap<const FileEntry *, HeaderContents>::iterator KnownH =
+        AllHeaderContents.find(File);
+    if (KnownH == AllHeaderContents.end()) {
+      // We haven't seen this header before; record its contents.
+      AllHeaderContents.insert(std::make_pair(File, Contents));
+      return;
+    }
 
-      // Check whether we've seen this header before.
-      DenseMap<const FileEntry *, HeaderContents>::iterator KnownH =
-          AllHeaderContents.find(H->first);
-      if (KnownH == AllHeaderContents.end()) {
-        // We haven't seen this header before; record its contents.
-        AllHeaderContents.insert(*H);
-        continue;
-      }
+    // If the header contents are the same, we're done.
+    if (Contents == KnownH->second)
+      return;
 
-      // If the header contents are the same, we're done.
-      if (H->second == KnownH->second)
-        continue;
+    // Determine what changed.
+    std::set_symmetric_difference(
+        Contents.begin(), Contents.end(), KnownH->second.begin(),
+        KnownH->second.end(),
+        std::back_inserter(HeaderContentMismatches[File]));
+  }
 
-      // Determine what changed.
-      std::set_symmetric_difference(
-          H->second.begin(), H->second.end(), KnownH->second.begin(),
-          KnownH->second.end(),
-          std::back_inserter(HeaderContentMismatches[H->first]));
-    }
+  // Get the file entry used by this map for the file of the given entry.
+  const FileEntry *getCanonicalFile(const FileEntry *File) {
+    if (!File)
+      return File;
+    return CanonicalFiles.insert(std::make_pair(File->getUniqueID(), File))
+        .first->second;
+  }
 
-    CurHeaderContents.clear();
+  Location getCanonicalLocation(Location Loc) {
+    Loc.File = getCanonicalFile(Loc.File);
+    return Loc;
+  }
+
+  // Map the locations of header contents, and restore the sort order, which
+  // depends on the file entry addresses.
+  HeaderContents getCanonicalContents(const HeaderContents &Contents) {
+    HeaderContents Result(Contents);
+    for (HeaderEntry &HE : Result)
+      HE.Loc = getCanonicalLocation(HE.Loc);
+    std::sort(Result.begin(), Result.end());
+    return Result;
   }
 
-private:
   DenseMap<const FileEntry *, HeaderContents> CurHeaderContents;
   DenseMap<const FileEntry *, HeaderContents> AllHeaderContents;
+  std::map<llvm::sys::fs::UniqueID, const FileEntry *> CanonicalFiles;
 };
 
 class CollectEntitiesVisitor
@@ -807,6 +881,24 @@ public:
   }
 };
 
+// The results of checking one group of headers in a separate tool run.
+// Groups of headers are checked in parallel, and their results merged
+// afterwards.
+struct HeaderGroupResult {
+  EntityMap Entities;
+  std::unique_ptr<PreprocessorTracker> PPTracker;
+  // Keeps the file entries referenced by the entities alive.
+  IntrusiveRefCntPtr<FileManager> Files;
+  int HadErrors = 0;
+};
+
+// Get the number of threads to use.
+static unsigned getNumThreads() {
+  if (NumThreads != 0)
+    return NumThreads;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
 int main(int Argc, const char **Argv) {
 
   // Save program name for error messages.
@@ -874,22 +966,36 @@ int main(int Argc, const char **Argv) {
   // Coolect entities here.
   EntityMap Entities;
 
+  unsigned ThreadCount = getNumThreads();
+
   // Because we can't easily determine which files failed
   // during the tool run, if we're collecting the file lists
   // for display, we do a first compile pass on individual
   // files to find which ones don't compile stand-alone.
   if (DisplayFileLists) {
     // First, make a pass to just get compile errors.
-    for (auto &CompileCheckFile : ModUtil->HeaderFileNames) {
-      llvm::SmallVector<std::string, 32> CompileCheckFileArray;
-      CompileCheckFileArray.push_back(CompileCheckFile);
-      ClangTool CompileCheckTool(*Compilations, CompileCheckFileArray);
-      CompileCheckTool.appendArgumentsAdjuster(
-        getModularizeArgumentsAdjuster(ModUtil->Dependencies));
-      int CompileCheckFileErrors = 0;
-      CompileCheckFrontendActionFactory CompileCheckFactory;
-      CompileCheckFileErrors |= CompileCheckTool.run(&CompileCheckFactory);
-      if (CompileCheckFileErrors != 0) {
+    std::vector<char> CompileCheckFailed(ModUtil->HeaderFileNames.size(),
+                                         false);
+    {
+      ThreadPool Pool(ThreadCount);
+      for (size_t Index = 0, Count = ModUtil->HeaderFileNames.size();
+           Index < Count; ++Index) {
+        Pool.async([&, Index]() {
+          ClangTool CompileCheckTool(*Compilations,
+                                     ModUtil->HeaderFileNames[Index]);
+          CompileCheckTool.appendArgumentsAdjuster(
+            getModularizeArgumentsAdjuster(ModUtil->Dependencies));
+          CompileCheckFrontendActionFactory CompileCheckFactory;
+          CompileCheckFailed[Index] =
+              CompileCheckTool.run(&CompileCheckFactory) != 0;
+        });
+      }
+    }
+    // Record the results in header list order.
+    for (size_t Index = 0, Count = ModUtil->HeaderFileNames.size();
+         Index < Count; ++Index) {
+      const std::string &CompileCheckFile = ModUtil->HeaderFileNames[Index];
+      if (CompileCheckFailed[Index]) {
         ModUtil->addUniqueProblemFile(CompileCheckFile);   // Save problem file.
         HadErrors |= 1;
       }
@@ -899,12 +1005,42 @@ int main(int Argc, const char **Argv) {
   }
 
   // Then we make another pass on the good files to do the rest of the work.
-  ClangTool Tool(*Compilations,
-    (DisplayFileLists ? ModUtil->GoodFileNames : ModUtil->HeaderFileNames));
-  Tool.appendArgumentsAdjuster(
-    getModularizeArgumentsAdjuster(ModUtil->Dependencies));
-  ModularizeFrontendActionFactory Factory(Entities, *PPTracker, HadErrors);
-  HadErrors |= Tool.run(&Factory);
+  // The files are split into contiguous groups, each checked by its own tool
+  // with its own entity map and preprocessor tracker.  The groups are merged
+  // in order, so the results don't depend on thread scheduling.
+  ArrayRef<std::string> CheckFiles(DisplayFileLists ? ModUtil->GoodFileNames
+                                                    : ModUtil->HeaderFileNames);
+  // Use a few groups per thread, to balance the load.
+  size_t GroupCount = std::min<size_t>(
+      CheckFiles.size(), ThreadCount == 1 ? 1 : ThreadCount * 4);
+  size_t GroupSize =
+      GroupCount ? (CheckFiles.size() + GroupCount - 1) / GroupCount : 0;
+  std::vector<HeaderGroupResult> Groups(GroupCount);
+  {
+    ThreadPool Pool(ThreadCount);
+    for (size_t GroupIndex = 0; GroupIndex < GroupCount; ++GroupIndex) {
+      Pool.async([&, GroupIndex]() {
+        HeaderGroupResult &Group = Groups[GroupIndex];
+        size_t Begin = std::min(GroupIndex * GroupSize, CheckFiles.size());
+        size_t End = std::min(Begin + GroupSize, CheckFiles.size());
+        Group.PPTracker.reset(PreprocessorTracker::create(
+            ModUtil->HeaderFileNames, BlockCheckHeaderListOnly));
+        ClangTool Tool(*Compilations, CheckFiles.slice(Begin, End - Begin));
+        Tool.appendArgumentsAdjuster(
+          getModularizeArgumentsAdjuster(ModUtil->Dependencies));
+        Group.Files = &Tool.getFiles();
+        ModularizeFrontendActionFactory Factory(Group.Entities,
+                                                *Group.PPTracker,
+                                                Group.HadErrors);
+        Group.HadErrors |= Tool.run(&Factory);
+      });
+    }
+  }
+  for (HeaderGroupResult &Group : Groups) {
+    Entities.mergeFrom(Group.Entities);
+    PPTracker->mergeFrom(*Group.PPTracker);
+    HadErrors |= Group.HadErrors;
+  }
 
   // Create a place to save duplicate entity locations, separate bins per kind.
   typedef SmallVector<Location, 8> LocationArray;
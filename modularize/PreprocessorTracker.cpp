@@ -113,7 +113,9 @@
 // To reduce the instances of string and object copying, the
 // PreprocessorTrackerImpl class uses a StringPool to save all stored
 // strings, and defines a StringHandle type to abstract the references
-// to the strings.
+// to the strings. Since equal strings share one pool entry, string handles
+// are compared and hashed by identity, and the trackers are stored in hash
+// maps. They are only sorted by their string values when reported.
 //
 // PreprocessorTrackerImpl also maintains a list representing the unique
 // headers, which is just a vector of StringHandle's for the header file
@@ -176,12 +178,15 @@
 // and the macro definition location. If a matching MacroExpansionInstance
 // object is found, it just adds the current HeaderInclusionPath object to
 // it. If not found, it creates and stores a new MacroExpantionInstance
-// object. The addMacroExpansionInstance function calls a couple of helper
-// functions to get the pre-formatted location and source line strings for
-// the macro reference and the macro definition stored as string handles.
-// These helper functions use the current source manager from the
-// preprocessor. This is done in advance at this point in time because the
-// source manager doesn't exist at the time of the reporting.
+// object. The addMacroExpansionInstance function records light-weight
+// SourceLineRef objects for the macro reference and the macro definition,
+// storing the presumed file name, line, and column, and the path of and
+// offset in the file containing the location. Since the source manager
+// doesn't exist at the time of the reporting, the location and source line
+// strings are only built from these when an error is actually reported,
+// reading the source line back from the file. This avoids formatting and
+// storing strings for the vast majority of macro expansions, which never
+// conflict.
 //
 // For conditional check, the PreprocessorCallbacks class overrides the
 // PPCallbacks handlers for #if, #elif, #ifdef, and #ifndef.  These handlers
@@ -248,10 +253,17 @@
 #include "PreprocessorTracker.h"
 #include "clang/Lex/MacroArgs.h"
 #include "clang/Lex/PPCallbacks.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/StringPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include "ModularizeUtilities.h"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
 
 namespace Modularize {
 
@@ -310,14 +322,12 @@ static std::string getSourceString(clang::Preprocessor &PP,
   return llvm::StringRef(BeginPtr, Length).trim().str();
 }
 
-// Retrieve source line from file image given a location.
-static std::string getSourceLine(clang::Preprocessor &PP,
-                                 clang::SourceLocation Loc) {
-  const llvm::MemoryBuffer *MemBuffer =
-      PP.getSourceManager().getBuffer(PP.getSourceManager().getFileID(Loc));
+// Retrieve the source line containing the given offset from a file image.
+static std::string getSourceLine(const llvm::MemoryBuffer *MemBuffer,
+                                 unsigned Offset) {
   const char *Buffer = MemBuffer->getBufferStart();
   const char *BufferEnd = MemBuffer->getBufferEnd();
-  const char *BeginPtr = PP.getSourceManager().getCharacterData(Loc);
+  const char *BeginPtr = Buffer + std::min<size_t>(Offset, BufferEnd - Buffer);
   const char *EndPtr = BeginPtr;
   while (BeginPtr > Buffer) {
     if (*BeginPtr == '\n') {
@@ -336,6 +346,15 @@ static std::string getSourceLine(clang::Preprocessor &PP,
   return llvm::StringRef(BeginPtr, Length).str();
 }
 
+// Retrieve source line from file image given a location.
+static std::string getSourceLine(clang::Preprocessor &PP,
+                                 clang::SourceLocation Loc) {
+  std::pair<clang::FileID, unsigned> Decomposed =
+      PP.getSourceManager().getDecomposedSpellingLoc(Loc);
+  return getSourceLine(PP.getSourceManager().getBuffer(Decomposed.first),
+                       Decomposed.second);
+}
+
 // Retrieve source line from file image given a file ID and line number.
 static std::string getSourceLine(clang::Preprocessor &PP, clang::FileID FileID,
                                  int Line) {
@@ -528,6 +547,41 @@ public:
   int Column;
 };
 
+// Hash function for preprocessor item keys.
+// The names are pooled strings, so they are hashed by identity.
+struct PPItemKeyHash {
+  size_t operator()(const PPItemKey &Key) const {
+    const char *Name = Key.Name ? *Key.Name : nullptr;
+    return llvm::hash_combine(Name, Key.File, Key.Line, Key.Column);
+  }
+};
+
+// Source line reference.
+//
+// This class represents a source location for which a "file:line:column:"
+// string and the source line text will be output if an error is reported
+// for it.  Rather than building these strings up front, it stores the
+// presumed file name, line and column, and the path of the file and the
+// offset in it, from which the source line is read back at reporting time.
+// Locations that are not in a file, such as in the predefines buffer, are
+// formatted up front and stored in Text.
+class SourceLineRef {
+public:
+  SourceLineRef() : Line(0), Column(0), Offset(0) {}
+
+  // The presumed file name.
+  StringHandle FileName;
+  // The presumed line and column.
+  int Line;
+  int Column;
+  // The path of the file containing the location.
+  StringHandle FilePath;
+  // The offset of the location in the file.
+  unsigned Offset;
+  // The formatted location and source line, for locations not in a file.
+  StringHandle Text;
+};
+
 // Header inclusion path.
 class HeaderInclusionPath {
 public:
@@ -547,7 +601,7 @@ class MacroExpansionInstance {
 public:
   MacroExpansionInstance(StringHandle MacroExpanded,
                          PPItemKey &DefinitionLocation,
-                         StringHandle DefinitionSourceLine,
+                         const SourceLineRef &DefinitionSourceLine,
                          InclusionPathHandle H)
       : MacroExpanded(MacroExpanded), DefinitionLocation(DefinitionLocation),
         DefinitionSourceLine(DefinitionSourceLine) {
@@ -575,8 +629,8 @@ public:
   StringHandle MacroExpanded;
   // A file/line/column triplet representing the macro definition location.
   PPItemKey DefinitionLocation;
-  // A place to save the macro definition line string.
-  StringHandle DefinitionSourceLine;
+  // The macro definition location and line.
+  SourceLineRef DefinitionSourceLine;
   // The header inclusion path handles for all the instances.
   std::vector<InclusionPathHandle> InclusionPathHandles;
 };
@@ -591,9 +645,9 @@ class MacroExpansionTracker {
 public:
   MacroExpansionTracker(StringHandle MacroUnexpanded,
                         StringHandle MacroExpanded,
-                        StringHandle InstanceSourceLine,
+                        const SourceLineRef &InstanceSourceLine,
                         PPItemKey &DefinitionLocation,
-                        StringHandle DefinitionSourceLine,
+                        const SourceLineRef &DefinitionSourceLine,
                         InclusionPathHandle InclusionPathHandle)
       : MacroUnexpanded(MacroUnexpanded),
         InstanceSourceLine(InstanceSourceLine) {
@@ -620,7 +674,7 @@ public:
   // Add a macro expansion instance.
   void addMacroExpansionInstance(StringHandle MacroExpanded,
                                  PPItemKey &DefinitionLocation,
-                                 StringHandle DefinitionSourceLine,
+                                 const SourceLineRef &DefinitionSourceLine,
                                  InclusionPathHandle InclusionPathHandle) {
     MacroExpansionInstances.push_back(
         MacroExpansionInstance(MacroExpanded, DefinitionLocation,
@@ -632,8 +686,8 @@ public:
 
   // A string representing the macro instance without expansion.
   StringHandle MacroUnexpanded;
-  // A place to save the macro instance source line string.
-  StringHandle InstanceSourceLine;
+  // The macro instance location and line.
+  SourceLineRef InstanceSourceLine;
   // The macro expansion instances.
   // If all instances of the macro expansion expand to the same value,
   // This vector will only have one instance.
@@ -778,14 +832,31 @@ private:
 };
 
 // Preprocessor macro expansion item map types.
-typedef std::map<PPItemKey, MacroExpansionTracker> MacroExpansionMap;
-typedef std::map<PPItemKey, MacroExpansionTracker>::iterator
-MacroExpansionMapIter;
+typedef std::unordered_map<PPItemKey, MacroExpansionTracker, PPItemKeyHash>
+MacroExpansionMap;
+typedef MacroExpansionMap::iterator MacroExpansionMapIter;
 
 // Preprocessor conditional expansion item map types.
-typedef std::map<PPItemKey, ConditionalTracker> ConditionalExpansionMap;
-typedef std::map<PPItemKey, ConditionalTracker>::iterator
-ConditionalExpansionMapIter;
+typedef std::unordered_map<PPItemKey, ConditionalTracker, PPItemKeyHash>
+ConditionalExpansionMap;
+typedef ConditionalExpansionMap::iterator ConditionalExpansionMapIter;
+
+// Return the map items with mismatches, sorted by key, for reporting.
+template <typename MapType>
+static std::vector<typename MapType::value_type *>
+getSortedMismatches(MapType &Map) {
+  std::vector<typename MapType::value_type *> Mismatches;
+  for (auto &Item : Map) {
+    if (Item.second.hasMismatch())
+      Mismatches.push_back(&Item);
+  }
+  std::sort(Mismatches.begin(), Mismatches.end(),
+            [](const typename MapType::value_type *A,
+               const typename MapType::value_type *B) {
+              return A->first < B->first;
+            });
+  return Mismatches;
+}
 
 // Preprocessor tracker for modularize.
 //
@@ -802,7 +873,7 @@ public:
     for (llvm::ArrayRef<std::string>::iterator I = Headers.begin(),
       E = Headers.end();
       I != E; ++I) {
-      HeaderList.push_back(getCanonicalPath(*I));
+      HeaderList.insert(getCanonicalPath(*I));
     }
   }
 
@@ -933,27 +1004,16 @@ public:
 
   // Return true if the given header is in the header list.
   bool isHeaderListHeader(llvm::StringRef HeaderPath) const {
-    std::string CanonicalPath = getCanonicalPath(HeaderPath);
-    for (llvm::ArrayRef<std::string>::iterator I = HeaderList.begin(),
-        E = HeaderList.end();
-        I != E; ++I) {
-      if (*I == CanonicalPath)
-        return true;
-    }
-    return false;
+    return HeaderList.count(getCanonicalPath(HeaderPath)) != 0;
   }
 
   // Get the handle of a header file entry.
   // Return HeaderHandleInvalid if not found.
   HeaderHandle findHeaderHandle(llvm::StringRef HeaderPath) const {
-    std::string CanonicalPath = getCanonicalPath(HeaderPath);
-    HeaderHandle H = 0;
-    for (auto I = HeaderPaths.begin(), E = HeaderPaths.end(); I != E;
-         ++I, ++H) {
-      if (**I == CanonicalPath)
-        return H;
-    }
-    return HeaderHandleInvalid;
+    auto I = HeaderHandles.find(getCanonicalPath(HeaderPath));
+    if (I == HeaderHandles.end())
+      return HeaderHandleInvalid;
+    return I->second;
   }
 
   // Add a new header file entry, or return existing handle.
@@ -964,6 +1024,7 @@ public:
     if (H == HeaderHandleInvalid) {
       H = HeaderPaths.size();
       HeaderPaths.push_back(addString(CanonicalPath));
+      HeaderHandles[CanonicalPath] = H;
     }
     return H;
   }
@@ -1008,13 +1069,10 @@ public:
   // Return InclusionPathHandleInvalid if not found.
   InclusionPathHandle
   findInclusionPathHandle(const std::vector<HeaderHandle> &Path) const {
-    InclusionPathHandle H = 0;
-    for (auto I = InclusionPaths.begin(), E = InclusionPaths.end(); I != E;
-         ++I, ++H) {
-      if (I->Path == Path)
-        return H;
-    }
-    return HeaderHandleInvalid;
+    auto I = InclusionPathHandles.find(Path);
+    if (I == InclusionPathHandles.end())
+      return HeaderHandleInvalid;
+    return I->second;
   }
   // Add a new header inclusion path entry, or return existing handle.
   // Return the header inclusion path entry handle.
@@ -1024,6 +1082,7 @@ public:
     if (H == HeaderHandleInvalid) {
       H = InclusionPaths.size();
       InclusionPaths.push_back(HeaderInclusionPath(Path));
+      InclusionPathHandles[Path] = H;
     }
     return H;
   }
@@ -1041,6 +1100,56 @@ public:
     return Empty;
   }
 
+  // Get a reference to a source location and line, for reporting.
+  SourceLineRef getSourceLineRef(clang::Preprocessor &PP,
+                                 clang::SourceLocation Loc) {
+    SourceLineRef Ref;
+    if (Loc.isInvalid()) {
+      Ref.Text = addString(getSourceLocationString(PP, Loc) + ":\n\n");
+      return Ref;
+    }
+    const clang::SourceManager &SM = PP.getSourceManager();
+    const clang::FileEntry *File = nullptr;
+    clang::PresumedLoc PLoc;
+    if (Loc.isFileID()) {
+      File = SM.getFileEntryForID(SM.getFileID(Loc));
+      PLoc = SM.getPresumedLoc(Loc);
+    }
+    if (!File || PLoc.isInvalid()) {
+      // Not in a file we can read back later, so format it now.
+      Ref.Text = addString(getSourceLocationString(PP, Loc) + ":\n" +
+                           getSourceLine(PP, Loc) + "\n");
+      return Ref;
+    }
+    Ref.FileName = addString(PLoc.getFilename());
+    Ref.Line = PLoc.getLine();
+    Ref.Column = PLoc.getColumn();
+    Ref.FilePath = addString(File->getName());
+    Ref.Offset = SM.getFileOffset(Loc);
+    return Ref;
+  }
+
+  // Get the formatted "file:line:column:" string and source line for a
+  // source line reference.
+  std::string getSourceLineText(const SourceLineRef &Ref) {
+    if (Ref.Text)
+      return *Ref.Text;
+    std::string Text;
+    llvm::raw_string_ostream OS(Text);
+    OS << *Ref.FileName << ":" << Ref.Line << ":" << Ref.Column << ":\n";
+    std::unique_ptr<llvm::MemoryBuffer> &Buffer = FileBuffers[*Ref.FilePath];
+    if (!Buffer) {
+      llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+          llvm::MemoryBuffer::getFile(*Ref.FilePath);
+      if (BufferOrErr)
+        Buffer = std::move(*BufferOrErr);
+    }
+    if (Buffer)
+      OS << getSourceLine(Buffer.get(), Ref.Offset);
+    OS << "\n";
+    return OS.str();
+  }
+
   // Add a macro expansion instance.
   void addMacroExpansionInstance(clang::Preprocessor &PP, HeaderHandle H,
                                  clang::SourceLocation InstanceLoc,
@@ -1057,16 +1166,10 @@ public:
     auto I = MacroExpansions.find(InstanceKey);
     // If existing instance of expansion not found, add one.
     if (I == MacroExpansions.end()) {
-      std::string InstanceSourceLine =
-          getSourceLocationString(PP, InstanceLoc) + ":\n" +
-          getSourceLine(PP, InstanceLoc) + "\n";
-      std::string DefinitionSourceLine =
-          getSourceLocationString(PP, DefinitionLoc) + ":\n" +
-          getSourceLine(PP, DefinitionLoc) + "\n";
       MacroExpansions[InstanceKey] = MacroExpansionTracker(
           addString(MacroUnexpanded), addString(MacroExpanded),
-          addString(InstanceSourceLine), DefinitionKey,
-          addString(DefinitionSourceLine), InclusionPathHandle);
+          getSourceLineRef(PP, InstanceLoc), DefinitionKey,
+          getSourceLineRef(PP, DefinitionLoc), InclusionPathHandle);
     } else {
       // We've seen the macro before.  Get its tracker.
       MacroExpansionTracker &CondTracker = I->second;
@@ -1079,12 +1182,9 @@ public:
         MacroInfo->addInclusionPathHandle(InclusionPathHandle);
       else {
         // Otherwise add a new instance with the unique value.
-        std::string DefinitionSourceLine =
-            getSourceLocationString(PP, DefinitionLoc) + ":\n" +
-            getSourceLine(PP, DefinitionLoc) + "\n";
         CondTracker.addMacroExpansionInstance(
             addString(MacroExpanded), DefinitionKey,
-            addString(DefinitionSourceLine), InclusionPathHandle);
+            getSourceLineRef(PP, DefinitionLoc), InclusionPathHandle);
       }
     }
   }
@@ -1105,9 +1205,6 @@ public:
     auto I = ConditionalExpansions.find(InstanceKey);
     // If existing instance of condition not found, add one.
     if (I == ConditionalExpansions.end()) {
-      std::string InstanceSourceLine =
-          getSourceLocationString(PP, InstanceLoc) + ":\n" +
-          getSourceLine(PP, InstanceLoc) + "\n";
       ConditionalExpansions[InstanceKey] =
           ConditionalTracker(DirectiveKind, ConditionValue,
                              ConditionUnexpandedHandle, InclusionPathHandle);
@@ -1128,22 +1225,146 @@ public:
     }
   }
 
+  // Merge the information collected by another tracker.
+  // The other tracker's string, header and inclusion path handles are only
+  // valid for that tracker, so they are mapped to handles of this tracker.
+  void mergeFrom(const PreprocessorTracker &OtherPPTracker) override {
+    const auto &Other =
+        static_cast<const PreprocessorTrackerImpl &>(OtherPPTracker);
+    // Map header handles.
+    std::vector<HeaderHandle> HeaderMap;
+    for (const StringHandle &Path : Other.HeaderPaths)
+      HeaderMap.push_back(addHeader(*Path));
+    auto MapHeader = [&](HeaderHandle H) {
+      if ((H < 0) || (H >= (HeaderHandle)HeaderMap.size()))
+        return HeaderHandleInvalid;
+      return HeaderMap[H];
+    };
+    // Map inclusion path handles.
+    std::vector<InclusionPathHandle> InclusionPathMap;
+    for (const HeaderInclusionPath &OtherPath : Other.InclusionPaths) {
+      std::vector<HeaderHandle> Path;
+      for (HeaderHandle H : OtherPath.Path)
+        Path.push_back(MapHeader(H));
+      InclusionPathMap.push_back(addInclusionPathHandle(Path));
+    }
+    auto MapInclusionPath = [&](InclusionPathHandle H) {
+      if ((H < 0) || (H >= (InclusionPathHandle)InclusionPathMap.size()))
+        return InclusionPathHandleInvalid;
+      return InclusionPathMap[H];
+    };
+    auto MapString = [&](const StringHandle &S) {
+      return S ? addString(*S) : StringHandle();
+    };
+    auto MapSourceLineRef = [&](const SourceLineRef &Ref) {
+      SourceLineRef Result(Ref);
+      Result.FileName = MapString(Ref.FileName);
+      Result.FilePath = MapString(Ref.FilePath);
+      Result.Text = MapString(Ref.Text);
+      return Result;
+    };
+    auto MapKey = [&](const PPItemKey &Key) {
+      return PPItemKey(MapString(Key.Name), MapHeader(Key.File), Key.Line,
+                       Key.Column);
+    };
+
+    // Merge include directives.
+    for (const PPItemKey &OtherDirective : Other.IncludeDirectives) {
+      PPItemKey Directive = MapKey(OtherDirective);
+      bool Found = false;
+      for (const PPItemKey &Existing : IncludeDirectives) {
+        if ((Existing.File == Directive.File) &&
+            (Existing.Line == Directive.Line)) {
+          Found = true;
+          break;
+        }
+      }
+      if (!Found)
+        IncludeDirectives.push_back(Directive);
+    }
+
+    // Merge macro expansions.
+    for (const auto &OtherItem : Other.MacroExpansions) {
+      const MacroExpansionTracker &OtherTracker = OtherItem.second;
+      PPItemKey InstanceKey = MapKey(OtherItem.first);
+      auto I = MacroExpansions.find(InstanceKey);
+      if (I == MacroExpansions.end()) {
+        MacroExpansionTracker Tracker;
+        Tracker.MacroUnexpanded = MapString(OtherTracker.MacroUnexpanded);
+        Tracker.InstanceSourceLine =
+            MapSourceLineRef(OtherTracker.InstanceSourceLine);
+        I = MacroExpansions.insert(std::make_pair(InstanceKey, Tracker)).first;
+      }
+      MacroExpansionTracker &Tracker = I->second;
+      for (const MacroExpansionInstance &OtherInstance :
+           OtherTracker.MacroExpansionInstances) {
+        StringHandle MacroExpanded = MapString(OtherInstance.MacroExpanded);
+        PPItemKey DefinitionKey = MapKey(OtherInstance.DefinitionLocation);
+        MacroExpansionInstance *Instance =
+            Tracker.findMacroExpansionInstance(MacroExpanded, DefinitionKey);
+        if (!Instance) {
+          Tracker.MacroExpansionInstances.push_back(MacroExpansionInstance());
+          Instance = &Tracker.MacroExpansionInstances.back();
+          Instance->MacroExpanded = MacroExpanded;
+          Instance->DefinitionLocation = DefinitionKey;
+          Instance->DefinitionSourceLine =
+              MapSourceLineRef(OtherInstance.DefinitionSourceLine);
+          for (InclusionPathHandle H : OtherInstance.InclusionPathHandles)
+            Instance->InclusionPathHandles.push_back(MapInclusionPath(H));
+          continue;
+        }
+        for (InclusionPathHandle H : OtherInstance.InclusionPathHandles)
+          Instance->addInclusionPathHandle(MapInclusionPath(H));
+      }
+    }
+
+    // Merge conditional expansions.
+    for (const auto &OtherItem : Other.ConditionalExpansions) {
+      const ConditionalTracker &OtherTracker = OtherItem.second;
+      PPItemKey InstanceKey = MapKey(OtherItem.first);
+      auto I = ConditionalExpansions.find(InstanceKey);
+      if (I == ConditionalExpansions.end()) {
+        ConditionalTracker Tracker;
+        Tracker.DirectiveKind = OtherTracker.DirectiveKind;
+        Tracker.ConditionUnexpanded =
+            MapString(OtherTracker.ConditionUnexpanded);
+        I = ConditionalExpansions.insert(std::make_pair(InstanceKey, Tracker))
+                .first;
+      }
+      ConditionalTracker &Tracker = I->second;
+      for (const ConditionalExpansionInstance &OtherInstance :
+           OtherTracker.ConditionalExpansionInstances) {
+        ConditionalExpansionInstance *Instance =
+            Tracker.findConditionalExpansionInstance(
+                OtherInstance.ConditionValue);
+        if (!Instance) {
+          Tracker.ConditionalExpansionInstances.push_back(
+              ConditionalExpansionInstance());
+          Instance = &Tracker.ConditionalExpansionInstances.back();
+          Instance->ConditionValue = OtherInstance.ConditionValue;
+          for (InclusionPathHandle H : OtherInstance.InclusionPathHandles)
+            Instance->InclusionPathHandles.push_back(MapInclusionPath(H));
+          continue;
+        }
+        for (InclusionPathHandle H : OtherInstance.InclusionPathHandles)
+          Instance->addInclusionPathHandle(MapInclusionPath(H));
+      }
+    }
+  }
+
   // Report on inconsistent macro instances.
   // Returns true if any mismatches.
   bool reportInconsistentMacros(llvm::raw_ostream &OS) override {
     bool ReturnValue = false;
-    // Walk all the macro expansion trackers in the map.
-    for (auto I = MacroExpansions.begin(), E = MacroExpansions.end(); I != E;
-         ++I) {
+    // Walk the macro expansion trackers with mismatches (more than one
+    // instance value).
+    for (auto *I : getSortedMismatches(MacroExpansions)) {
       const PPItemKey &ItemKey = I->first;
       MacroExpansionTracker &MacroExpTracker = I->second;
-      // If no mismatch (only one instance value) continue.
-      if (!MacroExpTracker.hasMismatch())
-        continue;
       // Tell caller we found one or more errors.
       ReturnValue = true;
       // Start the error message.
-      OS << *MacroExpTracker.InstanceSourceLine;
+      OS << getSourceLineText(MacroExpTracker.InstanceSourceLine);
       if (ItemKey.Column > 0)
         OS << std::string(ItemKey.Column - 1, ' ') << "^\n";
       OS << "error: Macro instance '" << *MacroExpTracker.MacroUnexpanded
@@ -1173,7 +1394,7 @@ public:
         // instance location.
         // If there is a definition...
         if (MacroInfo.DefinitionLocation.Line != ItemKey.Line) {
-          OS << *MacroInfo.DefinitionSourceLine;
+          OS << getSourceLineText(MacroInfo.DefinitionSourceLine);
           if (MacroInfo.DefinitionLocation.Column > 0)
             OS << std::string(MacroInfo.DefinitionLocation.Column - 1, ' ')
                << "^\n";
@@ -1190,14 +1411,10 @@ public:
   // Returns true if any mismatches.
   bool reportInconsistentConditionals(llvm::raw_ostream &OS) override {
     bool ReturnValue = false;
-    // Walk all the conditional trackers in the map.
-    for (auto I = ConditionalExpansions.begin(),
-              E = ConditionalExpansions.end();
-         I != E; ++I) {
+    // Walk the conditional trackers with mismatches.
+    for (auto *I : getSortedMismatches(ConditionalExpansions)) {
       const PPItemKey &ItemKey = I->first;
       ConditionalTracker &CondTracker = I->second;
-      if (!CondTracker.hasMismatch())
-        continue;
       // Tell caller we found one or more errors.
       ReturnValue = true;
       // Start the error message.
@@ -1252,13 +1469,17 @@ public:
   }
 
 private:
-  llvm::SmallVector<std::string, 32> HeaderList;
+  llvm::StringSet<> HeaderList;
   // Only do extern, namespace check for headers in HeaderList.
   bool BlockCheckHeaderListOnly;
   llvm::StringPool Strings;
   std::vector<StringHandle> HeaderPaths;
+  llvm::StringMap<HeaderHandle> HeaderHandles;
   std::vector<HeaderHandle> HeaderStack;
   std::vector<HeaderInclusionPath> InclusionPaths;
+  std::map<std::vector<HeaderHandle>, InclusionPathHandle> InclusionPathHandles;
+  // File images read back for reporting source lines.
+  llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> FileBuffers;
   InclusionPathHandle CurrentInclusionPathHandle;
   llvm::SmallSet<HeaderHandle, 32> HeadersInThisCompile;
   std::vector<PPItemKey> IncludeDirectives;
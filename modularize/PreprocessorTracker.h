@@ -68,6 +68,13 @@ public:
                                        const char *BlockIdentifierMessage,
                                        llvm::raw_ostream &OS) = 0;
 
+  // Merge the information collected by another tracker into this one, as if
+  // the preprocessing sessions seen by the other tracker had been seen by
+  // this one after its own.  This allows using one tracker per thread when
+  // running compilations in parallel.  Both trackers must have been created
+  // with the same header list.
+  virtual void mergeFrom(const PreprocessorTracker &Other) = 0;
+
   // Report on inconsistent macro instances.
   // Returns true if any mismatches.
   virtual bool reportInconsistentMacros(llvm::raw_ostream &OS) = 0;
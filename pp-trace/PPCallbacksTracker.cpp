@@ -89,10 +89,12 @@ static const char *const MappingStrings[] = { "0",          "MAP_IGNORE",
 
 // PPCallbacksTracker functions.
 
-PPCallbacksTracker::PPCallbacksTracker(llvm::SmallSet<std::string, 4> &Ignore,
-                                       std::vector<CallbackCall> &CallbackCalls,
+CallbackTraceWriter::~CallbackTraceWriter() {}
+
+PPCallbacksTracker::PPCallbacksTracker(const llvm::StringSet<> &Ignore,
+                                       CallbackTraceWriter &Writer,
                                        clang::Preprocessor &PP)
-    : CallbackCalls(CallbackCalls), Ignore(Ignore), PP(PP) {}
+    : Writer(Writer), Ignore(Ignore), PP(PP) {}
 
 PPCallbacksTracker::~PPCallbacksTracker() {}
 
@@ -102,7 +104,8 @@ PPCallbacksTracker::~PPCallbacksTracker() {}
 void PPCallbacksTracker::FileChanged(
     clang::SourceLocation Loc, clang::PPCallbacks::FileChangeReason Reason,
     clang::SrcMgr::CharacteristicKind FileType, clang::FileID PrevFID) {
-  beginCallback("FileChanged");
+  if (!beginCallback("FileChanged"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Reason", Reason, FileChangeReasonStrings);
   appendArgument("FileType", FileType, CharacteristicKindStrings);
@@ -115,7 +118,8 @@ void
 PPCallbacksTracker::FileSkipped(const clang::FileEntry &SkippedFile,
                                 const clang::Token &FilenameTok,
                                 clang::SrcMgr::CharacteristicKind FileType) {
-  beginCallback("FileSkipped");
+  if (!beginCallback("FileSkipped"))
+    return;
   appendArgument("ParentFile", &SkippedFile);
   appendArgument("FilenameTok", FilenameTok);
   appendArgument("FileType", FileType, CharacteristicKindStrings);
@@ -126,8 +130,8 @@ PPCallbacksTracker::FileSkipped(const clang::FileEntry &SkippedFile,
 bool
 PPCallbacksTracker::FileNotFound(llvm::StringRef FileName,
                                  llvm::SmallVectorImpl<char> &RecoveryPath) {
-  beginCallback("FileNotFound");
-  appendFilePathArgument("FileName", FileName);
+  if (beginCallback("FileNotFound"))
+    appendFilePathArgument("FileName", FileName);
   return false;
 }
 
@@ -140,7 +144,8 @@ void PPCallbacksTracker::InclusionDirective(
     clang::CharSourceRange FilenameRange, const clang::FileEntry *File,
     llvm::StringRef SearchPath, llvm::StringRef RelativePath,
     const clang::Module *Imported) {
-  beginCallback("InclusionDirective");
+  if (!beginCallback("InclusionDirective"))
+    return;
   appendArgument("IncludeTok", IncludeTok);
   appendFilePathArgument("FileName", FileName);
   appendArgument("IsAngled", IsAngled);
@@ -156,7 +161,8 @@ void PPCallbacksTracker::InclusionDirective(
 void PPCallbacksTracker::moduleImport(clang::SourceLocation ImportLoc,
                                       clang::ModuleIdPath Path,
                                       const clang::Module *Imported) {
-  beginCallback("moduleImport");
+  if (!beginCallback("moduleImport"))
+    return;
   appendArgument("ImportLoc", ImportLoc);
   appendArgument("Path", Path);
   appendArgument("Imported", Imported);
@@ -168,7 +174,8 @@ void PPCallbacksTracker::EndOfMainFile() { beginCallback("EndOfMainFile"); }
 
 // Callback invoked when a #ident or #sccs directive is read.
 void PPCallbacksTracker::Ident(clang::SourceLocation Loc, llvm::StringRef Str) {
-  beginCallback("Ident");
+  if (!beginCallback("Ident"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Str", Str);
 }
@@ -177,7 +184,8 @@ void PPCallbacksTracker::Ident(clang::SourceLocation Loc, llvm::StringRef Str) {
 void
 PPCallbacksTracker::PragmaDirective(clang::SourceLocation Loc,
                                     clang::PragmaIntroducerKind Introducer) {
-  beginCallback("PragmaDirective");
+  if (!beginCallback("PragmaDirective"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Introducer", Introducer, PragmaIntroducerKindStrings);
 }
@@ -186,7 +194,8 @@ PPCallbacksTracker::PragmaDirective(clang::SourceLocation Loc,
 void PPCallbacksTracker::PragmaComment(clang::SourceLocation Loc,
                                        const clang::IdentifierInfo *Kind,
                                        llvm::StringRef Str) {
-  beginCallback("PragmaComment");
+  if (!beginCallback("PragmaComment"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Kind", Kind);
   appendArgument("Str", Str);
@@ -197,7 +206,8 @@ void PPCallbacksTracker::PragmaComment(clang::SourceLocation Loc,
 void PPCallbacksTracker::PragmaDetectMismatch(clang::SourceLocation Loc,
                                               llvm::StringRef Name,
                                               llvm::StringRef Value) {
-  beginCallback("PragmaDetectMismatch");
+  if (!beginCallback("PragmaDetectMismatch"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Name", Name);
   appendArgument("Value", Value);
@@ -206,7 +216,8 @@ void PPCallbacksTracker::PragmaDetectMismatch(clang::SourceLocation Loc,
 // Callback invoked when a #pragma clang __debug directive is read.
 void PPCallbacksTracker::PragmaDebug(clang::SourceLocation Loc,
                                      llvm::StringRef DebugType) {
-  beginCallback("PragmaDebug");
+  if (!beginCallback("PragmaDebug"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("DebugType", DebugType);
 }
@@ -215,7 +226,8 @@ void PPCallbacksTracker::PragmaDebug(clang::SourceLocation Loc,
 void PPCallbacksTracker::PragmaMessage(
     clang::SourceLocation Loc, llvm::StringRef Namespace,
     clang::PPCallbacks::PragmaMessageKind Kind, llvm::StringRef Str) {
-  beginCallback("PragmaMessage");
+  if (!beginCallback("PragmaMessage"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Namespace", Namespace);
   appendArgument("Kind", Kind, PragmaMessageKindStrings);
@@ -226,7 +238,8 @@ void PPCallbacksTracker::PragmaMessage(
 // is read.
 void PPCallbacksTracker::PragmaDiagnosticPush(clang::SourceLocation Loc,
                                               llvm::StringRef Namespace) {
-  beginCallback("PragmaDiagnosticPush");
+  if (!beginCallback("PragmaDiagnosticPush"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Namespace", Namespace);
 }
@@ -235,7 +248,8 @@ void PPCallbacksTracker::PragmaDiagnosticPush(clang::SourceLocation Loc,
 // is read.
 void PPCallbacksTracker::PragmaDiagnosticPop(clang::SourceLocation Loc,
                                              llvm::StringRef Namespace) {
-  beginCallback("PragmaDiagnosticPop");
+  if (!beginCallback("PragmaDiagnosticPop"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Namespace", Namespace);
 }
@@ -245,7 +259,8 @@ void PPCallbacksTracker::PragmaDiagnostic(clang::SourceLocation Loc,
                                           llvm::StringRef Namespace,
                                           clang::diag::Severity Mapping,
                                           llvm::StringRef Str) {
-  beginCallback("PragmaDiagnostic");
+  if (!beginCallback("PragmaDiagnostic"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Namespace", Namespace);
   appendArgument("Mapping", (unsigned)Mapping, MappingStrings);
@@ -257,7 +272,8 @@ void PPCallbacksTracker::PragmaDiagnostic(clang::SourceLocation Loc,
 void PPCallbacksTracker::PragmaOpenCLExtension(
     clang::SourceLocation NameLoc, const clang::IdentifierInfo *Name,
     clang::SourceLocation StateLoc, unsigned State) {
-  beginCallback("PragmaOpenCLExtension");
+  if (!beginCallback("PragmaOpenCLExtension"))
+    return;
   appendArgument("NameLoc", NameLoc);
   appendArgument("Name", Name);
   appendArgument("StateLoc", StateLoc);
@@ -268,7 +284,8 @@ void PPCallbacksTracker::PragmaOpenCLExtension(
 void PPCallbacksTracker::PragmaWarning(clang::SourceLocation Loc,
                                        llvm::StringRef WarningSpec,
                                        llvm::ArrayRef<int> Ids) {
-  beginCallback("PragmaWarning");
+  if (!beginCallback("PragmaWarning"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("WarningSpec", WarningSpec);
 
@@ -287,14 +304,16 @@ void PPCallbacksTracker::PragmaWarning(clang::SourceLocation Loc,
 // Callback invoked when a #pragma warning(push) directive is read.
 void PPCallbacksTracker::PragmaWarningPush(clang::SourceLocation Loc,
                                            int Level) {
-  beginCallback("PragmaWarningPush");
+  if (!beginCallback("PragmaWarningPush"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("Level", Level);
 }
 
 // Callback invoked when a #pragma warning(pop) directive is read.
 void PPCallbacksTracker::PragmaWarningPop(clang::SourceLocation Loc) {
-  beginCallback("PragmaWarningPop");
+  if (!beginCallback("PragmaWarningPop"))
+    return;
   appendArgument("Loc", Loc);
 }
 
@@ -305,7 +324,8 @@ PPCallbacksTracker::MacroExpands(const clang::Token &MacroNameTok,
                                  const clang::MacroDefinition &MacroDefinition,
                                  clang::SourceRange Range,
                                  const clang::MacroArgs *Args) {
-  beginCallback("MacroExpands");
+  if (!beginCallback("MacroExpands"))
+    return;
   appendArgument("MacroNameTok", MacroNameTok);
   appendArgument("MacroDefinition", MacroDefinition);
   appendArgument("Range", Range);
@@ -316,7 +336,8 @@ PPCallbacksTracker::MacroExpands(const clang::Token &MacroNameTok,
 void
 PPCallbacksTracker::MacroDefined(const clang::Token &MacroNameTok,
                                  const clang::MacroDirective *MacroDirective) {
-  beginCallback("MacroDefined");
+  if (!beginCallback("MacroDefined"))
+    return;
   appendArgument("MacroNameTok", MacroNameTok);
   appendArgument("MacroDirective", MacroDirective);
 }
@@ -325,7 +346,8 @@ PPCallbacksTracker::MacroDefined(const clang::Token &MacroNameTok,
 void PPCallbacksTracker::MacroUndefined(
     const clang::Token &MacroNameTok,
     const clang::MacroDefinition &MacroDefinition) {
-  beginCallback("MacroUndefined");
+  if (!beginCallback("MacroUndefined"))
+    return;
   appendArgument("MacroNameTok", MacroNameTok);
   appendArgument("MacroDefinition", MacroDefinition);
 }
@@ -334,7 +356,8 @@ void PPCallbacksTracker::MacroUndefined(
 void PPCallbacksTracker::Defined(const clang::Token &MacroNameTok,
                                  const clang::MacroDefinition &MacroDefinition,
                                  clang::SourceRange Range) {
-  beginCallback("Defined");
+  if (!beginCallback("Defined"))
+    return;
   appendArgument("MacroNameTok", MacroNameTok);
   appendArgument("MacroDefinition", MacroDefinition);
   appendArgument("Range", Range);
@@ -342,7 +365,8 @@ void PPCallbacksTracker::Defined(const clang::Token &MacroNameTok,
 
 // Hook called when a source range is skipped.
 void PPCallbacksTracker::SourceRangeSkipped(clang::SourceRange Range) {
-  beginCallback("SourceRangeSkipped");
+  if (!beginCallback("SourceRangeSkipped"))
+    return;
   appendArgument("Range", Range);
 }
 
@@ -350,7 +374,8 @@ void PPCallbacksTracker::SourceRangeSkipped(clang::SourceRange Range) {
 void PPCallbacksTracker::If(clang::SourceLocation Loc,
                             clang::SourceRange ConditionRange,
                             ConditionValueKind ConditionValue) {
-  beginCallback("If");
+  if (!beginCallback("If"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("ConditionRange", ConditionRange);
   appendArgument("ConditionValue", ConditionValue, ConditionValueKindStrings);
@@ -361,7 +386,8 @@ void PPCallbacksTracker::Elif(clang::SourceLocation Loc,
                               clang::SourceRange ConditionRange,
                               ConditionValueKind ConditionValue,
                               clang::SourceLocation IfLoc) {
-  beginCallback("Elif");
+  if (!beginCallback("Elif"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("ConditionRange", ConditionRange);
   appendArgument("ConditionValue", ConditionValue, ConditionValueKindStrings);
@@ -372,7 +398,8 @@ void PPCallbacksTracker::Elif(clang::SourceLocation Loc,
 void PPCallbacksTracker::Ifdef(clang::SourceLocation Loc,
                                const clang::Token &MacroNameTok,
                                const clang::MacroDefinition &MacroDefinition) {
-  beginCallback("Ifdef");
+  if (!beginCallback("Ifdef"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("MacroNameTok", MacroNameTok);
   appendArgument("MacroDefinition", MacroDefinition);
@@ -382,7 +409,8 @@ void PPCallbacksTracker::Ifdef(clang::SourceLocation Loc,
 void PPCallbacksTracker::Ifndef(clang::SourceLocation Loc,
                                 const clang::Token &MacroNameTok,
                                 const clang::MacroDefinition &MacroDefinition) {
-  beginCallback("Ifndef");
+  if (!beginCallback("Ifndef"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("MacroNameTok", MacroNameTok);
   appendArgument("MacroDefinition", MacroDefinition);
@@ -391,7 +419,8 @@ void PPCallbacksTracker::Ifndef(clang::SourceLocation Loc,
 // Hook called whenever an #else is seen.
 void PPCallbacksTracker::Else(clang::SourceLocation Loc,
                               clang::SourceLocation IfLoc) {
-  beginCallback("Else");
+  if (!beginCallback("Else"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("IfLoc", IfLoc);
 }
@@ -399,7 +428,8 @@ void PPCallbacksTracker::Else(clang::SourceLocation Loc,
 // Hook called whenever an #endif is seen.
 void PPCallbacksTracker::Endif(clang::SourceLocation Loc,
                                clang::SourceLocation IfLoc) {
-  beginCallback("Endif");
+  if (!beginCallback("Endif"))
+    return;
   appendArgument("Loc", Loc);
   appendArgument("IfLoc", IfLoc);
 }
@@ -407,11 +437,11 @@ void PPCallbacksTracker::Endif(clang::SourceLocation Loc,
 // Helper functions.
 
 // Start a new callback.
-void PPCallbacksTracker::beginCallback(const char *Name) {
-  DisableTrace = Ignore.count(std::string(Name));
-  if (DisableTrace)
-    return;
-  CallbackCalls.push_back(CallbackCall(Name));
+bool PPCallbacksTracker::beginCallback(const char *Name) {
+  if (Ignore.count(Name))
+    return false;
+  Writer.beginCallback(Name);
+  return true;
 }
 
 // Append a bool argument to the top trace item.
@@ -429,21 +459,19 @@ void PPCallbacksTracker::appendArgument(const char *Name, int Value) {
 
 // Append a string argument to the top trace item.
 void PPCallbacksTracker::appendArgument(const char *Name, const char *Value) {
-  if (DisableTrace)
-    return;
-  CallbackCalls.back().Arguments.push_back(Argument(Name, Value));
+  Writer.writeArgument(Name, Value);
 }
 
 // Append a string object argument to the top trace item.
 void PPCallbacksTracker::appendArgument(const char *Name,
                                         llvm::StringRef Value) {
-  appendArgument(Name, Value.str());
+  Writer.writeArgument(Name, Value);
 }
 
 // Append a string object argument to the top trace item.
 void PPCallbacksTracker::appendArgument(const char *Name,
                                         const std::string &Value) {
-  appendArgument(Name, Value.c_str());
+  Writer.writeArgument(Name, Value);
 }
 
 // Append a token argument to the top trace item.
@@ -496,8 +524,6 @@ void PPCallbacksTracker::appendArgument(const char *Name,
 // Append a SourceRange argument to the top trace item.
 void PPCallbacksTracker::appendArgument(const char *Name,
                                         clang::SourceRange Value) {
-  if (DisableTrace)
-    return;
   if (Value.isInvalid()) {
     appendArgument(Name, "(invalid)");
     return;
@@ -522,8 +548,6 @@ void PPCallbacksTracker::appendArgument(const char *Name,
 // Append a SourceLocation argument to the top trace item.
 void PPCallbacksTracker::appendArgument(const char *Name,
                                         clang::ModuleIdPath Value) {
-  if (DisableTrace)
-    return;
   std::string Str;
   llvm::raw_string_ostream SS(Str);
   SS << "[";
@@ -12,10 +12,8 @@
 ///
 /// The core definition is the PPCallbacksTracker class, derived from Clang's
 /// PPCallbacks class from the Lex library, which overrides all the callbacks
-/// and collects information about each callback call, saving it in a
-/// data structure built up of CallbackCall and Argument objects, which
-/// record the preprocessor callback name and arguments in high-level string
-/// form for later inspection.
+/// and passes the name and arguments of each callback call, in high-level
+/// string form, to a CallbackTraceWriter as the call happens.
 ///
 //===----------------------------------------------------------------------===//
 
@@ -26,46 +24,39 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/ArrayRef.h"
-#include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include <string>
-#include <vector>
 
-/// \brief This class represents one callback function argument by name
-///   and value.
-class Argument {
+/// \brief This class receives the trace of callback calls as they happen.
+///
+/// For each traced callback, beginCallback is called with the callback name,
+/// followed by one writeArgument call per argument.  The names are string
+/// literals, but the argument values are only valid for the duration of the
+/// call, so a writer must output or copy them right away.
+class CallbackTraceWriter {
 public:
-  Argument(llvm::StringRef Name, llvm::StringRef Value)
-      : Name(Name), Value(Value) {}
-  Argument() = default;
+  virtual ~CallbackTraceWriter();
 
-  std::string Name;
-  std::string Value;
-};
+  /// \brief Start a new callback call.
+  virtual void beginCallback(llvm::StringRef Name) = 0;
 
-/// \brief This class represents one callback call by name and an array
-///   of arguments.
-class CallbackCall {
-public:
-  CallbackCall(llvm::StringRef Name) : Name(Name) {}
-  CallbackCall() = default;
-
-  std::string Name;
-  std::vector<Argument> Arguments;
+  /// \brief Write an argument of the current callback call.
+  virtual void writeArgument(llvm::StringRef Name, llvm::StringRef Value) = 0;
 };
 
 /// \brief This class overrides the PPCallbacks class for tracking preprocessor
 ///   activity by means of its callback functions.
 ///
-/// This object is given a vector for storing the trace information, built up
-/// of CallbackCall and subordinate Argument objects for representing the
-/// callback calls and their arguments.  It's a reference so the vector can
-/// exist beyond the lifetime of this object, because it's deleted by the
-/// preprocessor automatically in its destructor.
+/// This object is given a writer to which the trace information is streamed,
+/// so nothing is buffered for the lifetime of the preprocessor.  It's a
+/// reference so the writer can exist beyond the lifetime of this object,
+/// because it's deleted by the preprocessor automatically in its destructor.
 ///
 /// This class supports a mechanism for inhibiting trace output for
 /// specific callbacks by name, for the purpose of eliminating output for
-/// callbacks of no interest that might clutter the output.
+/// callbacks of no interest that might clutter the output.  The arguments
+/// of ignored callbacks are never formatted.
 ///
 /// Following the constructor and destructor function declarations, the
 /// overidden callback functions are defined.  The remaining functions are
@@ -76,11 +67,10 @@ public:
   /// \brief Note that all of the arguments are references, and owned
   /// by the caller.
   /// \param Ignore - Set of names of callbacks to ignore.
-  /// \param CallbackCalls - Trace buffer.
+  /// \param Writer - Receiver of the trace.
   /// \param PP - The preprocessor.  Needed for getting some argument strings.
-  PPCallbacksTracker(llvm::SmallSet<std::string, 4> &Ignore,
-                     std::vector<CallbackCall> &CallbackCalls,
-                     clang::Preprocessor &PP);
+  PPCallbacksTracker(const llvm::StringSet<> &Ignore,
+                     CallbackTraceWriter &Writer, clang::Preprocessor &PP);
 
   ~PPCallbacksTracker() override;
 
@@ -161,7 +151,9 @@ public:
   // Helper functions.
 
   /// \brief Start a new callback.
-  void beginCallback(const char *Name);
+  /// \returns false if the callback is ignored, in which case its arguments
+  /// should not be appended.
+  bool beginCallback(const char *Name);
 
   /// \brief Append a string to the top trace item.
   void append(const char *Str);
@@ -229,16 +221,13 @@ public:
   /// \brief Get the raw source string of the range.
   llvm::StringRef getSourceString(clang::CharSourceRange Range);
 
-  /// \brief Callback trace information.
-  /// We use a reference so the trace will be preserved for the caller
+  /// \brief Callback trace receiver.
+  /// We use a reference so the writer will be preserved for the caller
   /// after this object is destructed.
-  std::vector<CallbackCall> &CallbackCalls;
+  CallbackTraceWriter &Writer;
 
   /// \brief Names of callbacks to ignore.
-  llvm::SmallSet<std::string, 4> &Ignore;
-
-  /// \brief Inhibit trace while this is set.
-  bool DisableTrace;
+  const llvm::StringSet<> &Ignore;
 
   clang::Preprocessor &PP;
 };
@@ -39,6 +39,16 @@
 //                                  (etc.)
 //                                  ...
 //
+//    -format (yaml|jsonl)        Select the trace format.  "yaml" (the default)
+//                                is the format shown above.  "jsonl" writes
+//                                one JSON object per line for each callback,
+//                                e.g.:
+//
+//                                  {"Callback":"Name","Argument1":"Value1"}
+//
+// The trace is written as the callbacks are called, rather than being
+// collected and written after the run.
+//
 // Future Directions:
 //
 // 1. Add option opposite to "-ignore" that specifys a comma-separated option
@@ -57,6 +67,8 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptTable.h"
@@ -65,6 +77,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include <algorithm>
 #include <fstream>
@@ -96,82 +109,163 @@ static cl::opt<std::string> OutputFileName(
     "output", cl::init(""),
     cl::desc("Output trace to the given file name or '-' for stdout."));
 
+// Option to specify the trace output format.
+enum TraceFormat { yaml, jsonl };
+static cl::opt<TraceFormat> OutputFormat(
+    "format", cl::init(yaml), cl::desc("Specify the trace output format."),
+    cl::values(clEnumVal(yaml, "YAML document (default)"),
+               clEnumVal(jsonl, "One JSON object per line per callback")));
+
+// Option to only output the trace of a successful run to stdout.
+static cl::opt<bool> SuccessOnly(
+    "success-only", cl::init(false),
+    cl::desc("Only write the trace to stdout once the run succeeded."));
+
 // Collect all other arguments, which will be passed to the front end.
 static cl::list<std::string>
     CC1Arguments(cl::ConsumeAfter,
                  cl::desc("<arguments to be passed to front end>..."));
 
+// Trace writers:
+
+namespace {
+// Writes the trace as a YAML document.
+class YAMLTraceWriter : public CallbackTraceWriter {
+public:
+  YAMLTraceWriter(raw_ostream &OS) : OS(OS) {
+    // Mark start of document.
+    OS << "---\n";
+  }
+
+  ~YAMLTraceWriter() override {
+    // Mark end of document.
+    OS << "...\n";
+  }
+
+  void beginCallback(StringRef Name) override {
+    OS << "- Callback: " << Name << "\n";
+  }
+
+  void writeArgument(StringRef Name, StringRef Value) override {
+    OS << "  " << Name << ": " << Value << "\n";
+  }
+
+private:
+  raw_ostream &OS;
+};
+
+// Writes the trace as one JSON object per callback, one per line.
+class JSONLinesTraceWriter : public CallbackTraceWriter {
+public:
+  JSONLinesTraceWriter(raw_ostream &OS) : OS(OS) {}
+
+  ~JSONLinesTraceWriter() override { endCallback(); }
+
+  void beginCallback(StringRef Name) override {
+    endCallback();
+    OS << "{\"Callback\":";
+    writeString(Name);
+    InCallback = true;
+  }
+
+  void writeArgument(StringRef Name, StringRef Value) override {
+    OS << ',';
+    writeString(Name);
+    OS << ':';
+    // Values that the YAML format double-quotes are plain JSON strings.
+    if (Value.size() >= 2 && Value.front() == '"' && Value.back() == '"')
+      Value = Value.drop_front().drop_back();
+    writeString(Value);
+  }
+
+private:
+  void endCallback() {
+    if (!InCallback)
+      return;
+    OS << "}\n";
+    InCallback = false;
+  }
+
+  void writeString(StringRef Str) {
+    OS << '"';
+    for (unsigned char C : Str) {
+      if (C == '"' || C == '\\')
+        OS << '\\' << C;
+      else if (C < 0x20)
+        OS << "\\u00" << hexdigit(C >> 4) << hexdigit(C & 0xF);
+      else
+        OS << C;
+    }
+    OS << '"';
+  }
+
+  raw_ostream &OS;
+  bool InCallback = false;
+};
+
+// Create a writer for the requested trace format.
+std::unique_ptr<CallbackTraceWriter> createTraceWriter(raw_ostream &OS) {
+  switch (OutputFormat) {
+  case jsonl:
+    return llvm::make_unique<JSONLinesTraceWriter>(OS);
+  case yaml:
+    break;
+  }
+  return llvm::make_unique<YAMLTraceWriter>(OS);
+}
+} // namespace
+
 // Frontend action stuff:
 
 namespace {
 // Consumer is responsible for setting up the callbacks.
 class PPTraceConsumer : public ASTConsumer {
 public:
-  PPTraceConsumer(SmallSet<std::string, 4> &Ignore,
-                  std::vector<CallbackCall> &CallbackCalls, Preprocessor &PP) {
+  PPTraceConsumer(const StringSet<> &Ignore, CallbackTraceWriter &Writer,
+                  Preprocessor &PP) {
     // PP takes ownership.
-    PP.addPPCallbacks(llvm::make_unique<PPCallbacksTracker>(Ignore,
-                                                            CallbackCalls, PP));
+    PP.addPPCallbacks(
+        llvm::make_unique<PPCallbacksTracker>(Ignore, Writer, PP));
   }
 };
 
 class PPTraceAction : public SyntaxOnlyAction {
 public:
-  PPTraceAction(SmallSet<std::string, 4> &Ignore,
-                std::vector<CallbackCall> &CallbackCalls)
-      : Ignore(Ignore), CallbackCalls(CallbackCalls) {}
+  PPTraceAction(const StringSet<> &Ignore, CallbackTraceWriter &Writer)
+      : Ignore(Ignore), Writer(Writer) {}
 
 protected:
   std::unique_ptr<clang::ASTConsumer>
   CreateASTConsumer(CompilerInstance &CI, StringRef InFile) override {
-    return llvm::make_unique<PPTraceConsumer>(Ignore, CallbackCalls,
+    return llvm::make_unique<PPTraceConsumer>(Ignore, Writer,
                                               CI.getPreprocessor());
   }
 
 private:
-  SmallSet<std::string, 4> &Ignore;
-  std::vector<CallbackCall> &CallbackCalls;
+  const StringSet<> &Ignore;
+  CallbackTraceWriter &Writer;
 };
 
 class PPTraceFrontendActionFactory : public FrontendActionFactory {
 public:
-  PPTraceFrontendActionFactory(SmallSet<std::string, 4> &Ignore,
-                               std::vector<CallbackCall> &CallbackCalls)
-      : Ignore(Ignore), CallbackCalls(CallbackCalls) {}
+  PPTraceFrontendActionFactory(const StringSet<> &Ignore,
+                               CallbackTraceWriter &Writer)
+      : Ignore(Ignore), Writer(Writer) {}
 
-  PPTraceAction *create() override {
-    return new PPTraceAction(Ignore, CallbackCalls);
-  }
+  PPTraceAction *create() override { return new PPTraceAction(Ignore, Writer); }
 
 private:
-  SmallSet<std::string, 4> &Ignore;
-  std::vector<CallbackCall> &CallbackCalls;
+  const StringSet<> &Ignore;
+  CallbackTraceWriter &Writer;
 };
 } // namespace
 
-// Output the trace given its data structure and a stream.
-static int outputPPTrace(std::vector<CallbackCall> &CallbackCalls,
-                         llvm::raw_ostream &OS) {
-  // Mark start of document.
-  OS << "---\n";
-
-  for (std::vector<CallbackCall>::const_iterator I = CallbackCalls.begin(),
-                                                 E = CallbackCalls.end();
-       I != E; ++I) {
-    const CallbackCall &Callback = *I;
-    OS << "- Callback: " << Callback.Name << "\n";
-
-    for (auto AI = Callback.Arguments.begin(), AE = Callback.Arguments.end();
-         AI != AE; ++AI) {
-      const Argument &Arg = *AI;
-      OS << "  " << Arg.Name << ": " << Arg.Value << "\n";
-    }
-  }
-
-  // Mark end of document.
-  OS << "...\n";
-
-  return 0;
+// Run the tool, streaming the trace to the given stream.
+static int runPPTrace(ClangTool &Tool, const StringSet<> &Ignore,
+                      raw_ostream &OS) {
+  std::unique_ptr<CallbackTraceWriter> Writer = createTraceWriter(OS);
+  PPTraceFrontendActionFactory Factory(Ignore, *Writer);
+  return Tool.run(&Factory);
 }
 
 // Program entry point.
@@ -184,11 +278,9 @@ int main(int Argc, const char **Argv) {
   SmallVector<StringRef, 32> IgnoreCallbacksStrings;
   StringRef(IgnoreCallbacks).split(IgnoreCallbacksStrings, ",",
                                    /*MaxSplit=*/ -1, /*KeepEmpty=*/false);
-  SmallSet<std::string, 4> Ignore;
-  for (SmallVector<StringRef, 32>::iterator I = IgnoreCallbacksStrings.begin(),
-                                            E = IgnoreCallbacksStrings.end();
-       I != E; ++I)
-    Ignore.insert(*I);
+  StringSet<> Ignore;
+  for (StringRef Name : IgnoreCallbacksStrings)
+    Ignore.insert(Name);
 
   // Create the compilation database.
   SmallString<256> PathBuf;
@@ -197,37 +289,58 @@ int main(int Argc, const char **Argv) {
   Compilations.reset(
       new FixedCompilationDatabase(Twine(PathBuf), CC1Arguments));
 
-  // Store the callback trace information here.
-  std::vector<CallbackCall> CallbackCalls;
-
-  // Create the tool and run the compilation.
+  // Create the tool.
   ClangTool Tool(*Compilations, SourcePaths);
-  PPTraceFrontendActionFactory Factory(Ignore, CallbackCalls);
-  int HadErrors = Tool.run(&Factory);
 
-  // If we had errors, exit early.
-  if (HadErrors)
-    return HadErrors;
+  // Run the compilation, writing the trace as it is produced.
+  bool TraceToStdout = !OutputFileName.size();
+  if (TraceToStdout && !SuccessOnly)
+    return runPPTrace(Tool, Ignore, llvm::outs());
 
-  // Do the output.
-  if (!OutputFileName.size()) {
-    HadErrors = outputPPTrace(CallbackCalls, llvm::outs());
-  } else {
-    // Set up output file.
-    std::error_code EC;
-    llvm::tool_output_file Out(OutputFileName, EC, llvm::sys::fs::F_Text);
-    if (EC) {
-      llvm::errs() << "pp-trace: error creating " << OutputFileName << ":"
+  // With -success-only, the trace only goes to stdout once the run succeeded,
+  // so it is first written to a temporary file.
+  SmallString<128> TraceFileName;
+  if (TraceToStdout) {
+    int FD;
+    if (std::error_code EC = sys::fs::createTemporaryFile("pp-trace", "txt",
+                                                          FD, TraceFileName)) {
+      llvm::errs() << "pp-trace: error creating temporary file:"
                    << EC.message() << "\n";
       return 1;
     }
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  } else {
+    TraceFileName = OutputFileName;
+  }
 
-    HadErrors = outputPPTrace(CallbackCalls, Out.os());
+  // Set up output file.
+  std::error_code EC;
+  llvm::tool_output_file Out(TraceFileName, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    llvm::errs() << "pp-trace: error creating " << TraceFileName << ":"
+                 << EC.message() << "\n";
+    return 1;
+  }
+
+  int HadErrors = runPPTrace(Tool, Ignore, Out.os());
+  if (HadErrors)
+    return HadErrors;
 
-    // Tell tool_output_file that we want to keep the file.
-    if (HadErrors == 0)
-      Out.keep();
+  if (TraceToStdout) {
+    // Copy the trace to stdout; tool_output_file removes the temporary file.
+    Out.os().close();
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Trace =
+        MemoryBuffer::getFile(TraceFileName);
+    if (!Trace) {
+      llvm::errs() << "pp-trace: error reading " << TraceFileName << ":"
+                   << Trace.getError().message() << "\n";
+      return 1;
+    }
+    llvm::outs() << (*Trace)->getBuffer();
+    return 0;
   }
 
-  return HadErrors;
+  // Tell tool_output_file that we want to keep the file.
+  Out.keep();
+  return 0;
 }
@@ -0,0 +1,24 @@
+// RUN: rm -rf %T/clang-tidy-results
+// RUN: mkdir -p %T/clang-tidy-results
+// RUN: echo 'int *HP = 0;' > %T/clang-tidy-results/header.h
+// RUN: echo '#include "header.h"' > %T/clang-tidy-results/a.cpp
+// RUN: echo 'int *AP = 0;' >> %T/clang-tidy-results/a.cpp
+// RUN: echo '#include "header.h"' > %T/clang-tidy-results/b.cpp
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* -export-results=%T/clang-tidy-results/a.ctr %T/clang-tidy-results/a.cpp --
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* -export-results=%T/clang-tidy-results/b.ctr %T/clang-tidy-results/b.cpp --
+// RUN: clang-tidy-results -format=text %T/clang-tidy-results/a.ctr %T/clang-tidy-results/b.ctr | FileCheck --check-prefix=CHECK-TEXT %s -implicit-check-not='warning:'
+// RUN: clang-tidy-results -format=counts %T/clang-tidy-results/a.ctr %T/clang-tidy-results/b.ctr | FileCheck --check-prefix=CHECK-COUNTS %s
+// RUN: clang-tidy-results -o %T/clang-tidy-results/merged.ctr %T/clang-tidy-results/a.ctr %T/clang-tidy-results/b.ctr
+// RUN: clang-tidy-results -format=text %T/clang-tidy-results/merged.ctr | FileCheck --check-prefix=CHECK-TEXT %s -implicit-check-not='warning:'
+// RUN: rm %T/clang-tidy-results/header.h
+// RUN: clang-tidy-results -format=text %T/clang-tidy-results/merged.ctr | FileCheck --check-prefix=CHECK-OFFSET %s -implicit-check-not='warning:'
+
+// The warning in the header is reported by both inputs, and only output once.
+// CHECK-TEXT: a.cpp:2:11: warning: use nullptr [modernize-use-nullptr]
+// CHECK-TEXT: header.h:1:11: warning: use nullptr [modernize-use-nullptr]
+
+// CHECK-COUNTS: 2 modernize-use-nullptr
+
+// Without the file, the diagnostic is located by its offset.
+// CHECK-OFFSET: a.cpp:2:11: warning: use nullptr [modernize-use-nullptr]
+// CHECK-OFFSET: header.h: offset 10: warning: use nullptr [modernize-use-nullptr]
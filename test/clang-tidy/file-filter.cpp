@@ -5,35 +5,48 @@
 //       On Win32, file-filter/system\system-header1.h precedes
 //       file-filter\header*.h due to code order between '/' and '\\'.
 // RUN: clang-tidy -checks='-*,google-explicit-constructor' -header-filter='.*' -system-headers %s -- -I %S/Inputs/file-filter/system/.. -isystem %S/Inputs/file-filter/system 2>&1 | FileCheck --check-prefix=CHECK4 %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -header-filter='header2\.h' -skip-headers=filtered %s -- -I %S/Inputs/file-filter -isystem %S/Inputs/file-filter/system 2>&1 | FileCheck --check-prefix=CHECK5 %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -header-filter='' -skip-headers=system %s -- -I %S/Inputs/file-filter -isystem %S/Inputs/file-filter/system 2>&1 | FileCheck --check-prefix=CHECK6 %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -header-filter='header2\.h' -skip-headers=filtered -enable-check-profile %s -- -I %S/Inputs/file-filter -isystem %S/Inputs/file-filter/system 2>&1 >/dev/null | FileCheck --check-prefix=CHECK-PROFILE %s
 
 #include "header1.h"
 // CHECK-NOT: warning:
 // CHECK2: header1.h:1:12: warning: single-argument constructors must be marked explicit
 // CHECK3-NOT: warning:
 // CHECK4: header1.h:1:12: warning: single-argument constructors
+// CHECK5-NOT: warning:
+// CHECK6-NOT: warning:
 
 #include "header2.h"
 // CHECK-NOT: warning:
 // CHECK2: header2.h:1:12: warning: single-argument constructors
 // CHECK3: header2.h:1:12: warning: single-argument constructors
 // CHECK4: header2.h:1:12: warning: single-argument constructors
+// CHECK5: header2.h:1:12: warning: single-argument constructors
+// CHECK6-NOT: warning:
 
 #include <system-header.h>
 // CHECK-NOT: warning:
 // CHECK2-NOT: warning:
 // CHECK3-NOT: warning:
 // CHECK4: system-header.h:1:12: warning: single-argument constructors
+// CHECK5-NOT: warning:
+// CHECK6-NOT: warning:
 
 class A { A(int); };
 // CHECK: :[[@LINE-1]]:11: warning: single-argument constructors
 // CHECK2: :[[@LINE-2]]:11: warning: single-argument constructors
 // CHECK3: :[[@LINE-3]]:11: warning: single-argument constructors
 // CHECK4: :[[@LINE-4]]:11: warning: single-argument constructors
+// CHECK5: :[[@LINE-5]]:11: warning: single-argument constructors
+// CHECK6: :[[@LINE-6]]:11: warning: single-argument constructors
 
 // CHECK-NOT: warning:
 // CHECK2-NOT: warning:
 // CHECK3-NOT: warning:
 // CHECK4-NOT: warning:
+// CHECK5-NOT: warning:
+// CHECK6-NOT: warning:
 
 // CHECK: Suppressed 3 warnings (3 in non-user code)
 // CHECK: Use -header-filter=.* to display errors from all non-system headers.
@@ -43,3 +56,9 @@ class A { A(int); };
 // CHECK3: Use -header-filter=.* {{.*}}
 // CHECK4-NOT: Suppressed {{.*}} warnings
 // CHECK4-NOT: Use -header-filter=.* {{.*}}
+// Skipped headers are not matched, so there are no warnings to suppress.
+// CHECK5-NOT: Suppressed {{.*}} warnings
+// CHECK6: Suppressed 2 warnings (2 in non-user code)
+
+// Checks are profiled when headers are skipped.
+// CHECK-PROFILE: {{.*}}google-explicit-constructor
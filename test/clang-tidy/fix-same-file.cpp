@@ -0,0 +1,17 @@
+// RUN: rm -rf %T/fix-same-file
+// RUN: mkdir -p %T/fix-same-file/sub
+// RUN: echo '#ifdef A' > %T/fix-same-file/header.h
+// RUN: echo 'int *PA = 0;' >> %T/fix-same-file/header.h
+// RUN: echo '#else' >> %T/fix-same-file/header.h
+// RUN: echo 'int *PB = 0;' >> %T/fix-same-file/header.h
+// RUN: echo '#endif' >> %T/fix-same-file/header.h
+// RUN: echo '#define A' > %T/fix-same-file/a.cpp
+// RUN: echo '#include "header.h"' >> %T/fix-same-file/a.cpp
+// RUN: echo '#include "sub/../header.h"' > %T/fix-same-file/b.cpp
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* -fix -fix-threads=2 %T/fix-same-file/a.cpp %T/fix-same-file/b.cpp --
+// RUN: FileCheck -input-file=%T/fix-same-file/header.h %s
+
+// The header is included with a different spelling by each translation unit.
+// The fixes of both are applied to the same file.
+// CHECK: int *PA = nullptr;
+// CHECK: int *PB = nullptr;
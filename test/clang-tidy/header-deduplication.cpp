@@ -0,0 +1,28 @@
+// RUN: mkdir -p %T/header-deduplication
+// RUN: echo 'int *HP = 0;' > %T/header-deduplication/header.h
+// RUN: echo '#include "header.h"' > %T/header-deduplication/a.cpp
+// RUN: echo '#include "header.h"' > %T/header-deduplication/b.cpp
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* %T/header-deduplication/a.cpp %T/header-deduplication/b.cpp -- | FileCheck %s -implicit-check-not='{{warning|error}}:'
+
+// A header included by several translation units is reported once.
+// CHECK: header.h:1:11: warning: use nullptr [modernize-use-nullptr]
+
+// RUN: echo '#ifdef ENABLED' > %T/header-deduplication/macro.h
+// RUN: echo 'int *MP = 0;' >> %T/header-deduplication/macro.h
+// RUN: echo '#else' >> %T/header-deduplication/macro.h
+// RUN: echo 'int MP = 0;' >> %T/header-deduplication/macro.h
+// RUN: echo '#endif' >> %T/header-deduplication/macro.h
+// RUN: echo '#include "macro.h"' > %T/header-deduplication/c.cpp
+// RUN: echo '#define ENABLED' > %T/header-deduplication/d.cpp
+// RUN: echo '#include "macro.h"' >> %T/header-deduplication/d.cpp
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* %T/header-deduplication/c.cpp %T/header-deduplication/d.cpp -- | FileCheck --check-prefix=CHECK-ALL %s -implicit-check-not='{{warning|error}}:'
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* -skip-headers=filtered %T/header-deduplication/c.cpp %T/header-deduplication/d.cpp -- 2>&1 | FileCheck --check-prefix=CHECK-ALL %s -implicit-check-not='{{warning|error}}:'
+// RUN: clang-tidy -checks='-*,modernize-use-nullptr' -header-filter=.* -skip-headers=analyzed %T/header-deduplication/c.cpp %T/header-deduplication/d.cpp -- 2>&1 | FileCheck --check-prefix=CHECK-ANALYZED %s -implicit-check-not='{{warning|error}}:'
+
+// The declarations of the header are matched again for d.cpp, with or without
+// skipping the headers not matching the header filter.
+// CHECK-ALL: macro.h:2:11: warning: use nullptr [modernize-use-nullptr]
+
+// With -skip-headers=analyzed, the header was analyzed for c.cpp, and its
+// declarations are not matched again for d.cpp: the warning is lost.
+// CHECK-ANALYZED-NOT: macro.h
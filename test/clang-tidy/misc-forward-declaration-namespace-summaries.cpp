@@ -0,0 +1,15 @@
+// RUN: echo 'namespace nb { class T_X {}; class T_Y {}; }' > %t-def.cpp
+// RUN: clang-tidy -checks='-*,misc-forward-declaration-namespace' %s %t-def.cpp -- | FileCheck %s -implicit-check-not='{{warning|note}}:'
+// RUN: clang-tidy -checks='-*,misc-forward-declaration-namespace' %s -export-summaries=%t-decl.yaml --
+// RUN: clang-tidy -checks='-*,misc-forward-declaration-namespace' %t-def.cpp -export-summaries=%t-def.yaml --
+// RUN: clang-tidy -checks='-*,misc-forward-declaration-namespace' -reduce-summaries=%t-decl.yaml,%t-def.yaml | FileCheck %s -implicit-check-not='{{warning|note}}:'
+
+namespace na {
+class T_X;
+// CHECK: misc-forward-declaration-namespace-summaries.cpp:[[@LINE-1]]:7: warning: no definition found for 'T_X', but a definition with the same name 'T_X' found in another namespace 'nb' [misc-forward-declaration-namespace]
+// CHECK: -def.cpp:1:22: note: a definition of 'T_X' is found here
+
+// Referenced forward declarations are not diagnosed.
+class T_Y;
+T_Y *Y;
+}
@@ -0,0 +1,57 @@
+// RUN: rm -rf %T/share-preambles
+// RUN: mkdir -p %T/share-preambles
+// RUN: echo '#ifndef GUARDED_H' > %T/share-preambles/guarded.h
+// RUN: echo '#define GUARDED_H' >> %T/share-preambles/guarded.h
+// RUN: echo '#define TWICE(x) (x * 2)' >> %T/share-preambles/guarded.h
+// RUN: echo 'int *GP = 0;' >> %T/share-preambles/guarded.h
+// RUN: echo '#endif' >> %T/share-preambles/guarded.h
+// RUN: echo '#include "guarded.h"' > %T/share-preambles/a.cpp
+// RUN: echo '#include "guarded.h"' > %T/share-preambles/b.cpp
+// RUN: clang-tidy -checks='-*,clang-diagnostic-*,modernize-use-nullptr,misc-macro-parentheses' -header-filter=.* %T/share-preambles/a.cpp %T/share-preambles/b.cpp -- | FileCheck --check-prefix=CHECK-GUARDED %s -implicit-check-not='{{warning|error}}:'
+// RUN: clang-tidy -checks='-*,clang-diagnostic-*,modernize-use-nullptr,misc-macro-parentheses' -header-filter=.* -share-preambles %T/share-preambles/a.cpp %T/share-preambles/b.cpp -- | FileCheck --check-prefix=CHECK-SHARED %s -implicit-check-not='{{warning|error}}:'
+
+// CHECK-GUARDED: guarded.h:3:19: warning: macro argument should be enclosed in parentheses [misc-macro-parentheses]
+// CHECK-GUARDED: guarded.h:4:11: warning: use nullptr [modernize-use-nullptr]
+
+// The shared header is precompiled: AST checks still report it, but the
+// preprocessor callbacks don't see its macro definitions.
+// CHECK-SHARED: guarded.h:4:11: warning: use nullptr [modernize-use-nullptr]
+
+// RUN: echo '#ifndef WARNING_H' > %T/share-preambles/warning.h
+// RUN: echo '#define WARNING_H' >> %T/share-preambles/warning.h
+// RUN: echo '#define TWICE(x) (x * 2)' >> %T/share-preambles/warning.h
+// RUN: echo 'int f() {}' >> %T/share-preambles/warning.h
+// RUN: echo '#endif' >> %T/share-preambles/warning.h
+// RUN: echo '#include "warning.h"' > %T/share-preambles/c.cpp
+// RUN: echo '#include "warning.h"' > %T/share-preambles/d.cpp
+// RUN: clang-tidy -checks='-*,clang-diagnostic-*,misc-macro-parentheses' -header-filter=.* %T/share-preambles/c.cpp %T/share-preambles/d.cpp -- | FileCheck --check-prefix=CHECK-WARNING %s -implicit-check-not='{{warning|error}}:'
+// RUN: clang-tidy -checks='-*,clang-diagnostic-*,misc-macro-parentheses' -header-filter=.* -share-preambles %T/share-preambles/c.cpp %T/share-preambles/d.cpp -- | FileCheck --check-prefix=CHECK-WARNING %s -implicit-check-not='{{warning|error}}:'
+
+// A header with a compiler warning is not shared, so that the translation
+// units report the warning, and its macros are seen as well.
+// CHECK-WARNING: warning.h:3:19: warning: macro argument should be enclosed in parentheses [misc-macro-parentheses]
+// CHECK-WARNING: warning.h:4:10: warning: {{.*}} [clang-diagnostic-return-type]
+
+// RUN: echo '#define TWICE(x) (x * 2)' > %T/share-preambles/unguarded.h
+// RUN: echo 'int *UP = 0;' >> %T/share-preambles/unguarded.h
+// RUN: echo '#include "unguarded.h"' > %T/share-preambles/e.cpp
+// RUN: echo '#include "unguarded.h"' > %T/share-preambles/f.cpp
+// RUN: clang-tidy -checks='-*,clang-diagnostic-*,modernize-use-nullptr,misc-macro-parentheses' -header-filter=.* -share-preambles %T/share-preambles/e.cpp %T/share-preambles/f.cpp -- | FileCheck --check-prefix=CHECK-UNGUARDED %s -implicit-check-not='{{warning|error}}:'
+
+// A header without an include guard is parsed by each translation unit.
+// CHECK-UNGUARDED: unguarded.h:1:19: warning: macro argument should be enclosed in parentheses [misc-macro-parentheses]
+// CHECK-UNGUARDED: unguarded.h:2:11: warning: use nullptr [modernize-use-nullptr]
+
+// RUN: echo '#ifndef MIXED_H' > %T/share-preambles/mixed.h
+// RUN: echo '#define MIXED_H' >> %T/share-preambles/mixed.h
+// RUN: echo 'int *MP = 0;' >> %T/share-preambles/mixed.h
+// RUN: echo '#endif' >> %T/share-preambles/mixed.h
+// RUN: echo '#include "mixed.h"' > %T/share-preambles/g.c
+// RUN: echo '#include "mixed.h"' > %T/share-preambles/h.c
+// RUN: echo '#include "mixed.h"' > %T/share-preambles/i.cpp
+// RUN: echo '#include "mixed.h"' > %T/share-preambles/j.cpp
+// RUN: clang-tidy -checks='-*,clang-diagnostic-*,modernize-use-nullptr' -header-filter=.* -share-preambles %T/share-preambles/g.c %T/share-preambles/h.c %T/share-preambles/i.cpp %T/share-preambles/j.cpp -- | FileCheck --check-prefix=CHECK-MIXED %s -implicit-check-not='{{warning|error}}:'
+
+// C and C++ files with the same arguments get a precompiled header each, and
+// all of them parse.
+// CHECK-MIXED: mixed.h:3:11: warning: use nullptr [modernize-use-nullptr]
@@ -0,0 +1,27 @@
+// RUN: clang-tidy %s -checks='-*,clang-analyzer-*' -line-filter='[{"name":"static-analyzer-budget.cpp","lines":[[10,15]]}]' -- 2>&1 | FileCheck %s -check-prefix=CHECK-FOUND
+// RUN: clang-tidy %s -checks='-*,clang-analyzer-*' -line-filter='[{"name":"static-analyzer-budget.cpp","lines":[[10,15]]}]' -analyzer-max-nodes-per-tu=200 -- 2>&1 | FileCheck %s -check-prefix=CHECK-SPLIT
+// RUN: clang-tidy %s -checks='-*,clang-analyzer-*' -line-filter='[{"name":"static-analyzer-budget.cpp","lines":[[10,15]]}]' -analyzer-max-nodes-per-tu=200 -analyzer-line-filter-only -- 2>&1 | FileCheck %s -check-prefix=CHECK-FOUND
+// RUN: clang-tidy %s -checks='-*,clang-analyzer-*' -analyzer-max-nodes-per-tu=4000000000 -- 2>&1 | FileCheck %s -check-prefix=CHECK-FOUND
+
+extern void *malloc(unsigned long);
+extern void free(void *);
+
+void f() {
+  void *p = malloc(1);
+  free(p);
+  free(p);
+  // CHECK-FOUND: :[[@LINE-1]]:3: warning: Attempt to free released memory [clang-analyzer-unix.Malloc]
+}
+
+#define DEFINE(N) void g##N() {}
+#define DEFINE10(N) DEFINE(N##0) DEFINE(N##1) DEFINE(N##2) DEFINE(N##3) \
+  DEFINE(N##4) DEFINE(N##5) DEFINE(N##6) DEFINE(N##7) DEFINE(N##8) DEFINE(N##9)
+DEFINE10(1)
+DEFINE10(2)
+
+// The budget of the translation unit is split between the 21 functions, which
+// leaves too few nodes to reach the second call to free(). With
+// -analyzer-line-filter-only, f() is the only analyzed function and gets all
+// of the budget. The share of a function is capped by the maximum of the
+// analyzer, so that a large budget doesn't raise it.
+// CHECK-SPLIT-NOT: warning: Attempt to free released memory
@@ -0,0 +1,25 @@
+// RUN: clang-tidy %s -checks='-*,clang-analyzer-*' -line-filter='[{"name":"static-analyzer-line-filter.cpp","lines":[[8,12]]}]' -- 2>&1 | FileCheck %s -check-prefix=CHECK-ALL
+// RUN: clang-tidy %s -checks='-*,clang-analyzer-*' -line-filter='[{"name":"static-analyzer-line-filter.cpp","lines":[[8,12]]}]' -analyzer-line-filter-only -- 2>&1 | FileCheck %s -check-prefix=CHECK-FILTERED
+
+extern void *malloc(unsigned long);
+extern void free(void *);
+
+void f() {
+  void *p = malloc(1);
+  free(p);
+  free(p);
+  // CHECK-ALL: :[[@LINE-1]]:3: warning: Attempt to free released memory [clang-analyzer-unix.Malloc]
+  // CHECK-FILTERED: :[[@LINE-2]]:3: warning: Attempt to free released memory [clang-analyzer-unix.Malloc]
+}
+
+namespace n {
+void g() {
+  void *q = malloc(1);
+  free(q);
+  free(q);
+}
+}
+
+// The analyzer does not look at g() at all with -analyzer-line-filter-only.
+// CHECK-ALL: Suppressed 1 warnings (1 due to line filter)
+// CHECK-FILTERED-NOT: Suppressed
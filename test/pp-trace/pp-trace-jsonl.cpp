@@ -0,0 +1,11 @@
+// RUN: pp-trace -format jsonl -ignore FileChanged,MacroDefined %s -undef -target x86_64 -std=c++11 | FileCheck --strict-whitespace %s
+
+#ident "$Id$"
+#define MACRO(x) x
+int i = MACRO(1);
+
+// CHECK-NOT: ---
+// CHECK: {"Callback":"Ident","Loc":"{{.*}}pp-trace-jsonl.cpp:3:2","Str":"$Id$"}
+// CHECK-NEXT: {"Callback":"MacroExpands","MacroNameTok":"MACRO","MacroDefinition":"[(local)]","Range":"[\"{{.*}}pp-trace-jsonl.cpp:5:9\", \"{{.*}}pp-trace-jsonl.cpp:5:16\"]","Args":"[1]"}
+// CHECK-NEXT: {"Callback":"EndOfMainFile"}
+// CHECK-NOT: ...
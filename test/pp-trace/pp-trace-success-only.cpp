@@ -0,0 +1,18 @@
+// RUN: not pp-trace -ignore FileChanged,MacroDefined %s -undef -target x86_64 -std=c++11 -DFAIL | FileCheck --strict-whitespace --check-prefix=CHECK-STREAM %s
+// RUN: not pp-trace -success-only -ignore FileChanged,MacroDefined %s -undef -target x86_64 -std=c++11 -DFAIL | count 0
+// RUN: pp-trace -success-only -ignore FileChanged,MacroDefined %s -undef -target x86_64 -std=c++11 | FileCheck --strict-whitespace %s
+
+#ident "$Id$"
+#ifdef FAIL
+#error "failed"
+#endif
+
+// By default, the trace of a failing run is written up to the error.
+// CHECK-STREAM: ---
+// CHECK-STREAM-NEXT: - Callback: Ident
+
+// CHECK: ---
+// CHECK-NEXT: - Callback: Ident
+// CHECK-NEXT:   Loc: "{{.*}}{{[/\\]}}pp-trace-success-only.cpp:5:2"
+// CHECK-NEXT:   Str: "$Id$"
+// CHECK-NEXT: - Callback: Ifdef
@@ -1706,6 +1706,43 @@ TEST_F(ChangeNamespaceTest, ShortenNamespaceSpecifierInAnonymousNamespace) {
   EXPECT_EQ(format(Expected), runChangeNamespaceOnCode(Code));
 }
 
+TEST(MergeTranslationUnitReplacementsTest, DeduplicatesIdenticalEdits) {
+  tooling::Replacement Header1("a.h", 0, 3, "x");
+  tooling::Replacement Header2("a.h", 10, 0, "namespace y {\n");
+  tooling::Replacement Source("a.cc", 5, 1, "z");
+  std::map<std::string, tooling::Replacements> TU1;
+  ASSERT_FALSE(static_cast<bool>(TU1["a.h"].add(Header1)));
+  ASSERT_FALSE(static_cast<bool>(TU1["a.h"].add(Header2)));
+  std::map<std::string, tooling::Replacements> TU2;
+  ASSERT_FALSE(static_cast<bool>(TU2["a.h"].add(Header1)));
+  ASSERT_FALSE(static_cast<bool>(TU2["a.cc"].add(Source)));
+
+  std::map<std::string, tooling::Replacements> Merged;
+  EXPECT_FALSE(
+      static_cast<bool>(mergeTranslationUnitReplacements(TU1, &Merged)));
+  EXPECT_FALSE(
+      static_cast<bool>(mergeTranslationUnitReplacements(TU2, &Merged)));
+  ASSERT_EQ(2u, Merged.size());
+  EXPECT_EQ(TU1["a.h"], Merged["a.h"]);
+  EXPECT_EQ(TU2["a.cc"], Merged["a.cc"]);
+}
+
+TEST(MergeTranslationUnitReplacementsTest, ReportsConflicts) {
+  std::map<std::string, tooling::Replacements> TU1;
+  ASSERT_FALSE(static_cast<bool>(
+      TU1["a.h"].add(tooling::Replacement("a.h", 0, 3, "x"))));
+  std::map<std::string, tooling::Replacements> TU2;
+  ASSERT_FALSE(static_cast<bool>(
+      TU2["a.h"].add(tooling::Replacement("a.h", 1, 3, "y"))));
+
+  std::map<std::string, tooling::Replacements> Merged;
+  EXPECT_FALSE(
+      static_cast<bool>(mergeTranslationUnitReplacements(TU1, &Merged)));
+  auto Err = mergeTranslationUnitReplacements(TU2, &Merged);
+  EXPECT_TRUE(static_cast<bool>(Err));
+  llvm::consumeError(std::move(Err));
+}
+
 } // anonymous namespace
 } // namespace change_namespace
 } // namespace clang
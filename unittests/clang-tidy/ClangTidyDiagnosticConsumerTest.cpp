@@ -29,6 +29,113 @@ TEST(ClangTidyDiagnosticConsumer, SortsErrors) {
   EXPECT_EQ("variable", Errors[1].Message.Message);
 }
 
+class HeaderDiagnosticCheck : public ClangTidyCheck {
+public:
+  HeaderDiagnosticCheck(StringRef Name, ClangTidyContext *Context)
+      : ClangTidyCheck(Name, Context) {}
+  void registerMatchers(ast_matchers::MatchFinder *Finder) override {
+    using namespace ast_matchers;
+    Finder->addMatcher(
+        varDecl(hasName("b"),
+                hasInitializer(declRefExpr(to(varDecl().bind("ref")))))
+            .bind("var"),
+        this);
+  }
+  void check(const ast_matchers::MatchFinder::MatchResult &Result) override {
+    const auto *Var = Result.Nodes.getNodeAs<VarDecl>("var");
+    const auto *Ref = Result.Nodes.getNodeAs<VarDecl>("ref");
+    diag(Ref->getLocation(), "kept")
+        << FixItHint::CreateInsertion(Ref->getLocation(), "_");
+    diag(Var->getLocation(), "note in main file", DiagnosticIDs::Note);
+    diag(Ref->getLocation(), "dropped")
+        << FixItHint::CreateInsertion(Ref->getLocation(), "_");
+  }
+};
+
+TEST(ClangTidyDiagnosticConsumer, KeepsHeaderErrorsWithNotesInMainFile) {
+  std::vector<ClangTidyError> Errors;
+  runCheckOnCode<HeaderDiagnosticCheck>(
+      "#include \"header.h\"\nint b = a;", &Errors, "input.cc", None,
+      ClangTidyOptions(), {{"header.h", "int a;"}});
+  ASSERT_EQ(1ul, Errors.size());
+  EXPECT_EQ("kept", Errors[0].Message.Message);
+  ASSERT_EQ(1ul, Errors[0].Notes.size());
+  EXPECT_EQ("note in main file", Errors[0].Notes[0].Message);
+  EXPECT_EQ(1ul, Errors[0].Fix.size());
+}
+
+static void runHeaderDiagnosticCheck(ClangTidyContext &Context,
+                                     ClangTidyDiagnosticConsumer &DiagConsumer,
+                                     StringRef FileName) {
+  llvm::IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
+      new vfs::InMemoryFileSystem);
+  llvm::IntrusiveRefCntPtr<FileManager> Files(
+      new FileManager(FileSystemOptions(), InMemoryFileSystem));
+  InMemoryFileSystem->addFile(
+      FileName, 0,
+      llvm::MemoryBuffer::getMemBuffer("#include \"header.h\"\nint b = a;"));
+  InMemoryFileSystem->addFile("include/header.h", 0,
+                              llvm::MemoryBuffer::getMemBuffer("int a;"));
+  ast_matchers::MatchFinder Finder;
+  SmallVector<std::unique_ptr<ClangTidyCheck>, 1> Checks;
+  CheckFactory<HeaderDiagnosticCheck>::createChecks(&Context, Checks);
+  tooling::ToolInvocation Invocation(
+      {"clang-tidy", "-fsyntax-only", "-Iinclude", FileName.str()},
+      new TestClangTidyAction(Checks, Finder, Context), Files.get());
+  Invocation.setDiagnosticConsumer(&DiagConsumer);
+  ASSERT_TRUE(Invocation.run());
+  DiagConsumer.finish();
+}
+
+TEST(ClangTidyDiagnosticConsumer, ReportsHeaderErrorsOncePerNotes) {
+  ClangTidyOptions Options;
+  Options.Checks = "*";
+  ClangTidyContext Context(llvm::make_unique<DefaultOptionsProvider>(
+      ClangTidyGlobalOptions(), Options));
+  ClangTidyDiagnosticConsumer DiagConsumer(Context);
+
+  runHeaderDiagnosticCheck(Context, DiagConsumer, "input.cc");
+  // The note of the header error points into another main file, so the error
+  // is not a duplicate.
+  runHeaderDiagnosticCheck(Context, DiagConsumer, "other.cc");
+  // The same error with the same note is.
+  runHeaderDiagnosticCheck(Context, DiagConsumer, "input.cc");
+
+  const std::vector<ClangTidyError> &Errors = Context.getErrors();
+  ASSERT_EQ(2ul, Errors.size());
+  EXPECT_EQ("kept", Errors[0].Message.Message);
+  ASSERT_EQ(1ul, Errors[0].Notes.size());
+  EXPECT_EQ("kept", Errors[1].Message.Message);
+  ASSERT_EQ(1ul, Errors[1].Notes.size());
+  EXPECT_NE(Errors[0].Notes[0].FilePath, Errors[1].Notes[0].FilePath);
+  // The dropped errors are filtered out in each translation unit, and only
+  // the last kept error is a duplicate.
+  EXPECT_EQ(3u, Context.getStats().ErrorsIgnoredNonUserCode);
+  EXPECT_EQ(1u, Context.getStats().ErrorsIgnoredDuplicateHeader);
+}
+
+TEST(CheckNameTable, AssignsDenseIDs) {
+  CheckNameTable Names;
+  EXPECT_EQ(0u, Names.getID("misc-a"));
+  EXPECT_EQ(1u, Names.getID("clang-diagnostic-unused"));
+  EXPECT_EQ(0u, Names.getID(std::string("misc-") + "a"));
+  EXPECT_EQ(2u, Names.size());
+  EXPECT_EQ("misc-a", Names.getName(0));
+  EXPECT_EQ("clang-diagnostic-unused", Names.getName(1));
+}
+
+TEST(ClangTidyContext, NoCheckIDMatchesNoFilter) {
+  ClangTidyOptions Options;
+  Options.Checks = "*";
+  Options.WarningsAsErrors = "*";
+  ClangTidyContext Context(llvm::make_unique<DefaultOptionsProvider>(
+      ClangTidyGlobalOptions(), Options));
+  EXPECT_TRUE(Context.isCheckEnabled(Context.getCheckID("misc-a")));
+  EXPECT_FALSE(Context.isCheckEnabled(ClangTidyContext::NoCheckID));
+  EXPECT_FALSE(Context.isWarningAsError(ClangTidyContext::NoCheckID));
+  EXPECT_EQ("", Context.getCheckName(ClangTidyContext::NoCheckID));
+}
+
 TEST(GlobList, Empty) {
   GlobList Filter("");
 
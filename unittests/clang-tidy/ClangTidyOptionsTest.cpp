@@ -1,6 +1,10 @@
 #include "ClangTidyOptions.h"
 #include "gtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 namespace clang {
 namespace tidy {
@@ -58,20 +62,36 @@ TEST(ParseConfiguration, ValidConfiguration) {
   llvm::ErrorOr<ClangTidyOptions> Options =
       parseConfiguration("Checks: \"-*,misc-*\"\n"
                          "HeaderFilterRegex: \".*\"\n"
+                         "SkipHeaders: filtered\n"
                          "AnalyzeTemporaryDtors: true\n"
+                         "AnalyzerMaxNodes: 1000\n"
+                         "AnalyzerMaxNodesPerTU: 100000\n"
+                         "AnalyzerLineFilterOnly: true\n"
                          "User: some.user");
   EXPECT_TRUE(!!Options);
   EXPECT_EQ("-*,misc-*", *Options->Checks);
   EXPECT_EQ(".*", *Options->HeaderFilterRegex);
+  EXPECT_EQ("filtered", *Options->SkipHeaders);
   EXPECT_TRUE(*Options->AnalyzeTemporaryDtors);
+  EXPECT_EQ(1000u, *Options->AnalyzerMaxNodes);
+  EXPECT_EQ(100000u, *Options->AnalyzerMaxNodesPerTU);
+  EXPECT_TRUE(*Options->AnalyzerLineFilterOnly);
   EXPECT_EQ("some.user", *Options->User);
 }
 
+TEST(ParseConfiguration, InvalidSkipHeaders) {
+  EXPECT_FALSE(!!parseConfiguration("SkipHeaders: sytem\n"));
+  EXPECT_TRUE(!!parseConfiguration("SkipHeaders: system\n"));
+  EXPECT_TRUE(!!parseConfiguration("SkipHeaders: analyzed\n"));
+}
+
 TEST(ParseConfiguration, MergeConfigurations) {
   llvm::ErrorOr<ClangTidyOptions> Options1 = parseConfiguration(R"(
       Checks: "check1,check2"
       HeaderFilterRegex: "filter1"
       AnalyzeTemporaryDtors: true
+      AnalyzerMaxNodes: 1000
+      AnalyzerLineFilterOnly: true
       User: user1
       ExtraArgs: ['arg1', 'arg2']
       ExtraArgsBefore: ['arg-before1', 'arg-before2']
@@ -81,6 +101,7 @@ TEST(ParseConfiguration, MergeConfigurations) {
       Checks: "check3,check4"
       HeaderFilterRegex: "filter2"
       AnalyzeTemporaryDtors: false
+      AnalyzerMaxNodes: 2000
       User: user2
       ExtraArgs: ['arg3', 'arg4']
       ExtraArgsBefore: ['arg-before3', 'arg-before4']
@@ -90,6 +111,8 @@ TEST(ParseConfiguration, MergeConfigurations) {
   EXPECT_EQ("check1,check2,check3,check4", *Options.Checks);
   EXPECT_EQ("filter2", *Options.HeaderFilterRegex);
   EXPECT_FALSE(*Options.AnalyzeTemporaryDtors);
+  EXPECT_EQ(2000u, *Options.AnalyzerMaxNodes);
+  EXPECT_TRUE(*Options.AnalyzerLineFilterOnly);
   EXPECT_EQ("user2", *Options.User);
   ASSERT_TRUE(Options.ExtraArgs.hasValue());
   EXPECT_EQ("arg1,arg2,arg3,arg4", llvm::join(Options.ExtraArgs->begin(),
@@ -99,6 +122,126 @@ TEST(ParseConfiguration, MergeConfigurations) {
             llvm::join(Options.ExtraArgsBefore->begin(),
                        Options.ExtraArgsBefore->end(), ","));
 }
+
+TEST(CheckOptionTableTest, ParsesValues) {
+  ClangTidyOptions::OptionMap Options;
+  Options["check.Int"] = "-42";
+  Options["check.Big"] = "300";
+  Options["check.Text"] = "abc";
+  Options["check.List"] = " a ;; b;c ";
+  CheckOptionTable Table(Options);
+  EXPECT_TRUE(Table.isFor(Options));
+
+  const auto *Int = Table.find("check.", "Int");
+  ASSERT_TRUE(Int != nullptr);
+  EXPECT_EQ("-42", Int->getText());
+  EXPECT_EQ(-42, Int->getAs<int>().getValueOr(0));
+  EXPECT_FALSE(Int->getAs<unsigned>().hasValue());
+
+  const auto *Big = Table.find("check.", "Big");
+  ASSERT_TRUE(Big != nullptr);
+  EXPECT_EQ(300u, Big->getAs<unsigned>().getValueOr(0));
+  EXPECT_FALSE(Big->getAs<signed char>().hasValue());
+  EXPECT_FALSE(Big->getAs<bool>().hasValue());
+
+  const auto *Text = Table.find("check.", "Text");
+  ASSERT_TRUE(Text != nullptr);
+  EXPECT_FALSE(Text->getAs<int>().hasValue());
+
+  const auto *List = Table.find("", "check.List");
+  ASSERT_TRUE(List != nullptr);
+  EXPECT_EQ("a,b,c", llvm::join(List->getStringList().begin(),
+                                List->getStringList().end(), ","));
+
+  EXPECT_TRUE(Table.find("check.", "Missing") == nullptr);
+
+  Options["check.Int"] = "1";
+  EXPECT_FALSE(Table.isFor(Options));
+}
+
+static void writeConfig(const Twine &Path, StringRef Content,
+                        llvm::sys::TimePoint<> ModificationTime) {
+  int FD;
+  ASSERT_FALSE(
+      llvm::sys::fs::openFileForWrite(Path, FD, llvm::sys::fs::F_None));
+  llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  OS << Content;
+  OS.flush();
+  ASSERT_FALSE(
+      llvm::sys::fs::setLastModificationAndAccessTime(FD, ModificationTime));
+}
+
+static std::string makePath(StringRef Directory, StringRef Name) {
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, Name);
+  return Path.str();
+}
+
+namespace {
+/// \brief Removes a temporary directory and its contents on destruction.
+struct TemporaryDirectory {
+  ~TemporaryDirectory() {
+    if (!Path.empty())
+      llvm::sys::fs::remove_directories(Path);
+  }
+  SmallString<128> Path;
+};
+} // namespace
+
+TEST(FileOptionsProviderTest, CachesOptionsPerDirectory) {
+  TemporaryDirectory Temp;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("clang-tidy-options", Temp.Path));
+  StringRef Root = Temp.Path;
+  SmallString<128> Nested(Root);
+  llvm::sys::path::append(Nested, "a", "b");
+  ASSERT_FALSE(llvm::sys::fs::create_directories(Nested));
+  SmallString<128> Empty(Root);
+  llvm::sys::path::append(Empty, "c");
+  ASSERT_FALSE(llvm::sys::fs::create_directories(Empty));
+  // The lookup stops at the first configuration file, so the one in the root
+  // keeps any .clang-tidy file above the temporary directory out.
+  std::string RootConfigFile = makePath(Root, ".clang-tidy");
+  writeConfig(RootConfigFile, "Checks: 'root'", llvm::sys::toTimePoint(1000));
+  SmallString<128> ConfigFile(Root);
+  llvm::sys::path::append(ConfigFile, "a", ".clang-tidy");
+  writeConfig(ConfigFile, "Checks: 'check1'", llvm::sys::toTimePoint(1000));
+
+  unsigned Parses = 0;
+  FileOptionsProvider::ConfigFileHandlers Handlers;
+  Handlers.emplace_back(".clang-tidy", [&Parses](StringRef Config) {
+    ++Parses;
+    return parseConfiguration(Config);
+  });
+  ClangTidyOptions DefaultOptions;
+  DefaultOptions.Checks = "-*";
+  FileOptionsProvider Provider(ClangTidyGlobalOptions(), DefaultOptions,
+                               ClangTidyOptions(), Handlers);
+
+  std::string NestedFile = makePath(Nested, "x.cpp");
+  std::string ConfigDirFile = makePath(Root, "a/y.cpp");
+  EXPECT_EQ("-*,check1", *Provider.getOptions(NestedFile).Checks);
+  EXPECT_EQ("-*,check1", *Provider.getOptions(ConfigDirFile).Checks);
+  std::vector<ClangTidyOptionsProvider::OptionsSource> RawOptions =
+      Provider.getRawOptions(makePath(Nested, "z.cpp"));
+  ASSERT_EQ(3u, RawOptions.size());
+  EXPECT_EQ(ConfigFile.str(), RawOptions[1].second);
+  EXPECT_EQ(1u, Parses);
+
+  EXPECT_EQ("-*,root", *Provider.getOptions(makePath(Empty, "x.cpp")).Checks);
+  EXPECT_EQ("-*,root", *Provider.getOptions(makePath(Empty, "y.cpp")).Checks);
+  RawOptions = Provider.getRawOptions(makePath(Empty, "z.cpp"));
+  ASSERT_EQ(3u, RawOptions.size());
+  EXPECT_EQ(RootConfigFile, RawOptions[1].second);
+  EXPECT_EQ(2u, Parses);
+
+  // A modified configuration file is read again.
+  writeConfig(ConfigFile, "Checks: 'check2'", llvm::sys::toTimePoint(2000));
+  EXPECT_EQ("-*,check2", *Provider.getOptions(NestedFile).Checks);
+  EXPECT_EQ("-*,check2", *Provider.getOptions(ConfigDirFile).Checks);
+  EXPECT_EQ(3u, Parses);
+}
+
 } // namespace test
 } // namespace tidy
 } // namespace clang
@@ -0,0 +1,74 @@
+#include "DeclRefIndex.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace tidy {
+namespace test {
+
+using namespace ast_matchers;
+
+static const FunctionDecl *getFunction(ASTContext &Context, StringRef Name) {
+  auto Matches =
+      match(functionDecl(hasName(Name), isDefinition()).bind("f"), Context);
+  EXPECT_EQ(1u, Matches.size());
+  return Matches.empty() ? nullptr : Matches[0].getNodeAs<FunctionDecl>("f");
+}
+
+TEST(DeclRefIndexTest, ClassifiesCallReferences) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(
+      "int g(int);\n"
+      "int f(int x) { return x ? f(x - 1) : 0; }\n"
+      "int h(int y) { return g(y) + f(1) + f(2); }\n"
+      "int (*p)(int) = &h;\n");
+  ASTContext &Context = AST->getASTContext();
+  DeclRefIndex Index(Context);
+
+  const FunctionDecl *F = getFunction(Context, "f");
+  const FunctionDecl *H = getFunction(Context, "h");
+  ASSERT_TRUE(F && H);
+
+  EXPECT_EQ(3u, Index.references(F).size());
+  EXPECT_EQ(3u, Index.callsTo(F).size());
+  EXPECT_FALSE(Index.isReferencedOutsideOfCall(F));
+  EXPECT_FALSE(Index.isReferencedOutsideOfCallToItself(F));
+
+  // The reference to 'x' in the argument of the recursive call is in a call,
+  // but not in a call to 'x'.
+  const ParmVarDecl *X = F->getParamDecl(0);
+  EXPECT_EQ(2u, Index.references(X).size());
+  EXPECT_TRUE(Index.isReferencedOutsideOfCall(X));
+  EXPECT_TRUE(Index.isReferencedOutsideOfCallToItself(X));
+
+  EXPECT_EQ(1u, Index.references(H).size());
+  EXPECT_TRUE(Index.callsTo(H).empty());
+  EXPECT_TRUE(Index.isReferencedOutsideOfCall(H));
+
+  const ParmVarDecl *Y = H->getParamDecl(0);
+  EXPECT_FALSE(Index.isReferencedOutsideOfCall(Y));
+  EXPECT_TRUE(Index.isReferencedOutsideOfCallToItself(Y));
+}
+
+TEST(DeclRefIndexTest, VisitsTemplateInstantiations) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(
+      "void f(int);\n"
+      "template <typename T> void t(T v) { f(v); }\n"
+      "void u() { t(1); t(2L); }\n");
+  ASTContext &Context = AST->getASTContext();
+  DeclRefIndex Index(Context);
+
+  auto Matches = match(
+      functionDecl(hasName("f"), unless(isDefinition())).bind("f"), Context);
+  ASSERT_EQ(1u, Matches.size());
+  const auto *F = Matches[0].getNodeAs<FunctionDecl>("f");
+  // One call in each instantiation; the call in the template pattern is
+  // dependent and has no callee declaration yet.
+  EXPECT_EQ(2u, Index.callsTo(F).size());
+}
+
+} // namespace test
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,116 @@
+#include "ResultsFile.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace tidy {
+namespace test {
+
+static ClangTidyError makeError(StringRef CheckName, StringRef FilePath,
+                                unsigned Offset, StringRef Message) {
+  ClangTidyError Error(CheckName, ClangTidyError::Warning, "/build",
+                       /*IsWarningAsError=*/false);
+  Error.Message = tooling::DiagnosticMessage(Message);
+  Error.Message.FilePath = FilePath;
+  Error.Message.FileOffset = Offset;
+  return Error;
+}
+
+static std::string writeResults(ArrayRef<ClangTidyError> Errors) {
+  std::string Buffer;
+  llvm::raw_string_ostream OS(Buffer);
+  exportResults("/src/main.cc", Errors, OS);
+  return OS.str();
+}
+
+TEST(ResultsFileTest, RoundTrips) {
+  ClangTidyError Error = makeError("misc-a", "/src/a.h", 10, "first");
+  Error.IsWarningAsError = true;
+  Error.Notes.push_back(tooling::DiagnosticMessage("note"));
+  Error.Notes.back().FilePath = "/src/main.cc";
+  Error.Notes.back().FileOffset = 20;
+  EXPECT_FALSE(!!Error.Fix["/src/a.h"].add(
+      tooling::Replacement("/src/a.h", 10, 2, "fixed")));
+  ClangTidyError Other = makeError("misc-b", "/src/b.h", 30, "second");
+  Other.DiagLevel = ClangTidyError::Error;
+
+  std::vector<ClangTidyError> Errors;
+  std::string MainFilePath;
+  ASSERT_FALSE(parseResults(writeResults({Error, Other}), ResultsQuery(),
+                            Errors, &MainFilePath));
+  EXPECT_EQ("/src/main.cc", MainFilePath);
+  ASSERT_EQ(2u, Errors.size());
+  EXPECT_EQ("misc-a", Errors[0].DiagnosticName);
+  EXPECT_EQ(ClangTidyError::Warning, Errors[0].DiagLevel);
+  EXPECT_TRUE(Errors[0].IsWarningAsError);
+  EXPECT_EQ("/build", Errors[0].BuildDirectory);
+  EXPECT_EQ("first", Errors[0].Message.Message);
+  EXPECT_EQ("/src/a.h", Errors[0].Message.FilePath);
+  EXPECT_EQ(10u, Errors[0].Message.FileOffset);
+  ASSERT_EQ(1u, Errors[0].Notes.size());
+  EXPECT_EQ("note", Errors[0].Notes[0].Message);
+  EXPECT_EQ(20u, Errors[0].Notes[0].FileOffset);
+  ASSERT_EQ(1u, Errors[0].Fix.size());
+  ASSERT_EQ(1u, Errors[0].Fix["/src/a.h"].size());
+  EXPECT_EQ("fixed", Errors[0].Fix["/src/a.h"].begin()->getReplacementText());
+  EXPECT_EQ("misc-b", Errors[1].DiagnosticName);
+  EXPECT_EQ(ClangTidyError::Error, Errors[1].DiagLevel);
+}
+
+TEST(ResultsFileTest, SelectsByCheckAndPath) {
+  std::string Buffer = writeResults(
+      {makeError("misc-a", "/src/lib/a.h", 1, "1"),
+       makeError("misc-b", "/src/lib/b.h", 2, "2"),
+       makeError("misc-a", "/src/tools/c.h", 3, "3"),
+       makeError("google-c", "/src/lib/c.h", 4, "4")});
+
+  ResultsQuery Query;
+  Query.Checks = "-*,misc-*";
+  Query.PathPrefix = "/src/lib/";
+  std::vector<ClangTidyError> Errors;
+  ASSERT_FALSE(parseResults(Buffer, Query, Errors));
+  ASSERT_EQ(2u, Errors.size());
+  EXPECT_EQ("1", Errors[0].Message.Message);
+  EXPECT_EQ("2", Errors[1].Message.Message);
+
+  Errors.clear();
+  Query.Checks = "misc-a";
+  Query.PathPrefix = "";
+  ASSERT_FALSE(parseResults(Buffer, Query, Errors));
+  ASSERT_EQ(2u, Errors.size());
+  EXPECT_EQ("1", Errors[0].Message.Message);
+  EXPECT_EQ("3", Errors[1].Message.Message);
+}
+
+TEST(ResultsFileTest, SelectsWholePathComponents) {
+  std::string Buffer =
+      writeResults({makeError("misc-a", "/a/b/c.h", 1, "1"),
+                    makeError("misc-a", "/a/bc.h", 2, "2"),
+                    makeError("misc-a", "/a/b", 3, "3")});
+
+  ResultsQuery Query;
+  Query.PathPrefix = "/a/b";
+  std::vector<ClangTidyError> Errors;
+  ASSERT_FALSE(parseResults(Buffer, Query, Errors));
+  ASSERT_EQ(2u, Errors.size());
+  EXPECT_EQ("1", Errors[0].Message.Message);
+  EXPECT_EQ("3", Errors[1].Message.Message);
+
+  Errors.clear();
+  Query.PathPrefix = "/a/";
+  ASSERT_FALSE(parseResults(Buffer, Query, Errors));
+  EXPECT_EQ(3u, Errors.size());
+}
+
+TEST(ResultsFileTest, RejectsInvalidFiles) {
+  std::vector<ClangTidyError> Errors;
+  EXPECT_TRUE(!!parseResults("", ResultsQuery(), Errors));
+  EXPECT_TRUE(!!parseResults("not a results file", ResultsQuery(), Errors));
+  std::string Buffer = writeResults({makeError("misc-a", "/a.h", 1, "1")});
+  EXPECT_TRUE(!!parseResults(StringRef(Buffer).take_front(Buffer.size() / 2),
+                             ResultsQuery(), Errors));
+  EXPECT_TRUE(Errors.empty());
+}
+
+} // namespace test
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,99 @@
+#include "ScopedParentMap.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+
+namespace clang {
+namespace tidy {
+namespace test {
+
+using namespace ast_matchers;
+using ast_type_traits::DynTypedNode;
+
+static void expectSameParents(ASTContext &Context, ScopedParentMap &Map,
+                              const DynTypedNode &Node) {
+  ASTContext::DynTypedNodeList Actual = Map.getParents(Node);
+  ASTContext::DynTypedNodeList Expected = Context.getParents(Node);
+  ASSERT_EQ(Expected.size(), Actual.size());
+  for (const DynTypedNode &Parent : Actual)
+    EXPECT_NE(Expected.end(),
+              std::find(Expected.begin(), Expected.end(), Parent));
+}
+
+TEST(ScopedParentMapTest, MatchesASTContextParents) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCodeWithArgs(
+      "namespace n {\n"
+      "int f(int x) { return x ? f(x - 1) : (0); }\n"
+      "struct S { int m() { return f(1); } } s;\n"
+      "}\n"
+      "template <typename T> T t(T v) { return v + 1; }\n"
+      "template <typename T> struct C { T g() { return T(); } };\n"
+      "extern \"C\" { int h() { return t(1) + C<int>().g(); } }\n"
+      "auto l = [](int y) { return y * 2; };\n"
+      "int a[] = {1, 2, n::f(3)};\n",
+      {"-std=c++11"});
+  ASTContext &Context = AST->getASTContext();
+  ScopedParentMap Map(Context);
+
+  for (const BoundNodes &Nodes : match(stmt().bind("s"), Context))
+    expectSameParents(Context, Map,
+                      DynTypedNode::create(*Nodes.getNodeAs<Stmt>("s")));
+  for (const BoundNodes &Nodes : match(decl().bind("d"), Context))
+    expectSameParents(Context, Map,
+                      DynTypedNode::create(*Nodes.getNodeAs<Decl>("d")));
+}
+
+TEST(ScopedParentMapTest, MatchesParentsSharedAcrossRoots) {
+  // The explicit instantiation is a root of its own, but shares the
+  // non-dependent body of k() with the template.
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(
+      "template <typename T> struct E { int k() { return 1 + 2; } };\n"
+      "template struct E<int>;\n");
+  ASTContext &Context = AST->getASTContext();
+  ScopedParentMap Map(Context);
+
+  auto Matches = match(binaryOperator().bind("b"), Context);
+  ASSERT_FALSE(Matches.empty());
+  DynTypedNode Shared =
+      DynTypedNode::create(*Matches[0].getNodeAs<BinaryOperator>("b"));
+  // Look the shared node up after each root was made the current one.
+  for (const BoundNodes &Nodes : match(decl().bind("d"), Context)) {
+    expectSameParents(Context, Map,
+                      DynTypedNode::create(*Nodes.getNodeAs<Decl>("d")));
+    expectSameParents(Context, Map, Shared);
+  }
+  for (const BoundNodes &Nodes : match(stmt().bind("s"), Context))
+    expectSameParents(Context, Map,
+                      DynTypedNode::create(*Nodes.getNodeAs<Stmt>("s")));
+}
+
+TEST(ScopedParentMapTest, WalksUpToTranslationUnit) {
+  std::unique_ptr<ASTUnit> AST =
+      tooling::buildASTFromCode("namespace n { void f() { return; } }\n");
+  ASTContext &Context = AST->getASTContext();
+  ScopedParentMap Map(Context);
+
+  auto Matches = match(returnStmt().bind("r"), Context);
+  ASSERT_EQ(1u, Matches.size());
+  DynTypedNode Node =
+      DynTypedNode::create(*Matches[0].getNodeAs<ReturnStmt>("r"));
+  unsigned Depth = 0;
+  while (true) {
+    ASTContext::DynTypedNodeList Parents = Map.getParents(Node);
+    if (Parents.empty())
+      break;
+    ASSERT_EQ(1u, Parents.size());
+    Node = Parents[0];
+    ++Depth;
+  }
+  // CompoundStmt, FunctionDecl, NamespaceDecl, TranslationUnitDecl.
+  EXPECT_EQ(4u, Depth);
+  EXPECT_TRUE(Node.get<TranslationUnitDecl>());
+}
+
+} // namespace test
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,41 @@
+#include "SharedPreambles.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace tidy {
+namespace test {
+
+TEST(SharedPreamblesTest, FindsLeadingIncludes) {
+  std::vector<std::string> Includes = getLeadingIncludes(
+      "// File comment.\n"
+      "/* Block\n"
+      "   comment. */\n"
+      "\n"
+      "#include \"a.h\" // Trailing comment.\n"
+      "  #  include <b.h>\r\n"
+      "#include /* c */ <c/d.h>\n"
+      "int x;\n"
+      "#include \"e.h\"\n");
+  ASSERT_EQ(3u, Includes.size());
+  EXPECT_EQ("#include \"a.h\"", Includes[0]);
+  EXPECT_EQ("#include <b.h>", Includes[1]);
+  EXPECT_EQ("#include <c/d.h>", Includes[2]);
+}
+
+TEST(SharedPreamblesTest, StopsAtOtherDirectives) {
+  EXPECT_TRUE(getLeadingIncludes("#define A\n#include \"a.h\"\n").empty());
+  EXPECT_TRUE(getLeadingIncludes("#include_next <a.h>\n").empty());
+  EXPECT_TRUE(getLeadingIncludes("#import <a.h>\n").empty());
+  EXPECT_TRUE(getLeadingIncludes("#include MACRO\n").empty());
+  EXPECT_TRUE(getLeadingIncludes("#include \"a.h\" \\\n").empty());
+  EXPECT_TRUE(getLeadingIncludes("#include <a.h> int x;\n").empty());
+
+  std::vector<std::string> Includes =
+      getLeadingIncludes("#include <a.h>\n#if A\n#include <b.h>\n#endif\n");
+  ASSERT_EQ(1u, Includes.size());
+  EXPECT_EQ("#include <a.h>", Includes[0]);
+}
+
+} // namespace test
+} // namespace tidy
+} // namespace clang